@@ -52,6 +52,9 @@ typedef struct
 
 static PinsTypeDef Pins;
 
+// Target positions of the next coordinated move (axis parameter 53, started with user function 4)
+static int32_t coordinatedTarget[STEP_DIR_CHANNELS];
+
 // Translate motor number to TMC2041TypeDef
 // When using multiple ICs you can map them here
 static inline TMC2041TypeDef *motorToIC(uint8_t motor)
@@ -236,6 +239,20 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			StepDir_setFrequency(motor, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
+	case 53: // Target position for the next coordinated move
+		if(readWrite == READ) {
+			*value = coordinatedTarget[motor];
+		} else if(readWrite == WRITE) {
+			coordinatedTarget[motor] = *value;
+		}
+		break;
 	case 140:
 		// Microstep Resolution
 		if(readWrite == READ) {
@@ -440,7 +457,8 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 		}
 		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 
@@ -479,6 +497,13 @@ static uint32_t getLimit(AxisParameterLimit limit, uint8_t type, uint8_t motor,
 			*value = StepDir_getMaxAcceleration(motor);
 		}
 		break;
+	case 52:
+		if(limit == LIMIT_MIN) {
+			*value = 0;
+		} else if(limit == LIMIT_MAX) {
+			*value = STEPDIR_MAX_JERK_TIME;
+		}
+		break;
 	default:
 		errors |= TMC_ERROR_TYPE;
 		break;
@@ -557,6 +582,10 @@ static uint32_t userFunction(uint8_t type, uint8_t motor, int32_t *value)
 	case 3:  // Read StepDir status bits
 		*value = StepDir_getStatus(motor);
 		break;
+	case 4:  // Move both motors along a straight line to their targets from axis parameter 53
+		if(!StepDir_moveToSynchronized(coordinatedTarget))
+			errors |= TMC_ERROR_NOT_DONE;
+		break;
 	default:
 		errors |= TMC_ERROR_TYPE;
 		break;
@@ -586,6 +615,8 @@ static uint8_t reset()
 	StepDir_init();
 	StepDir_setPins(0, Pins.REFL1_STEP1, Pins.REFR1_DIR1, NULL);
 	StepDir_setPins(1, Pins.REFL2_STEP2, Pins.REFR2_DIR2, NULL);
+	coordinatedTarget[0] = 0;
+	coordinatedTarget[1] = 0;
 
 	return 1;
 }
@@ -628,12 +659,15 @@ void TMC2041_init(void)
 
 	TMC2041_SPIChannel = &HAL.SPI->ch2;
 	TMC2041_SPIChannel->CSN = Pins.CSN;
+	TMC2041_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	TMC2041_config = &TMCDriver.config;
 
 	StepDir_init();
 	StepDir_setPins(0, Pins.REFL1_STEP1, Pins.REFR1_DIR1, NULL);
 	StepDir_setPins(1, Pins.REFL2_STEP2, Pins.REFR2_DIR2, NULL);
+	coordinatedTarget[0] = 0;
+	coordinatedTarget[1] = 0;
 
 	Evalboards.ch2.config->reset        = reset;
 	Evalboards.ch2.config->restore      = restore;
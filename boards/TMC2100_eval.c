@@ -233,6 +233,13 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			StepDir_setFrequency(motor, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
 
 	case 140:
 		// Microstep Resolution
@@ -258,7 +265,8 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 		}
 		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 	return errors;
@@ -547,7 +555,7 @@ void TMC2100_init(void)
 #if defined(Startrampe)
 	Pins.AIN_REF_PWM->configuration.GPIO_Mode = GPIO_Mode_AF;
 	GPIO_PinAFConfig(Pins.AIN_REF_PWM->port, Pins.AIN_REF_PWM->bit, GPIO_AF_TIM1);
-#elif defined(Landungsbruecke)
+#elif defined(Landungsbruecke) || defined(Host)
 	HAL.IOs->config->toOutput(Pins.AIN_REF_PWM);
 	Pins.AIN_REF_PWM->configuration.GPIO_Mode = GPIO_Mode_AF4;
 #endif
@@ -300,6 +300,13 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			StepDir_setFrequency(motor, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
 	case 140:
 		// Microstep Resolution
 		if(readWrite == READ) {
@@ -590,8 +597,74 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			errors |= TMC_ERROR_TYPE;
 		}
 		break;
+	case 209:
+		// Encoder position [steps]
+		if(readWrite == READ) {
+			*value = StepDir_getEncoderPosition(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setEncoderPosition(motor, *value);
+		}
+		break;
+	case 210:
+		// Encoder resolution: Steps per encoder count, 16.16 fixed point
+		if(readWrite == READ) {
+			*value = StepDir_getEncoderFactor(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setEncoderFactor(motor, *value);
+		}
+		break;
+	case 211:
+		// Encoder feedback: Quadrature encoder on DIO12 (ENCA_DCIN_CFG5) (A) and DIO13 (ENCB_DCEN_CFG4) (B)
+		if(readWrite == READ) {
+			*value = StepDir_getEncoderEnabled(motor);
+		} else if(readWrite == WRITE) {
+			if(*value) {
+				HAL.IOs->config->toInput(&HAL.IOs->pins->DIO12);
+				HAL.IOs->config->toInput(&HAL.IOs->pins->DIO13);
+				StepDir_setEncoderPins(motor, &HAL.IOs->pins->DIO12, &HAL.IOs->pins->DIO13);
+			} else {
+				StepDir_setEncoderPins(motor, NULL, NULL);
+				HAL.IOs->config->toOutput(&HAL.IOs->pins->DIO12);
+				HAL.IOs->config->toOutput(&HAL.IOs->pins->DIO13);
+				HAL.IOs->config->setLow(&HAL.IOs->pins->DIO12);
+			}
+		}
+		break;
+	case 212:
+		// Maximum encoder deviation [steps], 0: off. Writing clears a deviation stop
+		if(readWrite == READ) {
+			*value = StepDir_getMaxDeviation(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setMaxDeviation(motor, *value);
+		}
+		break;
+	case 213:
+		// Encoder deviation: Actual position - encoder position [steps]
+		if(readWrite == READ) {
+			*value = StepDir_getDeviation(motor);
+		} else if(readWrite == WRITE) {
+			errors |= TMC_ERROR_TYPE;
+		}
+		break;
+	case 214:
+		// Encoder deviation correction: 0: stop, 1: continue from the encoder position
+		if(readWrite == READ) {
+			*value = StepDir_getDeviationCorrection(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setDeviationCorrection(motor, *value);
+		}
+		break;
+	case 215:
+		// Encoder deviation corrections
+		if(readWrite == READ) {
+			*value = StepDir_getDeviationCorrections(motor);
+		} else if(readWrite == WRITE) {
+			errors |= TMC_ERROR_TYPE;
+		}
+		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 	return errors;
@@ -629,6 +702,13 @@ static uint32_t getLimit(AxisParameterLimit limit, uint8_t type, uint8_t motor,
 			*value = StepDir_getMaxAcceleration(motor);
 		}
 		break;
+	case 52:
+		if(limit == LIMIT_MIN) {
+			*value = 0;
+		} else if(limit == LIMIT_MAX) {
+			*value = STEPDIR_MAX_JERK_TIME;
+		}
+		break;
 	default:
 		errors |= TMC_ERROR_TYPE;
 		break;
@@ -860,6 +940,7 @@ void TMC2130_init(void)
 
 	TMC2130_SPIChannel       = &HAL.SPI->ch2;
 	TMC2130_SPIChannel->CSN  = &HAL.IOs->pins->SPI2_CSN0;
+	TMC2130_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	StepDir_init();
 	StepDir_setPins(0, Pins.REFL_STEP, Pins.REFR_DIR, NULL);
@@ -895,7 +976,7 @@ void TMC2130_init(void)
 #if defined(Startrampe)
 	Pins.AIN_REF_PWM->configuration.GPIO_Mode = GPIO_Mode_AF;
 	GPIO_PinAFConfig(Pins.AIN_REF_PWM->port, Pins.AIN_REF_PWM->bit, GPIO_AF_TIM1);
-#elif defined(Landungsbruecke)
+#elif defined(Landungsbruecke) || defined(Host)
 	HAL.IOs->config->toOutput(Pins.AIN_REF_PWM);
 	Pins.AIN_REF_PWM->configuration.GPIO_Mode = GPIO_Mode_AF4;
 #endif
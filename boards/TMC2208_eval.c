@@ -180,8 +180,16 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			tmc2208_set_slave(&TMC2208, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 
@@ -267,6 +275,8 @@ static void periodicJob(uint32_t tick)
 		tmc2208_periodicJob(&TMC2208, tick);
 		StepDir_periodicJob(motor);
 	}
+
+	UART_process(TMC2208_UARTChannel); // Timeout of pending UART transactions
 }
 
 void TMC2208_init(void)
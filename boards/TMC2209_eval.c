@@ -12,9 +12,16 @@
 #define VM_MIN  50   // VM[V/10] min
 #define VM_MAX  390  // VM[V/10] max
 
-#define MOTORS 1
+// Up to four TMC2209 share the UART, distinguished by their slave address (AD0/AD1 pins).
+// Motor 0 is the chip on the eval board and the only one with Step/Dir, the other motors
+// run with the internal pulse generator (VACTUAL).
+#define MOTORS 4
 
 #define TIMEOUT_VALUE 10 // 10 ms
+#define POLL_MAX_AGE  10 // [ms] Polled status values younger than this answer register reads
+
+// Status registers read in turn from all slaves by the periodic job
+static const uint8_t pollRegisters[] = { TMC2209_DRVSTATUS, TMC2209_SG_RESULT };
 
 static uint32_t right(uint8_t motor, int32_t velocity);
 static uint32_t left(uint8_t motor, int32_t velocity);
@@ -35,9 +42,28 @@ static void periodicJob(uint32_t tick);
 static uint8_t reset(void);
 static void enableDriver(DriverState state);
 
+static void pollNext(uint32_t tick);
+static void pollCallback(UART_Transaction *transaction);
+static bool readPolled(uint8_t motor, uint8_t address, int32_t *value);
+
 static UART_Config *TMC2209_UARTChannel;
-static TMC2209TypeDef TMC2209;
+static TMC2209TypeDef TMC2209[MOTORS];
 static ConfigurationTypeDef *TMC2209_config;
+static ConfigurationTypeDef TMC2209_slaveConfig[MOTORS-1]; // Shadow registers of motors 1-3, motor 0 uses the channel config
+
+typedef struct
+{
+	int32_t drvStatus;
+	int32_t sgResult;
+	uint32_t drvStatusTick;  // Systick of the last successful poll, 0: none yet
+	uint32_t sgResultTick;
+	uint32_t errors;         // Failed polls in a row
+} PollStateTypeDef;
+
+static PollStateTypeDef pollState[MOTORS];
+static uint8_t pollIndex = 0;         // Position in the motor x register schedule
+static volatile bool pollBusy = false;
+static uint32_t pollTick = 0;
 
 static uint32_t pin_states = 0;
 static bool pin_configurator = false;
@@ -63,23 +89,28 @@ static PinsTypeDef Pins;
 
 static uint8_t restore(void);
 
+// The motor number is the channel the API instances got initialised with
 void tmc2209_writeRegister(uint8_t motor, uint8_t address, int32_t value)
 {
-	UNUSED(motor);
-	UART_writeInt(TMC2209_UARTChannel, tmc2209_get_slave(&TMC2209), address, value);
-	TMC2209.config->shadowRegister[TMC_ADDRESS(address)] = value;
+	if(motor >= MOTORS)
+		return;
+
+	UART_writeInt(TMC2209_UARTChannel, tmc2209_get_slave(&TMC2209[motor]), address, value);
+	TMC2209[motor].config->shadowRegister[TMC_ADDRESS(address)] = value;
 }
 
 void tmc2209_readRegister(uint8_t motor, uint8_t address, int32_t *value)
 {
-	UNUSED(motor);
 	if(pin_configurator && address == 0) // Detect old Rhino setPins datagram
 		*value = setPins(*value);
-	else {
-		if(TMC_IS_READABLE(TMC2209.registerAccess[TMC_ADDRESS(address)]))
-			UART_readInt(TMC2209_UARTChannel, tmc2209_get_slave(&TMC2209), address, value);
+	else if(motor < MOTORS) {
+		if(readPolled(motor, TMC_ADDRESS(address), value))
+			return;
+
+		if(TMC_IS_READABLE(TMC2209[motor].registerAccess[TMC_ADDRESS(address)]))
+			UART_readInt(TMC2209_UARTChannel, tmc2209_get_slave(&TMC2209[motor]), address, value);
 		else
-			*value = TMC2209.config->shadowRegister[TMC_ADDRESS(address)];
+			*value = TMC2209[motor].config->shadowRegister[TMC_ADDRESS(address)];
 	}
 }
 
@@ -88,7 +119,10 @@ static uint32_t rotate(uint8_t motor, int32_t velocity)
 	if(motor >= MOTORS)
 		return TMC_ERROR_MOTOR;
 
-	StepDir_rotate(motor, velocity);
+	if(motor == 0)
+		StepDir_rotate(motor, velocity);
+	else // No Step/Dir connection - use the internal pulse generator
+		tmc2209_writeRegister(motor, TMC2209_VACTUAL, velocity);
 
 	return TMC_ERROR_NONE;
 }
@@ -110,7 +144,7 @@ static uint32_t stop(uint8_t motor)
 
 static uint32_t moveTo(uint8_t motor, int32_t position)
 {
-	if(motor >= MOTORS)
+	if(motor != 0) // Positioning needs the Step/Dir generator
 		return TMC_ERROR_MOTOR;
 
 	StepDir_moveTo(motor, position);
@@ -120,7 +154,7 @@ static uint32_t moveTo(uint8_t motor, int32_t position)
 
 static uint32_t moveBy(uint8_t motor, int32_t *ticks)
 {
-	if(motor >= MOTORS)
+	if(motor != 0) // Positioning needs the Step/Dir generator
 		return TMC_ERROR_MOTOR;
 
 	// determine actual position and add numbers of ticks to move
@@ -137,6 +171,10 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 	if(motor >= MOTORS)
 		return TMC_ERROR_MOTOR;
 
+	// Motors without Step/Dir only support the velocity, slave address and polled status parameters
+	if(motor != 0 && type != 2 && type != 6 && type != 7 && type != 8 && type != 9)
+		return TMC_ERROR_MOTOR;
+
 	switch(type)
 	{
 	case 0:
@@ -158,9 +196,12 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 	case 2:
 		// Target speed
 		if(readWrite == READ) {
-			*value = StepDir_getTargetVelocity(motor);
+			if(motor == 0)
+				*value = StepDir_getTargetVelocity(motor);
+			else // VACTUAL is a signed 24 bit value
+				*value = (TMC2209[motor].config->shadowRegister[TMC2209_VACTUAL] << 8) >> 8;
 		} else if(readWrite == WRITE) {
-			StepDir_rotate(motor, *value);
+			rotate(motor, *value);
 		}
 		break;
 	case 3:
@@ -190,13 +231,45 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 	case 6:
 		// UART slave address
 		if(readWrite == READ) {
-			*value = tmc2209_get_slave(&TMC2209);
+			*value = tmc2209_get_slave(&TMC2209[motor]);
 		} else if(readWrite == WRITE) {
-			tmc2209_set_slave(&TMC2209, *value);
+			tmc2209_set_slave(&TMC2209[motor], *value);
+		}
+		break;
+	case 7:
+		// Driver status (last polled value)
+		if(readWrite == READ) {
+			*value = pollState[motor].drvStatus;
+		} else if(readWrite == WRITE) {
+			errors |= TMC_ERROR_TYPE;
+		}
+		break;
+	case 8:
+		// StallGuard result (last polled value)
+		if(readWrite == READ) {
+			*value = pollState[motor].sgResult;
+		} else if(readWrite == WRITE) {
+			errors |= TMC_ERROR_TYPE;
+		}
+		break;
+	case 9:
+		// Failed status polls in a row, 0: last poll answered
+		if(readWrite == READ) {
+			*value = pollState[motor].errors;
+		} else if(readWrite == WRITE) {
+			errors |= TMC_ERROR_TYPE;
+		}
+		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
 		}
 		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 
@@ -280,10 +353,14 @@ static uint32_t userFunction(uint8_t type, uint8_t motor, int32_t *value)
 		*value = StepDir_getStatus(motor);
 		break;
 	case 1:
-		tmc2209_set_slave(&TMC2209, (*value) & 0xFF);
+		if(motor >= MOTORS)
+			return TMC_ERROR_MOTOR;
+		tmc2209_set_slave(&TMC2209[motor], (*value) & 0xFF);
 		break;
 	case 2:
-		*value = tmc2209_get_slave(&TMC2209);
+		if(motor >= MOTORS)
+			return TMC_ERROR_MOTOR;
+		*value = tmc2209_get_slave(&TMC2209[motor]);
 		break;
 	case 3:
 		pin_configurator = (*value == 1);
@@ -368,15 +445,25 @@ static void deInit(void)
 
 static uint8_t reset()
 {
+	uint8_t result = 1;
+
 	StepDir_init();
 	StepDir_setPins(0, Pins.STEP, Pins.DIR, NULL);
 
-	return tmc2209_reset(&TMC2209);
+	for(uint8_t motor = 0; motor < MOTORS; motor++)
+		result &= tmc2209_reset(&TMC2209[motor]);
+
+	return result;
 }
 
 static uint8_t restore()
 {
-	return tmc2209_restore(&TMC2209);
+	uint8_t result = 1;
+
+	for(uint8_t motor = 0; motor < MOTORS; motor++)
+		result &= tmc2209_restore(&TMC2209[motor]);
+
+	return result;
 }
 
 static void enableDriver(DriverState state)
@@ -390,13 +477,84 @@ static void enableDriver(DriverState state)
 		HAL.IOs->config->setLow(Pins.ENN);
 }
 
-static void periodicJob(uint32_t tick)
+static void pollCallback(UART_Transaction *transaction)
 {
-	for(int motor = 0; motor < MOTORS; motor++)
+	PollStateTypeDef *state = transaction->user;
+
+	if(transaction->state == UART_TRANSACTION_DONE)
+	{
+		if(transaction->address == TMC2209_DRVSTATUS)
+		{
+			state->drvStatus      = transaction->value;
+			state->drvStatusTick  = systick_getTick();
+		}
+		else
+		{
+			state->sgResult      = transaction->value;
+			state->sgResultTick  = systick_getTick();
+		}
+
+		state->errors = 0;
+	}
+	else if(transaction->state != UART_TRANSACTION_CANCELLED) // Cleared queue is no bus error
+	{
+		state->errors++;
+	}
+
+	pollBusy = false;
+}
+
+// Register reads of the polled status registers don't need to wait for their own datagram
+// as long as the periodic job keeps the values fresh.
+static bool readPolled(uint8_t motor, uint8_t address, int32_t *value)
+{
+	PollStateTypeDef *state = &pollState[motor];
+
+	if(address == TMC2209_DRVSTATUS && state->drvStatusTick && timeSince(state->drvStatusTick) <= POLL_MAX_AGE)
+	{
+		*value = state->drvStatus;
+		return true;
+	}
+
+	if(address == TMC2209_SG_RESULT && state->sgResultTick && timeSince(state->sgResultTick) <= POLL_MAX_AGE)
 	{
-		tmc2209_periodicJob(&TMC2209, tick);
-		StepDir_periodicJob(motor);
+		*value = state->sgResult;
+		return true;
 	}
+
+	return false;
+}
+
+// Round-robin status polling: one datagram per tick, all registers of one motor before the next motor.
+// Register accesses from TMCL get queued in between the polls.
+static void pollNext(uint32_t tick)
+{
+	if(pollBusy || tick == pollTick)
+		return;
+
+	uint8_t motor = pollIndex / ARRAY_SIZE(pollRegisters);
+	uint8_t address = pollRegisters[pollIndex % ARRAY_SIZE(pollRegisters)];
+
+	pollBusy = true;
+	if(!UART_readIntAsync(TMC2209_UARTChannel, tmc2209_get_slave(&TMC2209[motor]), address, pollCallback, &pollState[motor]))
+	{
+		pollBusy = false;
+		return;
+	}
+
+	pollTick = tick;
+	pollIndex = (pollIndex + 1) % (MOTORS * ARRAY_SIZE(pollRegisters));
+}
+
+static void periodicJob(uint32_t tick)
+{
+	for(int motor = 0; motor < MOTORS; motor++)
+		tmc2209_periodicJob(&TMC2209[motor], tick);
+
+	StepDir_periodicJob(0);
+
+	pollNext(tick);
+	UART_process(TMC2209_UARTChannel); // Timeout of pending UART transactions
 }
 
 void TMC2209_init(void)
@@ -456,7 +614,19 @@ void TMC2209_init(void)
 	Evalboards.ch2.deInit               = deInit;
 	Evalboards.ch2.periodicJob          = periodicJob;
 
-	tmc2209_init(&TMC2209, 0, TMC2209_config, &tmc2209_defaultRegisterResetState[0]);
+	for(uint8_t motor = 0; motor < MOTORS; motor++)
+	{
+		tmc2209_init(&TMC2209[motor], motor, (motor == 0) ? TMC2209_config : &TMC2209_slaveConfig[motor-1], &tmc2209_defaultRegisterResetState[0]);
+		tmc2209_set_slave(&TMC2209[motor], motor);
+
+		pollState[motor].drvStatus  = 0;
+		pollState[motor].sgResult       = 0;
+		pollState[motor].drvStatusTick  = 0;
+		pollState[motor].sgResultTick   = 0;
+		pollState[motor].errors         = 0;
+	}
+	pollIndex  = 0;
+	pollBusy   = false;
 
 	StepDir_init();
 	StepDir_setPins(0, Pins.STEP, Pins.DIR, NULL);
@@ -466,7 +636,7 @@ void TMC2209_init(void)
 #if defined(Startrampe)
 	Pins.UC_PWM->configuration.GPIO_Mode = GPIO_Mode_AF;
 	GPIO_PinAFConfig(Pins.UC_PWM->port, Pins.UC_PWM->bit, GPIO_AF_TIM1);
-#elif defined(Landungsbruecke)
+#elif defined(Landungsbruecke) || defined(Host)
 	HAL.IOs->config->toOutput(Pins.UC_PWM);
 	Pins.UC_PWM->configuration.GPIO_Mode = GPIO_Mode_AF4;
 #endif
@@ -177,8 +177,16 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			tmc2224_set_slave(&TMC2224, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 
@@ -265,6 +273,8 @@ static void periodicJob(uint32_t tick)
 		tmc2224_periodicJob(motor, tick, &TMC2224, TMC2224_config);
 		StepDir_periodicJob(motor);
 	}
+
+	UART_process(TMC2224_UARTChannel); // Timeout of pending UART transactions
 }
 
 void TMC2224_init(void)
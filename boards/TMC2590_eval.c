@@ -378,6 +378,13 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			StepDir_setFrequency(motor, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
 	case 140:
 		// Microstep Resolution
 		if(readWrite == READ) {
@@ -643,7 +650,8 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 		}
 		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 	return errors;
@@ -681,6 +689,13 @@ static uint32_t getLimit(AxisParameterLimit limit, uint8_t type, uint8_t motor,
 			*value = StepDir_getMaxAcceleration(motor);
 		}
 		break;
+	case 52:
+		if(limit == LIMIT_MIN) {
+			*value = 0;
+		} else if(limit == LIMIT_MAX) {
+			*value = STEPDIR_MAX_JERK_TIME;
+		}
+		break;
 	default:
 		errors |= TMC_ERROR_TYPE;
 		break;
@@ -833,6 +848,7 @@ void TMC2590_init(void)
 
 	TMC2590_SPIChannel = &HAL.SPI->ch2;
 	TMC2590_SPIChannel->CSN = Pins.CSN;
+	TMC2590_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	TMC2590.standStillCurrentScale  = I_STAND_STILL;
 	TMC2590.standStillTimeout       = T_STAND_STILL;
@@ -352,6 +352,13 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 			StepDir_setFrequency(motor, *value);
 		}
 		break;
+	case 52: // StepDir S-curve jerk time [interrupt ticks], 0: linear ramp
+		if(readWrite == READ) {
+			*value = StepDir_getJerkTime(motor);
+		} else if(readWrite == WRITE) {
+			StepDir_setJerkTime(motor, *value);
+		}
+		break;
 	case 140:
 		// Microstep Resolution
 		if(readWrite == READ) {
@@ -617,7 +624,8 @@ static uint32_t handleParameter(uint8_t readWrite, uint8_t motor, uint8_t type,
 		}
 		break;
 	default:
-		errors |= TMC_ERROR_TYPE;
+		// 54-58: StepDir position compare
+		errors |= StepDir_handleCompareParameter(type, motor, value, readWrite);
 		break;
 	}
 	return errors;
@@ -774,6 +782,7 @@ void TMC2660_init(void)
 
 	TMC2660_SPIChannel = &HAL.SPI->ch2;
 	TMC2660_SPIChannel->CSN = Pins.CSN;
+	TMC2660_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	TMC2660.standStillCurrentScale  = I_STAND_STILL;
 	TMC2660.standStillTimeout       = T_STAND_STILL;
@@ -775,6 +775,7 @@ void TMC4330_init(void)
 
 	TMC4330_SPIChannel = &HAL.SPI->ch1;
 	TMC4330_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC4330_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch1.config->state        = CONFIG_RESET;
 	Evalboards.ch1.config->configIndex  = 0;
@@ -636,6 +636,7 @@ void TMC4331_init(void)
 
 	TMC4331_SPIChannel = &HAL.SPI->ch1;
 	TMC4331_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC4331_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch1.config->state        = CONFIG_RESET;
 	Evalboards.ch1.config->configIndex  = 0;
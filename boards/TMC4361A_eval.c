@@ -902,6 +902,7 @@ void TMC4361A_init(void)
 
 	TMC4361A_SPIChannel = &HAL.SPI->ch1;
 	TMC4361A_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC4361A_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch1.config->state        = CONFIG_RESET;
 	Evalboards.ch1.config->configIndex  = 0;
@@ -897,6 +897,7 @@ void TMC4361_init(void)
 
 	TMC4361_SPIChannel = &HAL.SPI->ch1;
 	TMC4361_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC4361_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch1.config->state        = CONFIG_RESET;
 	Evalboards.ch1.config->configIndex  = 0;
@@ -1231,6 +1231,7 @@ void TMC4670_init(void)
 
 	TMC4670_SPIChannel = &HAL.SPI->ch1;
 	TMC4670_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC4670_SPIChannel->setFrequency(8000000); // maximum SCK frequency
 
 	TMC4670_config = Evalboards.ch1.config;
 
@@ -524,6 +524,7 @@ void TMC4671_init(void)
 
 	TMC4671_SPIChannel = &HAL.SPI->ch1;
 	TMC4671_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC4671_SPIChannel->setFrequency(8000000); // maximum SCK frequency
 
 	TMC4671_config = Evalboards.ch1.config;
 
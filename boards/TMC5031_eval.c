@@ -819,6 +819,7 @@ void TMC5031_init(void)
 
 	TMC5031_SPIChannel = &HAL.SPI->ch1;
 	TMC5031_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC5031_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	TMC5031_config = Evalboards.ch1.config;
 
@@ -759,6 +759,7 @@ void TMC5041_init(void)
 
 	TMC5041_SPIChannel = &HAL.SPI->ch1;
 	TMC5041_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC5041_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	TMC5041_config = Evalboards.ch1.config;
 
@@ -821,6 +821,7 @@ void TMC5062_init(void)
 
 	TMC5062_SPIChannel = &HAL.SPI->ch1;
 	TMC5062_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC5062_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	TMC5062_MicroStepTable microStepTable;
 	microStepTable.LUT_0  = 0xAAAAB554;
@@ -771,6 +771,7 @@ void TMC5072_init(void)
 
 	TMC5072_SPIChannel = &HAL.SPI->ch1;
 	TMC5072_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC5072_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch1.config->reset        = reset;
 	Evalboards.ch1.config->restore      = restore;
@@ -10,8 +10,6 @@
 
 #define DEFAULT_MOTOR  0
 
-#define TMC5160_TIMEOUT 50 // UART Timeout in ms
-
 static bool vMaxModified = false;
 //static uint32_t vMax		   = 1;
 
@@ -153,26 +151,9 @@ static void writeDatagram_uart(uint8_t motor, uint8_t address, uint8_t x1, uint8
 
 	address = TMC_ADDRESS(address);
 	UNUSED(motor);
-	uint8_t writeData[8];
-
-	writeData[0] = 0x05;                         // Sync byte
-	writeData[1] = 0x00;                         // Slave address
-	writeData[2] = address | TMC5160_WRITE_BIT;  // Register address with write bit set
-	writeData[3] = x1;                           // Register Data
-	writeData[4] = x2;                           // Register Data
-	writeData[5] = x3;                           // Register Data
-	writeData[6] = x4;                           // Register Data
-	writeData[7] = tmc_CRC8(writeData, 7, 1);    // Cyclic redundancy check
-
-	TMC5160_UARTChannel->rxtx.clearBuffers();
-	for(uint32_t i = 0; i < ARRAY_SIZE(writeData); i++)
-		TMC5160_UARTChannel->rxtx.tx(writeData[i]);
-
-	/* Workaround: Give the UART time to send. Otherwise another write/readRegister can do clearBuffers()
-	 * before we're done. This currently is an issue with the IDE when using the Register browser and the
-	 * periodic refresh of values gets requested right after the write request.
-	 */
-	wait(2);
+
+	// Only queued - the UART sends the datagram in the background
+	UART_writeInt(TMC5160_UARTChannel, 0x00, address, _8_32(x1, x2, x3, x4));
 
 	TMC5160_config->shadowRegister[address] = _8_32(x1, x2, x3, x4);
 }
@@ -181,35 +162,17 @@ static int32_t readInt_uart(uint8_t motor, uint8_t address)
 {
 	UNUSED(motor);
 	address = TMC_ADDRESS(address);
-	uint8_t readData[8], dataRequest[4];
-	uint32_t timeout;
+	int32_t value = -1; // Returned on timeout or transmission errors
 
 	if(!TMC_IS_READABLE(TMC5160.registerAccess[address]))
 	{	// Register not readable - shadowRegister copy
 		return TMC5160_config->shadowRegister[address];
 	}
 
-	dataRequest[0] = 0x05;                         // Sync byte
-	dataRequest[1] = 0x00;                         // Slave address
-	dataRequest[2] = address;                      // Register address
-	dataRequest[3] = tmc_CRC8(dataRequest, 3, 1);  // Cyclic redundancy check
-
-	TMC5160_UARTChannel->rxtx.clearBuffers();
-	TMC5160_UARTChannel->rxtx.txN(dataRequest, ARRAY_SIZE(dataRequest));
-
-	// Wait for reply with timeout limit
-	timeout = systick_getTick();
-	while(TMC5160_UARTChannel->rxtx.bytesAvailable() < ARRAY_SIZE(readData))
-		if(timeSince(timeout) > TMC5160_TIMEOUT) // Timeout
-			return -1;
+	// Waits for this reply only, queued writes in front of it are sent back to back
+	UART_readInt(TMC5160_UARTChannel, 0x00, address, &value);
 
-	TMC5160_UARTChannel->rxtx.rxN(readData, ARRAY_SIZE(readData));
-	// Check if the received data is correct (CRC, Sync, Slave address, Register address)
-	// todo CHECK 2: Only keep CRC check? Should be sufficient for wrong transmissions (LH) #1
-	if(readData[7] != tmc_CRC8(readData, 7, 1) || readData[0] != 0x05 || readData[1] != 0xFF || readData[2] != address)
-		return -1;
-
-	return _8_32(readData[3], readData[4], readData[5], readData[6]);
+	return value;
 }
 
 typedef struct
@@ -890,6 +853,9 @@ static void periodicJob(uint32_t tick)
 	{
 		tmc5160_periodicJob(motor, tick, &TMC5160, TMC5160_config);
 	}
+
+	if(uart_mode)
+		UART_process(TMC5160_UARTChannel); // Timeout of pending UART transactions
 }
 
 static void checkErrors(uint32_t tick)
@@ -1103,6 +1069,7 @@ static void init_comm(TMC_Board_Comm_Mode mode)
 			TMC5160_UARTChannel->rxtx.deInit();
 		TMC5160_SPIChannel = &HAL.SPI->ch1;
 		TMC5160_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+		TMC5160_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 		old = TMC_COMM_SPI;
 		break;
 	}
@@ -940,6 +940,7 @@ void TMC5161_init(void)
 
 	TMC5161_SPIChannel = &HAL.SPI->ch1;
 	TMC5161_SPIChannel->CSN = &HAL.IOs->pins->SPI1_CSN;
+	TMC5161_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch1.config->reset        = reset;
 	Evalboards.ch1.config->restore      = restore;
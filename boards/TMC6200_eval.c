@@ -195,6 +195,7 @@ void TMC6200_init(void)
 {
 	TMC6200_SPIChannel = &HAL.SPI->ch2;
 	TMC6200_SPIChannel->CSN = &HAL.IOs->pins->SPI2_CSN0;
+	TMC6200_SPIChannel->setFrequency(4000000); // maximum SCK frequency with internal clock
 
 	Evalboards.ch2.config->reset        = reset;
 	Evalboards.ch2.config->restore      = restore;
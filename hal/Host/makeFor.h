@@ -0,0 +1,3 @@
+#ifndef Host
+	#define Host
+#endif
@@ -0,0 +1,230 @@
+/*
+ * HostSim.c
+ *
+ * Simulated GPIO ports, SPI chips and interrupt sources for the host build.
+ * See HostSim.h for an overview.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "HostSim.h"
+
+#define HOST_IRQ_PERIODIC_SOURCES  4
+#define HOST_IRQ_RECEIVERS         4
+
+#define HOST_IRQ_SLEEP_NS       100000  // Wakeup interval of the periodic interrupt threads
+#define HOST_IRQ_MAX_CATCHUP    100     // Catch up at most 1/100 s worth of ticks at once
+#define HOST_IDLE_NS            50000
+
+HostGPIO_Type HostGPIO[HOST_GPIO_PORTS];
+HostSPI_Type HostSPI[HOST_SPI_BUSSES];
+
+// Global interrupt lock - recursive, since Disable/EnableInterrupts pairs may nest
+static pthread_mutex_t irqLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+typedef struct
+{
+	void (*handler)(void);
+	uint32_t frequency;
+	volatile bool running;
+	pthread_t thread;
+} PeriodicIRQTypeDef;
+
+typedef struct
+{
+	int (*reader)(uint8_t *buffer, int size);
+	void (*handler)(uint8_t data);
+	pthread_t thread;
+} ReceiverIRQTypeDef;
+
+static PeriodicIRQTypeDef periodic[HOST_IRQ_PERIODIC_SOURCES];
+static ReceiverIRQTypeDef receivers[HOST_IRQ_RECEIVERS];
+static uint8_t receiverCount = 0;
+
+// ===== GPIO =====
+
+void host_gpio_update(HostGPIO_MemMapPtr port)
+{
+	// Outputs read back their own level, inputs read their pull resistor level
+	port->PDIR = (port->PDOR & port->PDDR) | (port->PUE & ~port->PDDR);
+}
+
+// ===== SPI =====
+
+uint8_t host_spi_transfer(HostSPI_MemMapPtr spi, uint8_t data, uint8_t lastTransfer)
+{
+	uint8_t reply = 0;
+
+	if(spi->position < HOST_SPI_DATAGRAM_SIZE)
+	{
+		reply = spi->reply[spi->position];
+		spi->frame[spi->position] = data;
+	}
+	spi->position++;
+
+	if(!lastTransfer)
+		return reply;
+
+	// Chip select went high - evaluate the datagram. Other datagram lengths are ignored.
+	if(spi->position == HOST_SPI_DATAGRAM_SIZE)
+	{
+		uint8_t address = spi->frame[0] & 0x7F;
+
+		if(spi->frame[0] & 0x80)
+		{
+			spi->registers[address] = ((uint32_t) spi->frame[1] << 24)
+			                        | ((uint32_t) spi->frame[2] << 16)
+			                        | ((uint32_t) spi->frame[3] << 8)
+			                        |  (uint32_t) spi->frame[4];
+		}
+
+		// The addressed register gets shifted out with the next datagram
+		int32_t value = spi->registers[address];
+		spi->reply[0] = spi->status;
+		spi->reply[1] = (value >> 24) & 0xFF;
+		spi->reply[2] = (value >> 16) & 0xFF;
+		spi->reply[3] = (value >> 8) & 0xFF;
+		spi->reply[4] = value & 0xFF;
+
+		spi->datagrams++;
+	}
+	spi->position = 0;
+
+	return reply;
+}
+
+// ===== Interrupts =====
+
+void host_irq_disable(void)
+{
+	pthread_mutex_lock(&irqLock);
+}
+
+void host_irq_enable(void)
+{
+	pthread_mutex_unlock(&irqLock);
+}
+
+uint64_t host_getTimeNs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void host_idle(void)
+{
+	struct timespec idle = { 0, HOST_IDLE_NS };
+	nanosleep(&idle, NULL);
+}
+
+static void *periodicThread(void *arg)
+{
+	PeriodicIRQTypeDef *irq = arg;
+	struct timespec sleep = { 0, HOST_IRQ_SLEEP_NS };
+	uint64_t start = host_getTimeNs();
+	uint64_t ticks = 0;
+	uint64_t maxCatchUp = irq->frequency / HOST_IRQ_MAX_CATCHUP + 1;
+
+	while(irq->running)
+	{
+		uint64_t elapsed = host_getTimeNs() - start;
+		uint64_t due = (elapsed / 1000000000ULL) * irq->frequency
+		             + ((elapsed % 1000000000ULL) * irq->frequency) / 1000000000ULL;
+
+		// Don't try to catch up with long scheduler stalls (e.g. a debugger break)
+		if(due - ticks > maxCatchUp)
+			ticks = due - maxCatchUp;
+
+		host_irq_disable();
+		for(; ticks < due; ticks++)
+			irq->handler();
+		host_irq_enable();
+
+		nanosleep(&sleep, NULL);
+	}
+
+	return NULL;
+}
+
+void host_irq_startPeriodic(void (*handler)(void), uint32_t frequency)
+{
+	PeriodicIRQTypeDef *irq = NULL;
+
+	for(uint8_t i = 0; i < HOST_IRQ_PERIODIC_SOURCES; i++)
+	{
+		if(periodic[i].running && periodic[i].handler == handler)
+			return; // Already running
+
+		if(!periodic[i].running && !irq)
+			irq = &periodic[i];
+	}
+
+	if(!irq || frequency == 0)
+		return;
+
+	irq->handler    = handler;
+	irq->frequency  = frequency;
+	irq->running    = true;
+
+	if(pthread_create(&irq->thread, NULL, periodicThread, irq) != 0)
+	{
+		perror("host_irq_startPeriodic");
+		irq->running = false;
+	}
+}
+
+// Must not be called with interrupts disabled - the interrupt thread could not finish otherwise
+void host_irq_stopPeriodic(void (*handler)(void))
+{
+	for(uint8_t i = 0; i < HOST_IRQ_PERIODIC_SOURCES; i++)
+	{
+		if(periodic[i].running && periodic[i].handler == handler)
+		{
+			periodic[i].running = false;
+			pthread_join(periodic[i].thread, NULL);
+		}
+	}
+}
+
+static void *receiverThread(void *arg)
+{
+	ReceiverIRQTypeDef *receiver = arg;
+	uint8_t buffer[64];
+	int count;
+
+	while((count = receiver->reader(buffer, sizeof(buffer))) > 0)
+	{
+		host_irq_disable();
+		for(int i = 0; i < count; i++)
+			receiver->handler(buffer[i]);
+		host_irq_enable();
+	}
+
+	return NULL;
+}
+
+void host_irq_startReceiver(int (*reader)(uint8_t *buffer, int size), void (*handler)(uint8_t data))
+{
+	if(receiverCount >= HOST_IRQ_RECEIVERS)
+		return;
+
+	ReceiverIRQTypeDef *receiver = &receivers[receiverCount];
+	receiver->reader   = reader;
+	receiver->handler  = handler;
+
+	if(pthread_create(&receiver->thread, NULL, receiverThread, receiver) != 0)
+	{
+		perror("host_irq_startReceiver");
+		return;
+	}
+	pthread_detach(receiver->thread);
+	receiverCount++;
+}
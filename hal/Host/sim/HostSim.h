@@ -0,0 +1,97 @@
+/*
+ * HostSim.h
+ *
+ * Simulated "peripherals" for running the firmware as a native Linux process.
+ *
+ * The host build replaces the chip register files of the real boards with a
+ * few plain memory structures:
+ *   - GPIO ports with set/clear/data registers, laid out like the Kinetis ones
+ *     so the IOPinTypeDef register pointers keep working unchanged.
+ *   - SPI busses, each with a TMC chip model attached. The model implements the
+ *     common 40 bit TMC datagram (bit 7 of the address byte = write access,
+ *     read data is returned with the following datagram) on top of a register file.
+ *   - Interrupts: Handlers run in their own threads. The global interrupt
+ *     enable/disable maps to a recursive lock, so a handler never runs while the
+ *     main code has interrupts disabled - just as on the real boards.
+ */
+
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_
+
+#include <stdint.h>
+
+// ===== GPIO =====
+#define HOST_GPIO_PORTS  5  // Ports A-E, like on the Landungsbruecke
+
+typedef struct
+{
+	volatile uint32_t PDOR;  // Port data output
+	volatile uint32_t PSOR;  // Port set output (last written value)
+	volatile uint32_t PCOR;  // Port clear output (last written value)
+	volatile uint32_t PDDR;  // Port data direction (1: output)
+	volatile uint32_t PDIR;  // Port data input
+	volatile uint32_t PUE;   // Simulated pull-up resistors (1: pulled high)
+} HostGPIO_Type, *HostGPIO_MemMapPtr;
+
+extern HostGPIO_Type HostGPIO[HOST_GPIO_PORTS];
+
+#define PTA_BASE_PTR  (&HostGPIO[0])
+#define PTB_BASE_PTR  (&HostGPIO[1])
+#define PTC_BASE_PTR  (&HostGPIO[2])
+#define PTD_BASE_PTR  (&HostGPIO[3])
+#define PTE_BASE_PTR  (&HostGPIO[4])
+
+// Refresh the input register of a port after an output/configuration change
+void host_gpio_update(HostGPIO_MemMapPtr port);
+
+// ===== SPI =====
+#define HOST_SPI_BUSSES          3    // SPI0 (EEPROM), SPI1 (ch1), SPI2 (ch2)
+#define HOST_SPI_REGISTERS       128  // 7 bit register address space of the TMC chips
+#define HOST_SPI_DATAGRAM_SIZE   5
+
+typedef struct
+{
+	int32_t registers[HOST_SPI_REGISTERS];
+	uint8_t status;                          // SPI status byte replied with every datagram
+	uint8_t frame[HOST_SPI_DATAGRAM_SIZE];   // currently received datagram
+	uint8_t reply[HOST_SPI_DATAGRAM_SIZE];   // reply shifted out during the current datagram
+	uint8_t position;                        // byte position within the current datagram
+	uint32_t datagrams;                      // number of completed datagrams
+	uint32_t frequency;                      // configured SCK frequency - only kept, the transfers are untimed
+} HostSPI_Type, *HostSPI_MemMapPtr;
+
+extern HostSPI_Type HostSPI[HOST_SPI_BUSSES];
+
+#define SPI0_BASE_PTR  (&HostSPI[0])
+#define SPI1_BASE_PTR  (&HostSPI[1])
+#define SPI2_BASE_PTR  (&HostSPI[2])
+
+// Shift one byte through the simulated chip on the given bus
+uint8_t host_spi_transfer(HostSPI_MemMapPtr spi, uint8_t data, uint8_t lastTransfer);
+
+// ===== Interrupts =====
+void host_irq_disable(void);
+void host_irq_enable(void);
+
+#define DisableInterrupts  host_irq_disable()
+#define EnableInterrupts   host_irq_enable()
+#define __disable_irq()    host_irq_disable()
+#define __enable_irq()     host_irq_enable()
+
+// Periodic interrupt source with the given frequency [Hz].
+// Ticks missed due to the host scheduler are caught up on the next wakeup.
+void host_irq_startPeriodic(void (*handler)(void), uint32_t frequency);
+void host_irq_stopPeriodic(void (*handler)(void));
+
+// Run a blocking reader loop as "receive interrupt" source.
+// The reader returns the number of bytes received into the buffer (<= 0 ends the thread),
+// the handler then gets called with interrupts disabled for each received byte.
+void host_irq_startReceiver(int (*reader)(uint8_t *buffer, int size), void (*handler)(uint8_t data));
+
+// Monotonic host time in nanoseconds
+uint64_t host_getTimeNs(void);
+
+// Sleep the calling thread, used by busy waiting loops to not spin a host CPU core
+void host_idle(void);
+
+#endif /* HOST_SIM_H_ */
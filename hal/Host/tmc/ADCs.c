@@ -0,0 +1,50 @@
+#include "hal/HAL.h"
+#include "hal/ADCs.h"
+
+/* Simulated ADC results. The values are static, they can be changed from a
+ * debugger or by host tooling linked into the simulation.
+ *
+ * Result buffer indices (same assignment as on the Landungsbruecke):
+ * ADC0[0]: VM
+ * ADC0[1]: DIO4
+ * ADC0[2]: DIO5
+ * ADC1[0]: AIN2
+ * ADC1[1]: AIN0
+ * ADC1[2]: AIN1
+ */
+
+// VM = ADC * 71.3V / 65535 -> 24V
+#define HOST_ADC_VM  22059
+
+static void init(void);
+static void deInit(void);
+
+volatile uint16_t adc0_result[3] = { 0 };
+volatile uint16_t adc1_result[3] = { 0 };
+
+ADCTypeDef ADCs =
+{
+	.AIN0    = &adc1_result[1],
+	.AIN1    = &adc1_result[2],
+	.AIN2    = &adc1_result[0],
+	.DIO4    = &adc0_result[1],
+	.DIO5    = &adc0_result[2],
+	.VM      = &adc0_result[0],
+	.init    = init,
+	.deInit  = deInit
+};
+
+static void init(void)
+{
+	adc0_result[0] = HOST_ADC_VM;
+	adc0_result[1] = 0;
+	adc0_result[2] = 0;
+
+	adc1_result[0] = 0;
+	adc1_result[1] = 0;
+	adc1_result[2] = 0;
+}
+
+static void deInit(void)
+{
+}
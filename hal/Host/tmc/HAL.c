@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal/HAL.h"
+
+static void init(void);
+static void reset(uint8_t ResetPeripherals);
+static void NVIC_DeInit(void);
+
+static const IOsFunctionsTypeDef IOFunctions =
+{
+	.config  = &IOs,
+	.pins    = &IOMap,
+};
+
+const HALTypeDef HAL =
+{
+	.init         = init,
+	.reset        = reset,
+	.NVIC_DeInit  = NVIC_DeInit,
+	.SPI          = &SPI,
+	.USB          = &USB,
+	.LEDs         = &LEDs,
+	.ADCs         = &ADCs,
+	.IOs          = &IOFunctions,
+	.RS232        = &RS232,
+	.WLAN         = &WLAN,
+	.Timer        = &Timer,
+	.UART         = &UART
+};
+
+static void init(void)
+{
+	// Unbuffered output, replies have to reach the host side immediately
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	systick_init();
+	wait(100);
+
+	IOs.init();
+	IOMap.init();
+	LEDs.init();
+	ADCs.init();
+	SPI.init();
+	WLAN.init();
+	RS232.init();
+	USB.init();
+
+	// The simulation behaves like a Landungsbruecke v1.X
+	hwid = 0;
+}
+
+static void __attribute((noreturn)) reset(uint8_t ResetPeripherals)
+{
+	UNUSED(ResetPeripherals);
+
+	// A reset ends the simulation. Restarting is left to the calling environment.
+	fprintf(stderr, "Host: reset requested, exiting\n");
+	exit(EXIT_SUCCESS);
+}
+
+static void NVIC_DeInit(void)
+{
+	// No interrupt controller in the simulation. Periodic interrupt sources get
+	// stopped by their respective deInit functions.
+}
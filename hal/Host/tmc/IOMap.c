@@ -0,0 +1,241 @@
+#include "hal/HAL.h"
+#include "hal/IOMap.h"
+
+static void init();
+
+/* Pin assignment of the simulated ports follows the Landungsbruecke, so
+ * board code and tools see the same port/bit layout.
+ */
+#define HOST_PIN(PORT, BIT, RESET_MODE)                \
+	{                                                  \
+		.setBitRegister      = &(PORT->PSOR),          \
+		.resetBitRegister    = &(PORT->PCOR),          \
+		.GPIOBase            = PORT,                   \
+		.bitWeight           = 1UL << (BIT),           \
+		.bit                 = BIT,                    \
+		.resetConfiguration  =                         \
+		{                                              \
+			.GPIO_Mode   = RESET_MODE,                 \
+			.GPIO_OType  = GPIO_OType_PP,              \
+			.GPIO_Speed  = GPIO_Speed_50MHz,           \
+			.GPIO_PuPd   = GPIO_PuPd_NOPULL            \
+		}                                              \
+	}
+
+static IOPinTypeDef *_pins[] =
+{
+	&IOMap.ID_CLK,
+	&IOMap.ID_CH0,
+	&IOMap.ID_CH1,
+	&IOMap.DIO0,
+	&IOMap.DIO1,
+	&IOMap.DIO2,
+	&IOMap.DIO3,
+	&IOMap.DIO4,
+	&IOMap.DIO5,
+	&IOMap.DIO6,
+	&IOMap.DIO7,
+	&IOMap.DIO8,
+	&IOMap.DIO9,
+	&IOMap.DIO10,
+	&IOMap.DIO11,
+	&IOMap.CLK16,
+	&IOMap.SPI2_CSN0,
+	&IOMap.SPI2_CSN1,
+	&IOMap.SPI2_CSN2,
+	&IOMap.SPI2_SCK,
+	&IOMap.SPI2_SDO,
+	&IOMap.SPI2_SDI,
+	&IOMap.SPI1_CSN,
+	&IOMap.SPI1_SCK,
+	&IOMap.SPI1_SDI,
+	&IOMap.SPI1_SDO,
+	&IOMap.DIO12,
+	&IOMap.DIO13,
+	&IOMap.DIO14,
+	&IOMap.DIO15,
+	&IOMap.DIO16,
+	&IOMap.DIO17,
+	&IOMap.DIO18,
+	&IOMap.DIO19,
+	&IOMap.WIRELESS_TX,
+	&IOMap.WIRELESS_RX,
+	&IOMap.WIRELESS_NRST,
+	&IOMap.RS232_TX,
+	&IOMap.RS232_RX,
+	&IOMap.USB_V_BUS,
+	&IOMap.USB_V_DM,
+	&IOMap.USB_V_DP,
+	&IOMap.LED_STAT,
+	&IOMap.LED_ERROR,
+	&IOMap.EXTIO_2,
+	&IOMap.EXTIO_3,
+	&IOMap.EXTIO_4,
+	&IOMap.EXTIO_5,
+	&IOMap.EXTIO_6,
+	&IOMap.EXTIO_7,
+	&IOMap.EEPROM_SCK,
+	&IOMap.EEPROM_SI,
+	&IOMap.EEPROM_SO,
+	&IOMap.EEPROM_NCS,
+	&IOMap.MIXED0,
+	&IOMap.MIXED1,
+	&IOMap.MIXED2,
+	&IOMap.MIXED3,
+	&IOMap.MIXED4,
+	&IOMap.MIXED5,
+	&IOMap.MIXED6,
+	&IOMap.ID_HW_0,
+	&IOMap.ID_HW_1,
+	&IOMap.ID_HW_2,
+	&IOMap.DUMMY
+};
+
+IOPinMapTypeDef IOMap =
+{
+	.init    = init,
+	.pins    = &_pins[0],
+
+	.ID_CLK        = HOST_PIN(PTB_BASE_PTR, 20, GPIO_Mode_AN),
+	.ID_CH0        = HOST_PIN(PTB_BASE_PTR, 18, GPIO_Mode_AN),
+	.ID_CH1        = HOST_PIN(PTB_BASE_PTR, 19, GPIO_Mode_AN),
+	.DIO0          = HOST_PIN(PTA_BASE_PTR, 12, GPIO_Mode_AN),
+	.DIO1          = HOST_PIN(PTA_BASE_PTR, 13, GPIO_Mode_AN),
+	.DIO2          = HOST_PIN(PTB_BASE_PTR, 0,  GPIO_Mode_AN),
+	.DIO3          = HOST_PIN(PTB_BASE_PTR, 1,  GPIO_Mode_AN),
+	.DIO4          = HOST_PIN(PTB_BASE_PTR, 2,  GPIO_Mode_AN),
+	.DIO5          = HOST_PIN(PTB_BASE_PTR, 3,  GPIO_Mode_AN),
+	.DIO6          = HOST_PIN(PTC_BASE_PTR, 2,  GPIO_Mode_AN),
+	.DIO7          = HOST_PIN(PTC_BASE_PTR, 1,  GPIO_Mode_AN),
+	.DIO8          = HOST_PIN(PTD_BASE_PTR, 5,  GPIO_Mode_AN),
+	.DIO9          = HOST_PIN(PTD_BASE_PTR, 4,  GPIO_Mode_AN),
+	.DIO10         = HOST_PIN(PTD_BASE_PTR, 7,  GPIO_Mode_AN),
+	.DIO11         = HOST_PIN(PTD_BASE_PTR, 6,  GPIO_Mode_AN),
+	.CLK16         = HOST_PIN(PTC_BASE_PTR, 3,  GPIO_Mode_AF5),
+	.SPI2_CSN0     = HOST_PIN(PTC_BASE_PTR, 0,  GPIO_Mode_AN),
+	.SPI2_CSN1     = HOST_PIN(PTA_BASE_PTR, 5,  GPIO_Mode_AN),
+	.SPI2_CSN2     = HOST_PIN(PTC_BASE_PTR, 4,  GPIO_Mode_AN),
+	.SPI2_SCK      = HOST_PIN(PTB_BASE_PTR, 21, GPIO_Mode_AN),
+	.SPI2_SDO      = HOST_PIN(PTB_BASE_PTR, 23, GPIO_Mode_AN),
+	.SPI2_SDI      = HOST_PIN(PTB_BASE_PTR, 22, GPIO_Mode_AN),
+	.SPI1_CSN      = HOST_PIN(PTB_BASE_PTR, 10, GPIO_Mode_AN),
+	.SPI1_SCK      = HOST_PIN(PTB_BASE_PTR, 11, GPIO_Mode_AN),
+	.SPI1_SDO      = HOST_PIN(PTB_BASE_PTR, 17, GPIO_Mode_AN),
+	.SPI1_SDI      = HOST_PIN(PTB_BASE_PTR, 16, GPIO_Mode_AN),
+	.DIO12         = HOST_PIN(PTC_BASE_PTR, 16, GPIO_Mode_AN),
+	.DIO13         = HOST_PIN(PTC_BASE_PTR, 17, GPIO_Mode_AN),
+	.DIO14         = HOST_PIN(PTC_BASE_PTR, 18, GPIO_Mode_AN),
+	.DIO15         = HOST_PIN(PTD_BASE_PTR, 1,  GPIO_Mode_AN),
+	.DIO16         = HOST_PIN(PTD_BASE_PTR, 0,  GPIO_Mode_AN),
+	.DIO17         = HOST_PIN(PTD_BASE_PTR, 3,  GPIO_Mode_AN),
+	.DIO18         = HOST_PIN(PTD_BASE_PTR, 2,  GPIO_Mode_AN),
+	.DIO19         = HOST_PIN(PTC_BASE_PTR, 15, GPIO_Mode_AN),
+	.WIRELESS_TX   = HOST_PIN(PTA_BASE_PTR, 14, GPIO_Mode_AN),
+	.WIRELESS_RX   = HOST_PIN(PTA_BASE_PTR, 15, GPIO_Mode_AN),
+	.WIRELESS_NRST = HOST_PIN(PTA_BASE_PTR, 16, GPIO_Mode_AN),
+	.RS232_TX      = HOST_PIN(PTE_BASE_PTR, 24, GPIO_Mode_AN),
+	.RS232_RX      = HOST_PIN(PTE_BASE_PTR, 25, GPIO_Mode_AN),
+	.USB_V_BUS     = HOST_PIN(PTA_BASE_PTR, 4,  GPIO_Mode_AN),
+	.LED_STAT      = HOST_PIN(PTA_BASE_PTR, 2,  GPIO_Mode_AN),
+	.LED_ERROR     = HOST_PIN(PTA_BASE_PTR, 1,  GPIO_Mode_AN),
+	.EXTIO_2       = HOST_PIN(PTE_BASE_PTR, 0,  GPIO_Mode_AN),
+	.EXTIO_3       = HOST_PIN(PTE_BASE_PTR, 1,  GPIO_Mode_AN),
+	.EXTIO_4       = HOST_PIN(PTE_BASE_PTR, 2,  GPIO_Mode_AN),
+	.EXTIO_5       = HOST_PIN(PTE_BASE_PTR, 3,  GPIO_Mode_AN),
+	.EXTIO_6       = HOST_PIN(PTE_BASE_PTR, 4,  GPIO_Mode_AN),
+	.EXTIO_7       = HOST_PIN(PTE_BASE_PTR, 5,  GPIO_Mode_AN),
+	.EEPROM_SCK    = HOST_PIN(PTC_BASE_PTR, 5,  GPIO_Mode_AN),
+	.EEPROM_SI     = HOST_PIN(PTC_BASE_PTR, 7,  GPIO_Mode_AN),
+	.EEPROM_SO     = HOST_PIN(PTC_BASE_PTR, 6,  GPIO_Mode_AN),
+	.EEPROM_NCS    = HOST_PIN(PTC_BASE_PTR, 8,  GPIO_Mode_AN),
+	.MIXED0        = HOST_PIN(PTC_BASE_PTR, 11, GPIO_Mode_AN),
+	.MIXED1        = HOST_PIN(PTC_BASE_PTR, 12, GPIO_Mode_AN),
+	.MIXED2        = HOST_PIN(PTC_BASE_PTR, 13, GPIO_Mode_AN),
+	.MIXED3        = HOST_PIN(PTC_BASE_PTR, 14, GPIO_Mode_AN),
+	.MIXED4        = HOST_PIN(PTC_BASE_PTR, 10, GPIO_Mode_AN),
+	.MIXED5        = HOST_PIN(PTC_BASE_PTR, 9,  GPIO_Mode_AN),
+	.MIXED6        = HOST_PIN(PTE_BASE_PTR, 6,  GPIO_Mode_AN),
+	.ID_HW_0       = HOST_PIN(PTE_BASE_PTR, 26, GPIO_Mode_AN),
+	.ID_HW_1       = HOST_PIN(PTA_BASE_PTR, 17, GPIO_Mode_AN),
+	.ID_HW_2       = HOST_PIN(PTB_BASE_PTR, 9,  GPIO_Mode_AN),
+
+	.DUMMY =  // Dummy Pin
+	{
+		.setBitRegister      = NULL,
+		.resetBitRegister    = NULL,
+		.GPIOBase            = PTA_BASE_PTR,
+		.bitWeight           = DUMMY_BITWEIGHT,
+		.bit                 = -1,
+		.resetConfiguration  =
+		{
+			.GPIO_Mode   = GPIO_Mode_AN,
+			.GPIO_OType  = GPIO_OType_PP,
+			.GPIO_Speed  = GPIO_Speed_50MHz,
+			.GPIO_PuPd   = GPIO_PuPd_NOPULL
+		}
+	}
+};
+
+static void init()
+{
+	HAL.IOs->config->reset(&HAL.IOs->pins->ID_CLK);
+	HAL.IOs->config->reset(&HAL.IOs->pins->ID_CH0);
+	HAL.IOs->config->reset(&HAL.IOs->pins->ID_CH1);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO0);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO1);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO2);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO3);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO4);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO5);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO6);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO7);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO8);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO9);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO10);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO11);
+	HAL.IOs->config->reset(&HAL.IOs->pins->CLK16);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI2_CSN0);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI2_CSN1);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI2_CSN2);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI2_SCK);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI2_SDO);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI2_SDI);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI1_CSN);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI1_SCK);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI1_SDI);
+	HAL.IOs->config->reset(&HAL.IOs->pins->SPI1_SDO);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO12);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO13);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO14);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO15);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO16);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO17);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO18);
+	HAL.IOs->config->reset(&HAL.IOs->pins->DIO19);
+	HAL.IOs->config->reset(&HAL.IOs->pins->WIRELESS_TX);
+	HAL.IOs->config->reset(&HAL.IOs->pins->WIRELESS_RX);
+	HAL.IOs->config->reset(&HAL.IOs->pins->WIRELESS_NRST);
+	HAL.IOs->config->reset(&HAL.IOs->pins->RS232_TX);
+	HAL.IOs->config->reset(&HAL.IOs->pins->RS232_RX);
+	HAL.IOs->config->reset(&HAL.IOs->pins->USB_V_BUS);
+	HAL.IOs->config->reset(&HAL.IOs->pins->LED_STAT);
+	HAL.IOs->config->reset(&HAL.IOs->pins->LED_ERROR);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EXTIO_2);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EXTIO_3);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EXTIO_4);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EXTIO_5);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EEPROM_SCK);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EEPROM_SI);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EEPROM_SO);
+	HAL.IOs->config->reset(&HAL.IOs->pins->EEPROM_NCS);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED0);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED1);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED2);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED3);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED4);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED5);
+	HAL.IOs->config->reset(&HAL.IOs->pins->MIXED6);
+	HAL.IOs->config->reset(&HAL.IOs->pins->ID_HW_0);
+	HAL.IOs->config->reset(&HAL.IOs->pins->ID_HW_1);
+	HAL.IOs->config->reset(&HAL.IOs->pins->ID_HW_2);
+}
@@ -0,0 +1,162 @@
+#include "hal/HAL.h"
+#include "hal/IOs.h"
+
+static void init();
+static void setPinConfiguration(IOPinTypeDef *pin);
+static void copyPinConfiguration(IOPinInitTypeDef *from, IOPinTypeDef*to);
+static void resetPinConfiguration(IOPinTypeDef *pin);
+static void setPin2Output(IOPinTypeDef *pin);
+static void setPin2Input(IOPinTypeDef *pin);
+static void setPinHigh(IOPinTypeDef *pin);
+static void setPinLow(IOPinTypeDef *pin);
+static void setPinState(IOPinTypeDef *pin, IO_States state);
+static IO_States getPinState(IOPinTypeDef *pin);
+static uint8_t isPinHigh(IOPinTypeDef *pin);
+
+IOsTypeDef IOs =
+{
+	.init        = init,
+	.set         = setPinConfiguration,
+	.reset       = resetPinConfiguration,
+	.copy        = copyPinConfiguration,
+	.toOutput    = setPin2Output,
+	.toInput     = setPin2Input,
+	.setHigh     = setPinHigh,
+	.setLow      = setPinLow,
+	.setToState  = setPinState,
+	.getState    = getPinState,
+	.isHigh      = isPinHigh
+};
+
+static void init()
+{
+	for(uint8_t i = 0; i < HOST_GPIO_PORTS; i++)
+	{
+		HostGPIO[i].PDOR  = 0;
+		HostGPIO[i].PDDR  = 0;
+		HostGPIO[i].PUE   = 0;
+		host_gpio_update(&HostGPIO[i]);
+	}
+}
+
+static void setPinConfiguration(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	// Only the digital behaviour is simulated: direction and pull resistors
+	if(pin->configuration.GPIO_Mode == GPIO_Mode_OUT)
+		pin->GPIOBase->PDDR |= pin->bitWeight;
+	else
+		pin->GPIOBase->PDDR &= ~pin->bitWeight;
+
+	if(pin->configuration.GPIO_PuPd == GPIO_PuPd_UP)
+		pin->GPIOBase->PUE |= pin->bitWeight;
+	else
+		pin->GPIOBase->PUE &= ~pin->bitWeight;
+
+	host_gpio_update(pin->GPIOBase);
+}
+
+static void setPin2Output(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	pin->configuration.GPIO_Mode = GPIO_Mode_OUT;
+	setPinConfiguration(pin);
+}
+
+static void setPin2Input(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	pin->configuration.GPIO_Mode = GPIO_Mode_IN;
+	setPinConfiguration(pin);
+}
+
+static void setPinState(IOPinTypeDef *pin, IO_States state)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	switch(state)
+	{
+	case IOS_LOW:
+		pin->configuration.GPIO_Mode   = GPIO_Mode_OUT;
+		pin->configuration.GPIO_PuPd   = GPIO_PuPd_NOPULL;
+		pin->configuration.GPIO_OType  = GPIO_OType_PP;
+		setPinConfiguration(pin);
+		setPinLow(pin);
+		break;
+	case IOS_HIGH:
+		pin->configuration.GPIO_Mode   = GPIO_Mode_OUT;
+		pin->configuration.GPIO_PuPd   = GPIO_PuPd_NOPULL;
+		pin->configuration.GPIO_OType  = GPIO_OType_PP;
+		setPinConfiguration(pin);
+		setPinHigh(pin);
+		break;
+	case IOS_OPEN:
+		pin->configuration.GPIO_Mode  = GPIO_Mode_AN;
+		setPinConfiguration(pin);
+		break;
+	case IOS_NOCHANGE:
+		break;
+	}
+
+	pin->state = state;
+}
+
+static IO_States getPinState(IOPinTypeDef *pin)
+{
+	return pin->state;
+}
+
+static void setPinHigh(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	*pin->setBitRegister = pin->bitWeight;
+	pin->GPIOBase->PDOR |= pin->bitWeight;
+	host_gpio_update(pin->GPIOBase);
+}
+
+static void setPinLow(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	*pin->resetBitRegister = pin->bitWeight;
+	pin->GPIOBase->PDOR &= ~pin->bitWeight;
+	host_gpio_update(pin->GPIOBase);
+}
+
+static uint8_t isPinHigh(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return -1;
+
+	return (pin->GPIOBase->PDIR & pin->bitWeight)? 1 : 0;
+}
+
+static void copyPinConfiguration(IOPinInitTypeDef *from, IOPinTypeDef *to)
+{
+	if(IS_DUMMY_PIN(to))
+		return;
+
+	to->configuration.GPIO_Mode   = from->GPIO_Mode;
+	to->configuration.GPIO_OType  = from->GPIO_OType;
+	to->configuration.GPIO_PuPd   = from->GPIO_PuPd;
+	to->configuration.GPIO_Speed  = from->GPIO_Speed;
+	setPinConfiguration(to);
+}
+
+static void resetPinConfiguration(IOPinTypeDef *pin)
+{
+	if(IS_DUMMY_PIN(pin))
+		return;
+
+	copyPinConfiguration(&(pin->resetConfiguration), pin);
+}
@@ -0,0 +1,105 @@
+/*
+ * RS232.c
+ *
+ * The simulated RS232 interface uses the standard input and output of the process.
+ * This allows piping TMCL datagrams through the simulation, e.g.
+ *   xxd -r -p commands.hex | _build_Host/Host_v<VERSION>_NOBL.elf | xxd
+ */
+
+#include <unistd.h>
+
+#include "hal/HAL.h"
+#include "hal/RS232.h"
+
+#define BUFFER_SIZE  1024  // Has to be a power of two
+
+static void init();
+static void deInit();
+static void tx(uint8_t ch);
+static uint8_t rx(uint8_t *ch);
+static void txN(uint8_t *str, uint8_t number);
+static uint8_t rxN(uint8_t *ch, uint8_t number);
+static void clearBuffers(void);
+static uint32_t bytesAvailable();
+static uint32_t bytesFree();
+
+static int stdinReader(uint8_t *buffer, int size);
+static void stdinReceive(uint8_t data);
+
+static volatile uint8_t rxBuffer[BUFFER_SIZE];
+
+RXTXTypeDef RS232 =
+{
+	.init            = init,
+	.deInit          = deInit,
+	.rx              = rx,
+	.tx              = tx,
+	.rxN             = rxN,
+	.txN             = txN,
+	.clearBuffers    = clearBuffers,
+	.baudRate        = 115200,
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
+};
+
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+
+static void init()
+{
+	host_irq_startReceiver(stdinReader, stdinReceive);
+}
+
+static void deInit()
+{
+	clearBuffers();
+}
+
+static int stdinReader(uint8_t *buffer, int size)
+{
+	return read(STDIN_FILENO, buffer, size);
+}
+
+// "Receive interrupt" - called with interrupts disabled
+static void stdinReceive(uint8_t data)
+{
+	ringbuffer_push(&rxRing, data); // Dropped on overflow
+}
+
+static void tx(uint8_t ch)
+{
+	txN(&ch, 1);
+}
+
+static uint8_t rx(uint8_t *ch)
+{
+	return rxN(ch, 1);
+}
+
+static void txN(uint8_t *str, uint8_t number)
+{
+	if(write(STDOUT_FILENO, str, number) != number)
+		return; // Nothing we can do about a closed stdout here
+}
+
+static uint8_t rxN(uint8_t *str, uint8_t number)
+{
+	return ringbuffer_popN(&rxRing, str, number);
+}
+
+static void clearBuffers(void)
+{
+	DisableInterrupts;
+	ringbuffer_clear(&rxRing);
+	EnableInterrupts;
+}
+
+static uint32_t bytesAvailable()
+{
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	// write() blocks until stdout took the data
+	return UINT32_MAX;
+}
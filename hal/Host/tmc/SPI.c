@@ -0,0 +1,245 @@
+#include "hal/HAL.h"
+#include "hal/RS232.h"
+
+#define SPI_DEFAULT_FREQUENCY  2666666  // Same default as the Landungsbruecke
+
+void init();
+void reset_ch1();
+void reset_ch2();
+
+static uint8_t readWrite(SPIChannelTypeDef *SPIChannel, uint8_t data, uint8_t lastTransfer);
+static uint8_t spi_ch1_readWrite(uint8_t data, uint8_t lastTransfer);
+static uint8_t spi_ch2_readWrite(uint8_t data, uint8_t lastTransfer);
+static void spi_ch1_readWriteArray(uint8_t *data, size_t length);
+static void spi_ch2_readWriteArray(uint8_t *data, size_t length);
+static uint32_t spi_ch1_setFrequency(uint32_t frequency);
+static uint32_t spi_ch2_setFrequency(uint32_t frequency);
+static uint32_t spi_ch1_getFrequency(void);
+static uint32_t spi_ch2_getFrequency(void);
+
+SPIChannelTypeDef *SPIChannel_1_default;
+SPIChannelTypeDef *SPIChannel_2_default;
+
+volatile uint32_t spiBusOwner = 0;
+
+static IOPinTypeDef IODummy = { .bitWeight = DUMMY_BITWEIGHT };
+
+SPITypeDef SPI=
+{
+	.ch1 =
+	{
+		.periphery       = SPI1_BASE_PTR,
+		.CSN             = &IODummy,
+		.readWrite       = spi_ch1_readWrite,
+		.readWriteArray  = spi_ch1_readWriteArray,
+		.reset           = reset_ch1,
+		.setFrequency    = spi_ch1_setFrequency,
+		.getFrequency    = spi_ch1_getFrequency
+	},
+	.ch2 =
+	{
+		.periphery       = SPI2_BASE_PTR,
+		.CSN             = &IODummy,
+		.readWrite       = spi_ch2_readWrite,
+		.readWriteArray  = spi_ch2_readWriteArray,
+		.reset           = reset_ch2,
+		.setFrequency    = spi_ch2_setFrequency,
+		.getFrequency    = spi_ch2_getFrequency
+	},
+	.init = init
+};
+
+
+void init()
+{
+	// SPI0 -> EEPROM, SPI1 -> ch1, SPI2 -> ch2
+	// Each simulated bus starts with a cleared register file and datagram state
+	for(uint8_t i = 0; i < HOST_SPI_BUSSES; i++)
+	{
+		for(uint8_t j = 0; j < HOST_SPI_REGISTERS; j++)
+			HostSPI[i].registers[j] = 0;
+
+		HostSPI[i].status     = 0;
+		HostSPI[i].position   = 0;
+		HostSPI[i].datagrams  = 0;
+		HostSPI[i].frequency  = SPI_DEFAULT_FREQUENCY;
+	}
+
+	HAL.IOs->config->toOutput(&HAL.IOs->pins->EEPROM_NCS);
+	HAL.IOs->config->setHigh(&HAL.IOs->pins->EEPROM_NCS);
+
+	HAL.IOs->config->toOutput(&HAL.IOs->pins->SPI1_CSN);
+	HAL.IOs->config->setHigh(&HAL.IOs->pins->SPI1_CSN);
+
+	HAL.IOs->config->toOutput(&HAL.IOs->pins->SPI2_CSN0);
+	HAL.IOs->config->toOutput(&HAL.IOs->pins->SPI2_CSN1);
+	HAL.IOs->config->toOutput(&HAL.IOs->pins->SPI2_CSN2);
+	HAL.IOs->config->setHigh(&HAL.IOs->pins->SPI2_CSN0);
+	HAL.IOs->config->setHigh(&HAL.IOs->pins->SPI2_CSN1);
+	HAL.IOs->config->setHigh(&HAL.IOs->pins->SPI2_CSN2);
+
+	// configure default SPI channel_1
+	SPIChannel_1_default = &HAL.SPI->ch1;
+	SPIChannel_1_default->CSN = &HAL.IOs->pins->SPI1_CSN;
+	// configure default SPI channel_2
+	SPIChannel_2_default = &HAL.SPI->ch2;
+	SPIChannel_2_default->CSN = &HAL.IOs->pins->SPI2_CSN0;
+}
+
+static uint32_t spi_ch1_setFrequency(uint32_t frequency)
+{
+	SPI.ch1.periphery->frequency = (frequency == SPI_FREQUENCY_DEFAULT)? SPI_DEFAULT_FREQUENCY : frequency;
+	return SPI.ch1.periphery->frequency;
+}
+
+static uint32_t spi_ch2_setFrequency(uint32_t frequency)
+{
+	SPI.ch2.periphery->frequency = (frequency == SPI_FREQUENCY_DEFAULT)? SPI_DEFAULT_FREQUENCY : frequency;
+	return SPI.ch2.periphery->frequency;
+}
+
+static uint32_t spi_ch1_getFrequency(void)
+{
+	return SPI.ch1.periphery->frequency;
+}
+
+static uint32_t spi_ch2_getFrequency(void)
+{
+	return SPI.ch2.periphery->frequency;
+}
+
+void reset_ch1()
+{
+	HAL.IOs->config->reset(SPI.ch1.CSN);
+	SPI.ch1.periphery->position = 0;
+}
+
+void reset_ch2()
+{
+	HAL.IOs->config->reset(SPI.ch2.CSN);
+	SPI.ch2.readWrite = spi_ch2_readWrite;
+	SPI.ch2.periphery->position = 0;
+}
+
+int32_t spi_readInt(SPIChannelTypeDef *SPIChannel, uint8_t address)
+{
+	// clear write bit
+	address &= 0x7F;
+
+	return spi_datagram40(SPIChannel, address, 0);
+}
+
+int32_t spi_ch1_readInt(uint8_t address)
+{
+	return spi_readInt(SPIChannel_1_default, address);
+}
+
+int32_t spi_ch2_readInt(uint8_t address)
+{
+	return spi_readInt(SPIChannel_2_default, address);
+}
+
+void spi_writeInt(SPIChannelTypeDef *SPIChannel, uint8_t address, int value)
+{
+	spi_datagram40(SPIChannel, address|0x80, value);
+}
+
+void spi_ch1_writeInt(uint8_t address, int value)
+{
+	spi_writeInt(SPIChannel_1_default, address, value);
+}
+
+void spi_ch2_writeInt(uint8_t address, int value)
+{
+	spi_writeInt(SPIChannel_2_default, address, value);
+}
+
+/*
+ * Transfers a 40 bit TMC datagram (address byte and 32 bit value) and returns the 32 bit data of the reply.
+ * The simulated bus has no FIFO, the datagram is handed over in one go.
+ */
+int32_t spi_datagram40(SPIChannelTypeDef *SPIChannel, uint8_t address, int32_t value)
+{
+	uint8_t data[5] = { address, 0xFF & (value>>24), 0xFF & (value>>16), 0xFF & (value>>8), 0xFF & (value>>0) };
+
+	// A board may cover the channel by replacing its readWrite() - transfer byte wise through it then
+	if(SPIChannel->readWrite != spi_ch1_readWrite && SPIChannel->readWrite != spi_ch2_readWrite)
+	{
+		for(uint32_t i = 0; i < ARRAY_SIZE(data); i++)
+			data[i] = SPIChannel->readWrite(data[i], (i == ARRAY_SIZE(data) - 1)? true:false);
+
+		return (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+	}
+
+	if(IS_DUMMY_PIN(SPIChannel->CSN))
+		return 0;
+
+	spi_acquireBus();
+	HAL.IOs->config->setLow(SPIChannel->CSN); // Chip Select
+
+	for(uint32_t i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = host_spi_transfer(SPIChannel->periphery, data[i], (i == ARRAY_SIZE(data) - 1)? true:false);
+
+	HAL.IOs->config->setHigh(SPIChannel->CSN);
+	spi_releaseBus();
+
+	return (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+}
+
+uint8_t spi_ch1_readWrite(uint8_t data, uint8_t lastTransfer)
+{
+	return readWrite(&SPI.ch1, data, lastTransfer);
+}
+
+uint8_t spi_ch2_readWrite(uint8_t data, uint8_t lastTransfer)
+{
+	return readWrite(&SPI.ch2, data, lastTransfer);
+}
+
+static void spi_ch1_readWriteArray(uint8_t *data, size_t length)
+{
+	for(size_t i = 0; i < length; i++)
+	{
+		data[i] = readWrite(&SPI.ch1, data[i], (i == (length - 1))? true:false);
+	}
+}
+
+static void spi_ch2_readWriteArray(uint8_t *data, size_t length)
+{
+	for(size_t i = 0; i < length; i++)
+	{
+		data[i] = readWrite(&SPI.ch2, data[i], (i == (length - 1))? true:false);
+	}
+}
+
+uint8_t spi_ch1_readWriteByte(uint8_t data, uint8_t lastTransfer)
+{
+	return readWrite(SPIChannel_1_default, data, lastTransfer);
+}
+
+uint8_t readWrite(SPIChannelTypeDef *SPIChannel, uint8_t writeData, uint8_t lastTransfer)
+{
+	uint8_t readData = 0;
+
+	if(IS_DUMMY_PIN(SPIChannel->CSN))
+		return 0;
+
+	if(!SPIChannel->transferActive)
+	{
+		SPIChannel->transferActive = true;
+		spi_acquireBus();
+	}
+
+	HAL.IOs->config->setLow(SPIChannel->CSN); // Chip Select
+
+	readData = host_spi_transfer(SPIChannel->periphery, writeData, lastTransfer);
+
+	if(lastTransfer)
+	{
+		HAL.IOs->config->setHigh(SPIChannel->CSN);
+		SPIChannel->transferActive = false;
+		spi_releaseBus();
+	}
+
+	return readData;
+}
@@ -0,0 +1,45 @@
+#include "hal/HAL.h"
+#include "hal/SysTick.h"
+
+// The systick is derived from the host's monotonic clock instead of a counting interrupt
+static uint64_t startTime = 0;
+
+// Simulated core clock for the cycle counter - 48 MHz as on the Landungsbruecke
+#define HOST_CYCLES_PER_US  48
+
+void systick_init()
+{
+	startTime = host_getTimeNs();
+}
+
+uint32_t systick_getTick()
+{
+	return (uint32_t) ((host_getTimeNs() - startTime) / 1000000);
+}
+
+// The cycle counter is simulated from the monotonic clock as well, wrapping like the DWT counter
+uint32_t systick_getCycles()
+{
+	return (uint32_t) ((host_getTimeNs() - startTime) * HOST_CYCLES_PER_US / 1000);
+}
+
+/* Same tick semantics as on the boards, see the Landungsbruecke implementation:
+ * A correction of -1 gets applied to any systick difference.
+ */
+void wait(uint32_t delay)	// wait for [delay] ms/systicks
+{
+	uint32_t startTick = systick_getTick();
+	while((systick_getTick()-startTick) <= delay)
+		host_idle();
+}
+
+uint32_t timeSince(uint32_t tick)	// time difference since the [tick] timestamp in ms/systicks
+{
+	uint32_t tickDiff = systick_getTick() - tick;
+
+	// Prevent subtraction underflow - saturate to 0 instead
+	if(tickDiff != 0)
+		return tickDiff - 1;
+	else
+		return 0;
+}
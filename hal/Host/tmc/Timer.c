@@ -0,0 +1,46 @@
+#include "hal/HAL.h"
+#include "hal/Timer.h"
+
+// Simulated PWM timer - only the duty cycle values are kept
+
+static void init(void);
+static void deInit(void);
+static void setDuty(timer_channel, uint16_t);
+static uint16_t getDuty(timer_channel);
+
+static uint16_t duty[3] = { 0 };
+
+TimerTypeDef Timer =
+{
+	.init     = init,
+	.deInit   = deInit,
+	.setDuty  = setDuty,
+	.getDuty  = getDuty
+};
+
+static void init(void)
+{
+	for(uint8_t i = 0; i < ARRAY_SIZE(duty); i++)
+		duty[i] = 0;
+}
+
+static void deInit(void)
+{
+	init();
+}
+
+static void setDuty(timer_channel channel, uint16_t dutyValue)
+{
+	if(channel >= ARRAY_SIZE(duty))
+		return;
+
+	duty[channel] = MIN(dutyValue, TIMER_MAX);
+}
+
+static uint16_t getDuty(timer_channel channel)
+{
+	if(channel >= ARRAY_SIZE(duty))
+		return 0;
+
+	return duty[channel];
+}
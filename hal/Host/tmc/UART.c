@@ -0,0 +1,406 @@
+/*
+ * UART.c
+ *
+ * Simulated TMC UART bus. Up to four slaves (addresses 0-3) with a register
+ * file each are attached. Sent datagrams get evaluated right away, replies to
+ * read requests are received as if coming from the UART interrupt - the queued
+ * transactions therefore complete synchronously within UART_submit().
+ * As on the boards, the CRC table 1 has to be filled by the board code.
+ */
+
+#include "hal/HAL.h"
+#include "hal/UART.h"
+
+#define BUFFER_SIZE         32
+#define UART_TIMEOUT_VALUE  10
+
+#define UART_SLAVES          4
+#define UART_SLAVE_REGISTERS 128
+#define UART_SLAVE_IFCNT     0x02  // Interface transmission counter register
+
+static void init();
+static void deInit();
+static void tx(uint8_t ch);
+static uint8_t rx(uint8_t *ch);
+static void txN(uint8_t *str, uint8_t number);
+static uint8_t rxN(uint8_t *ch, uint8_t number);
+static void clearBuffers(void);
+static uint32_t bytesAvailable();
+
+static void lock(void);
+static void unlock(void);
+static void startTransaction(void);
+static void finishTransaction(UART_TransactionState state);
+static void receive(uint8_t byte);
+static void transmissionComplete(void);
+static void cancelTransactions(void);
+
+static void slaveReceive(uint8_t data);
+
+static volatile uint8_t rxBuffer[BUFFER_SIZE];
+
+static int32_t slaveRegisters[UART_SLAVES][UART_SLAVE_REGISTERS];
+static uint8_t slaveDatagram[8];
+static uint8_t slaveDatagramPosition = 0;
+
+static UART_Transaction transactions[UART_TRANSACTION_QUEUE_SIZE];
+static volatile uint8_t transactionRead = 0;
+static volatile uint8_t transactionCount = 0;
+static volatile bool transactionActive = false;
+static uint32_t transactionStart;
+static uint8_t replyData[8];
+static uint8_t replyLength = 0;
+static uint32_t lockDepth = 0;
+
+UART_Config UART =
+{
+	.mode = UART_MODE_DUAL_WIRE,
+	.pinout = UART_PINS_1,
+	.rxtx =
+	{
+		.init            = init,
+		.deInit          = deInit,
+		.rx              = rx,
+		.tx              = tx,
+		.rxN             = rxN,
+		.txN             = txN,
+		.clearBuffers    = clearBuffers,
+		.baudRate        = 115200,
+		.bytesAvailable  = bytesAvailable
+	}
+};
+
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+
+static void init()
+{
+	for(uint8_t i = 0; i < UART_SLAVES; i++)
+		for(uint8_t j = 0; j < UART_SLAVE_REGISTERS; j++)
+			slaveRegisters[i][j] = 0;
+
+	slaveDatagramPosition = 0;
+}
+
+static void deInit()
+{
+	clearBuffers();
+}
+
+// Simulated slave side: collect a datagram and answer read requests
+static void slaveReceive(uint8_t data)
+{
+	// Resynchronise on the sync nibble
+	if(slaveDatagramPosition == 0 && (data & 0x0F) != 0x05)
+		return;
+
+	slaveDatagram[slaveDatagramPosition++] = data;
+
+	// Read requests are 4 bytes, write requests 8 bytes long
+	if(slaveDatagramPosition < 4)
+		return;
+	if((slaveDatagram[2] & TMC_WRITE_BIT) && slaveDatagramPosition < 8)
+		return;
+
+	uint8_t length = slaveDatagramPosition;
+	slaveDatagramPosition = 0;
+
+	if(slaveDatagram[length-1] != tmc_CRC8(slaveDatagram, length-1, 1))
+		return; // Slaves silently drop datagrams with CRC errors
+
+	if(slaveDatagram[1] >= UART_SLAVES)
+		return; // No slave with this address
+
+	int32_t *registers = slaveRegisters[slaveDatagram[1]];
+	uint8_t address = slaveDatagram[2] & 0x7F;
+
+	if(slaveDatagram[2] & TMC_WRITE_BIT)
+	{
+		registers[address] = ((uint32_t) slaveDatagram[3] << 24)
+		                   | ((uint32_t) slaveDatagram[4] << 16)
+		                   | ((uint32_t) slaveDatagram[5] << 8)
+		                   |  (uint32_t) slaveDatagram[6];
+		registers[UART_SLAVE_IFCNT] = (registers[UART_SLAVE_IFCNT] + 1) & 0xFF;
+		return;
+	}
+
+	uint8_t reply[8];
+	reply[0] = 0x05;                       // Sync byte
+	reply[1] = 0xFF;                       // Master address
+	reply[2] = address;                    // Register address
+	reply[3] = registers[address] >> 24;   // Register Data
+	reply[4] = registers[address] >> 16;   // Register Data
+	reply[5] = registers[address] >> 8;    // Register Data
+	reply[6] = registers[address] & 0xFF;  // Register Data
+	reply[7] = tmc_CRC8(reply, 7, 1);      // Cyclic redundancy check
+
+	for(uint8_t i = 0; i < ARRAY_SIZE(reply); i++)
+		receive(reply[i]);
+}
+
+// Nestable interrupt lock, the transaction functions call each other
+static void lock(void)
+{
+	if(lockDepth++ == 0)
+		DisableInterrupts;
+}
+
+static void unlock(void)
+{
+	if(--lockDepth == 0)
+		EnableInterrupts;
+}
+
+// Send the datagram of the oldest queued transaction - called with the UART interrupt locked
+static void startTransaction(void)
+{
+	UART_Transaction *transaction;
+	uint8_t datagram[8], length;
+
+	if(transactionCount == 0)
+		return;
+
+	transaction = &transactions[transactionRead];
+
+	datagram[0] = 0x05;                          // Sync byte
+	datagram[1] = transaction->slave;            // Slave address
+	datagram[2] = transaction->address;          // Register address
+	if(transaction->address & TMC_WRITE_BIT)
+	{
+		datagram[3] = transaction->value >> 24;  // Register Data
+		datagram[4] = transaction->value >> 16;  // Register Data
+		datagram[5] = transaction->value >> 8;   // Register Data
+		datagram[6] = transaction->value & 0xFF; // Register Data
+		length = 8;
+	}
+	else
+	{
+		length = 4;
+	}
+	datagram[length-1] = tmc_CRC8(datagram, length-1, 1); // Cyclic redundancy check
+
+	transactionActive = true;
+	transactionStart  = systick_getTick();
+	replyLength       = 0;
+
+	txN(datagram, length);
+}
+
+// Complete the active transaction and start the next one - called with the UART interrupt locked
+static void finishTransaction(UART_TransactionState state)
+{
+	UART_Transaction transaction = transactions[transactionRead];
+
+	transactionRead = (transactionRead + 1) % UART_TRANSACTION_QUEUE_SIZE;
+	transactionCount--;
+	transactionActive = false;
+
+	transaction.state = state;
+	if(transaction.callback)
+		transaction.callback(&transaction);
+
+	// The callback may have started a new transaction already
+	if(!transactionActive)
+		startTransaction();
+}
+
+// Received byte that is not the send echo
+static void receive(uint8_t byte)
+{
+	if(transactionActive && !(transactions[transactionRead].address & TMC_WRITE_BIT))
+	{
+		replyData[replyLength++] = byte;
+		if(replyLength < ARRAY_SIZE(replyData))
+			return;
+
+		// Check if the received data is correct (CRC, Sync, Master address, Register address)
+		// todo CHECK 2: Only keep CRC check? Should be sufficient for wrong transmissions (LH) #1
+		if(replyData[7] != tmc_CRC8(replyData, 7, 1) || replyData[0] != 0x05 || replyData[1] != 0xFF || replyData[2] != transactions[transactionRead].address)
+		{
+			finishTransaction(UART_TRANSACTION_CRC_ERROR);
+			return;
+		}
+
+		transactions[transactionRead].value = replyData[3] << 24 | replyData[4] << 16 | replyData[5] << 8 | replyData[6];
+		finishTransaction(UART_TRANSACTION_DONE);
+		return;
+	}
+
+	// No transaction waiting for a reply -> keep the byte for rx()
+	ringbuffer_push(&rxRing, byte);
+}
+
+// Last bit of the tx buffer has been sent
+static void transmissionComplete(void)
+{
+	// Write access is done as soon as the datagram is out, there is no reply
+	if(transactionActive && (transactions[transactionRead].address & TMC_WRITE_BIT))
+		finishTransaction(UART_TRANSACTION_DONE);
+}
+
+bool UART_submit(UART_Config *channel, const UART_Transaction *transaction)
+{
+	UNUSED(channel);
+
+	lock();
+	if(transactionCount >= UART_TRANSACTION_QUEUE_SIZE)
+	{
+		unlock();
+		return false;
+	}
+
+	UART_Transaction *queued = &transactions[(transactionRead + transactionCount) % UART_TRANSACTION_QUEUE_SIZE];
+	*queued = *transaction;
+	queued->state = UART_TRANSACTION_PENDING;
+	transactionCount++;
+
+	if(!transactionActive)
+		startTransaction();
+	unlock();
+
+	return true;
+}
+
+void UART_process(UART_Config *channel)
+{
+	UNUSED(channel);
+
+	lock();
+	if(transactionActive && timeSince(transactionStart) > UART_TIMEOUT_VALUE)
+		finishTransaction(UART_TRANSACTION_TIMEOUT);
+	unlock();
+}
+
+uint8_t UART_pendingTransactions(UART_Config *channel)
+{
+	UNUSED(channel);
+
+	return transactionCount;
+}
+
+typedef struct
+{
+	int32_t *value;
+	volatile bool done;
+} ReadIntResult;
+
+static void readIntCallback(UART_Transaction *transaction)
+{
+	ReadIntResult *result = transaction->user;
+
+	if(transaction->state == UART_TRANSACTION_DONE)
+		*result->value = transaction->value;
+
+	result->done = true;
+}
+
+// Blocking read for callers needing the value right away - only waits for this one datagram.
+// Prefer UART_readIntAsync() where the value can be handled later.
+// On timeout or transmission errors the value is left unchanged.
+void UART_readInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t *value)
+{
+	ReadIntResult result = { .value = value, .done = false };
+	UART_Transaction transaction =
+	{
+		.slave     = slave,
+		.address   = address & ~TMC_WRITE_BIT,
+		.callback  = readIntCallback,
+		.user      = &result
+	};
+
+	while(!UART_submit(channel, &transaction))
+		UART_process(channel);
+
+	while(!result.done)
+		UART_process(channel);
+}
+
+// Queues the read access and returns right away, the callback gets the value (transaction->value)
+// once the reply is in. false if the queue is full.
+bool UART_readIntAsync(UART_Config *channel, uint8_t slave, uint8_t address, void (*callback)(UART_Transaction *transaction), void *user)
+{
+	UART_Transaction transaction =
+	{
+		.slave     = slave,
+		.address   = address & ~TMC_WRITE_BIT,
+		.callback  = callback,
+		.user      = user
+	};
+
+	return UART_submit(channel, &transaction);
+}
+
+// Queues the write access and returns right away
+void UART_writeInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t value)
+{
+	UART_Transaction transaction =
+	{
+		.slave     = slave,
+		.address   = address | TMC_WRITE_BIT,
+		.value     = value,
+		.callback  = NULL
+	};
+
+	while(!UART_submit(channel, &transaction))
+		UART_process(channel);
+}
+
+static void tx(uint8_t ch)
+{
+	txN(&ch, 1);
+}
+
+static uint8_t rx(uint8_t *ch)
+{
+	return rxN(ch, 1);
+}
+
+static void txN(uint8_t *str, uint8_t number)
+{
+	lock();
+	for(int32_t i = 0; i < number; i++)
+		slaveReceive(str[i]);
+	transmissionComplete();
+	unlock();
+}
+
+static uint8_t rxN(uint8_t *str, uint8_t number)
+{
+	return ringbuffer_popN(&rxRing, str, number);
+}
+
+// Drop all queued transactions - called with the UART interrupt locked.
+// The callbacks run after the queue is empty, so they may submit new transactions.
+static void cancelTransactions(void)
+{
+	UART_Transaction dropped[UART_TRANSACTION_QUEUE_SIZE];
+	uint8_t count = transactionCount;
+
+	for(uint8_t i = 0; i < count; i++)
+		dropped[i] = transactions[(transactionRead + i) % UART_TRANSACTION_QUEUE_SIZE];
+
+	transactionRead    = 0;
+	transactionCount   = 0;
+	transactionActive  = false;
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		dropped[i].state = UART_TRANSACTION_CANCELLED;
+		if(dropped[i].callback)
+			dropped[i].callback(&dropped[i]);
+	}
+}
+
+static void clearBuffers(void)
+{
+	lock();
+	ringbuffer_clear(&rxRing);
+	slaveDatagramPosition  = 0;
+
+	cancelTransactions();
+	unlock();
+}
+
+static uint32_t bytesAvailable()
+{
+	return ringbuffer_used(&rxRing);
+}
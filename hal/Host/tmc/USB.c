@@ -0,0 +1,138 @@
+/*
+ * USB.c
+ *
+ * The simulated USB CDC interface is a pseudo terminal. Its device path
+ * (e.g. /dev/pts/3) is printed on startup, the TMCL-IDE or any serial
+ * terminal program can connect to it like to the real board.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "hal/HAL.h"
+#include "hal/USB.h"
+
+#define BUFFER_SIZE  1024  // Has to be a power of two
+
+static void init();
+static void deInit();
+static void tx(uint8_t ch);
+static uint8_t rx(uint8_t *ch);
+static void txN(uint8_t *str, uint8_t number);
+static uint8_t rxN(uint8_t *ch, uint8_t number);
+static void clearBuffers(void);
+static uint32_t bytesAvailable();
+static uint32_t bytesFree();
+
+static int ptyReader(uint8_t *buffer, int size);
+static void ptyReceive(uint8_t data);
+
+static volatile uint8_t rxBuffer[BUFFER_SIZE];
+
+static int masterFd = -1;
+static int slaveFd  = -1;
+
+RXTXTypeDef USB =
+{
+	.init            = init,
+	.deInit          = deInit,
+	.rx              = rx,
+	.tx              = tx,
+	.rxN             = rxN,
+	.txN             = txN,
+	.clearBuffers    = clearBuffers,
+	.baudRate        = 115200,
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
+};
+
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+
+static void init()
+{
+	struct termios settings;
+
+	masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+	if(masterFd < 0 || grantpt(masterFd) != 0 || unlockpt(masterFd) != 0)
+	{
+		perror("Host: USB pseudo terminal");
+		return;
+	}
+
+	// Keep the slave side open ourselves - reading the master would fail with EIO
+	// whenever no client is connected otherwise.
+	slaveFd = open(ptsname(masterFd), O_RDWR | O_NOCTTY);
+	if(slaveFd >= 0 && tcgetattr(slaveFd, &settings) == 0)
+	{
+		cfmakeraw(&settings);
+		tcsetattr(slaveFd, TCSANOW, &settings);
+	}
+
+	fprintf(stderr, "Host: USB CDC interface on %s\n", ptsname(masterFd));
+
+	host_irq_startReceiver(ptyReader, ptyReceive);
+}
+
+static void deInit()
+{
+	// The receiver thread is left running, closing the pseudo terminal would only end it.
+	clearBuffers();
+}
+
+static int ptyReader(uint8_t *buffer, int size)
+{
+	return read(masterFd, buffer, size);
+}
+
+// "Receive interrupt" - called with interrupts disabled
+static void ptyReceive(uint8_t data)
+{
+	ringbuffer_push(&rxRing, data); // Dropped on overflow
+}
+
+static void tx(uint8_t ch)
+{
+	txN(&ch, 1);
+}
+
+static uint8_t rx(uint8_t *ch)
+{
+	return rxN(ch, 1);
+}
+
+static void txN(uint8_t *str, uint8_t number)
+{
+	if(masterFd < 0)
+		return;
+
+	if(write(masterFd, str, number) != number)
+		return; // Nothing we can do about a broken connection here
+}
+
+static uint8_t rxN(uint8_t *str, uint8_t number)
+{
+	return ringbuffer_popN(&rxRing, str, number);
+}
+
+static void clearBuffers(void)
+{
+	DisableInterrupts;
+	ringbuffer_clear(&rxRing);
+	EnableInterrupts;
+}
+
+static uint32_t bytesAvailable()
+{
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	// write() blocks until the pty took the data, only a missing connection drops it
+	return (masterFd < 0)? 0 : UINT32_MAX;
+}
@@ -0,0 +1,106 @@
+/*
+ * WLAN.c
+ *
+ * There is no wireless module in the simulation. The interface is present
+ * so TMCL can poll it like on the boards, it never receives any data and
+ * drops everything sent to it. WLAN commands report an error.
+ */
+
+#include "hal/HAL.h"
+#include "hal/WLAN.h"
+
+static void init();
+static void deInit();
+static void tx(uint8_t ch);
+static uint8_t rx(uint8_t *ch);
+static void txN(uint8_t *str, uint8_t number);
+static uint8_t rxN(uint8_t *ch, uint8_t number);
+static void clearBuffers(void);
+static uint32_t bytesAvailable();
+static uint32_t bytesFree();
+
+RXTXTypeDef WLAN =
+{
+	.init            = init,
+	.deInit          = deInit,
+	.rx              = rx,
+	.tx              = tx,
+	.rxN             = rxN,
+	.txN             = txN,
+	.clearBuffers    = clearBuffers,
+	.baudRate        = 57600,
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
+};
+
+static void init()
+{
+}
+
+static void deInit()
+{
+}
+
+static void tx(uint8_t ch)
+{
+	UNUSED(ch);
+}
+
+static uint8_t rx(uint8_t *ch)
+{
+	UNUSED(ch);
+	return 0;
+}
+
+static void txN(uint8_t *str, uint8_t number)
+{
+	UNUSED(str);
+	UNUSED(number);
+}
+
+static uint8_t rxN(uint8_t *str, uint8_t number)
+{
+	UNUSED(str);
+	UNUSED(number);
+	return 0;
+}
+
+static void clearBuffers(void)
+{
+}
+
+static uint32_t bytesAvailable()
+{
+	return 0;
+}
+
+static uint32_t bytesFree()
+{
+	return 0;
+}
+
+uint32_t checkReadyToSend()
+{
+	return false;
+}
+
+void enableWLANCommandMode()
+{
+}
+
+uint32_t checkCmdModeEnabled()
+{
+	return false;
+}
+
+uint32_t handleWLANCommand(BufferCommandTypedef cmd, uint32_t value)
+{
+	UNUSED(cmd);
+	UNUSED(value);
+	return 1;
+}
+
+uint32_t getCMDReply()
+{
+	return 0;
+}
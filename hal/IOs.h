@@ -10,7 +10,7 @@ typedef enum { // Give bits explicitly, because IDE relies on it.
 	IOS_NOCHANGE = 0b11
 } IO_States;
 
-#if defined(Landungsbruecke)
+#if defined(Landungsbruecke) || defined(Host)
 	// use ST like configuration structures also for Landungsbruecke
 
 	typedef enum
@@ -48,7 +48,9 @@ typedef enum { // Give bits explicitly, because IDE relies on it.
 		GPIO_Speed_100MHz  = 0x03  /*!< High speed on 30 pF (80 MHz Output max speed on 15 pF) */
 	} GPIOSpeed_TypeDef;
 
-	#include "hal/Landungsbruecke/freescale/PDD/GPIO_PDD.h"
+	#if defined(Landungsbruecke)
+		#include "hal/Landungsbruecke/freescale/PDD/GPIO_PDD.h"
+	#endif
 #endif
 
 enum IOsHighLevelFunctions { IO_DEFAULT, IO_DI, IO_AI, IO_DO, IO_PWM, IO_SD, IO_CLK16, IO_SPI };
@@ -84,6 +86,10 @@ typedef struct
 		GPIO_MemMapPtr          GPIOBase;
 		volatile uint32_t         *setBitRegister;
 		volatile uint32_t         *resetBitRegister;
+	#elif defined(Host)
+		HostGPIO_MemMapPtr      GPIOBase;
+		volatile uint32_t         *setBitRegister;
+		volatile uint32_t         *resetBitRegister;
 	#endif
 	uint32_t                      bitWeight;
 	unsigned char               bit;
@@ -1,7 +1,7 @@
 #ifndef LEDS_H_
 	#define LEDS_H_
 
-#ifdef Startrampe
+#if defined(Startrampe)
 	#define LED_ON()            *HAL.IOs->pins->LED_STAT.resetBitRegister   = HAL.IOs->pins->LED_STAT.bitWeight
 	#define LED_OFF()           *HAL.IOs->pins->LED_STAT.setBitRegister     = HAL.IOs->pins->LED_STAT.bitWeight
 	#define LED_TOGGLE()        HAL.IOs->pins->LED_STAT.port->ODR           ^= HAL.IOs->pins->LED_STAT.bitWeight
@@ -9,6 +9,14 @@
 	#define LED_ERROR_ON()      *HAL.IOs->pins->LED_ERROR.resetBitRegister  = HAL.IOs->pins->LED_ERROR.bitWeight
 	#define LED_ERROR_OFF()     *HAL.IOs->pins->LED_ERROR.setBitRegister    = HAL.IOs->pins->LED_ERROR.bitWeight
 	#define LED_ERROR_TOGGLE()  HAL.IOs->pins->LED_ERROR.port->ODR          ^= HAL.IOs->pins->LED_ERROR.bitWeight
+#elif defined(Host)
+	#define LED_ON()            HAL.IOs->config->setLow(&HAL.IOs->pins->LED_STAT)
+	#define LED_OFF()           HAL.IOs->config->setHigh(&HAL.IOs->pins->LED_STAT)
+	#define LED_TOGGLE()        HAL.IOs->config->setToState(&HAL.IOs->pins->LED_STAT, (HAL.IOs->config->isHigh(&HAL.IOs->pins->LED_STAT))? IOS_LOW:IOS_HIGH)
+
+	#define LED_ERROR_ON()      HAL.IOs->config->setLow(&HAL.IOs->pins->LED_ERROR)
+	#define LED_ERROR_OFF()     HAL.IOs->config->setHigh(&HAL.IOs->pins->LED_ERROR)
+	#define LED_ERROR_TOGGLE()  HAL.IOs->config->setToState(&HAL.IOs->pins->LED_ERROR, (HAL.IOs->config->isHigh(&HAL.IOs->pins->LED_ERROR))? IOS_LOW:IOS_HIGH)
 #else
 	#define LED_ON()            *HAL.IOs->pins->LED_STAT.resetBitRegister   = HAL.IOs->pins->LED_STAT.bitWeight
 	#define LED_OFF()           *HAL.IOs->pins->LED_STAT.setBitRegister     = HAL.IOs->pins->LED_STAT.bitWeight
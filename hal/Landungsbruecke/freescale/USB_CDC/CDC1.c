@@ -84,6 +84,9 @@ static volatile boolean start_app = FALSE;
 static volatile boolean start_transactions = FALSE;
 
 static volatile boolean transactionOngoing = FALSE;
+
+/* Receives whole packets instead of Rx1 if set */
+static volatile CDC1_TRxPacketHandler rxPacketHandler = NULL;
 /*
 ** ===================================================================
 **     Method      :  CDC1_GetFreeInTxBuf (component FSL_USB_CDC_Device)
@@ -293,6 +296,7 @@ void CDC1_App_Callback(byte controller_ID, byte event_type, void *val)
   UNUSED(val);
   if(event_type == USB_APP_BUS_RESET) {
     start_app = FALSE;
+    transactionOngoing = FALSE; /* an unfinished send is aborted by the reset */
   } else if(event_type == USB_APP_ENUM_COMPLETE) {
 #if HIGH_SPEED_DEVICE
     /* prepare for the next receive event */
@@ -308,6 +312,10 @@ void CDC1_App_Callback(byte controller_ID, byte event_type, void *val)
     uint_8 index;
 
     BytesToBeCopied = (USB_PACKET_SIZE)((dp_rcv->data_size > CDC1_DATA_BUFF_SIZE) ? CDC1_DATA_BUFF_SIZE:dp_rcv->data_size);
+    if(rxPacketHandler != NULL) {
+      rxPacketHandler(dp_rcv->data_ptr, BytesToBeCopied);
+      BytesToBeCopied = 0; /* packet consumed by the handler */
+    }
     for(index = 0; index<BytesToBeCopied ; index++) {
       if(Rx1_Put(dp_rcv->data_ptr[index])!=ERR_OK) {
         /* Failed to put byte into buffer. Is the buffer to small? Then increase the Rx buffer.
@@ -328,6 +336,7 @@ void CDC1_App_Callback(byte controller_ID, byte event_type, void *val)
   } else if(event_type == USB_APP_ERROR) { /* detach? */
     start_app = FALSE;
     start_transactions = FALSE;
+    transactionOngoing = FALSE;
   }
 }
 
@@ -397,6 +406,44 @@ byte CDC1_SendDataBlock(byte *data, word dataSize)
   return res;
 }
 
+/*
+** ===================================================================
+**     Method      :  CDC1_SendPacket
+**     Description :
+**         Starts sending a data block without waiting for it
+** ===================================================================
+*/
+byte CDC1_SendPacket(byte *data, word dataSize)
+{
+  if((start_app!=TRUE) || (start_transactions!=TRUE)) {
+    return ERR_BUSOFF;
+  }
+  if(transactionOngoing) {
+    return ERR_BUSY;
+  }
+  transactionOngoing = TRUE; /* set first, the send complete interrupt may come before the call returns */
+  if(USB_Class_CDC_Interface_DIC_Send_Data(CONTROLLER_ID, data, dataSize)!=USB_OK) {
+    transactionOngoing = FALSE;
+    return ERR_FAULT;
+  }
+  return ERR_OK;
+}
+
+bool CDC1_TxBusy(void)
+{
+  return transactionOngoing;
+}
+
+bool CDC1_IsConnected(void)
+{
+  return (start_app==TRUE) && (start_transactions==TRUE);
+}
+
+void CDC1_SetRxPacketHandler(CDC1_TRxPacketHandler handler)
+{
+  rxPacketHandler = handler;
+}
+
 /*
 ** ===================================================================
 **     Method      :  CDC1_App_Task (component FSL_USB_CDC_Device)
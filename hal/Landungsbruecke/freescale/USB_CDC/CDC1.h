@@ -362,6 +362,57 @@ byte CDC1_SendDataBlock(byte *data, word dataSize);
 ** ===================================================================
 */
 
+/* Packet interface, bypassing the Tx1/Rx1 byte buffers (not generated by Processor Expert) */
+typedef void (*CDC1_TRxPacketHandler)(byte *data, word dataSize);
+
+byte CDC1_SendPacket(byte *data, word dataSize);
+/*
+** ===================================================================
+**     Method      :  CDC1_SendPacket
+**     Description :
+**         Starts sending a data block on the bulk IN endpoint and
+**         returns right away. The data gets split into endpoint
+**         packets by the USB stack, a size of 0 sends a zero length
+**         packet. The buffer has to stay untouched until
+**         CDC1_TxBusy() returns FALSE.
+**     Returns     :
+**         ---             - ERR_OK, ERR_BUSY while the previous
+**                           block is being sent, ERR_BUSOFF if
+**                           no host is connected, ERR_FAULT
+** ===================================================================
+*/
+
+bool CDC1_TxBusy(void);
+/*
+** ===================================================================
+**     Method      :  CDC1_TxBusy
+**     Description :
+**         Returns TRUE while a block of CDC1_SendPacket() is sent.
+** ===================================================================
+*/
+
+bool CDC1_IsConnected(void);
+/*
+** ===================================================================
+**     Method      :  CDC1_IsConnected
+**     Description :
+**         Returns TRUE when the device is enumerated and the host
+**         opened the port.
+** ===================================================================
+*/
+
+void CDC1_SetRxPacketHandler(CDC1_TRxPacketHandler handler);
+/*
+** ===================================================================
+**     Method      :  CDC1_SetRxPacketHandler
+**     Description :
+**         Received packets get passed to the handler as a whole
+**         instead of being put into the Rx1 buffer. The handler is
+**         called from the USB interrupt. NULL restores the Rx1
+**         buffer.
+** ===================================================================
+*/
+
 /* END CDC1. */
 
 #endif
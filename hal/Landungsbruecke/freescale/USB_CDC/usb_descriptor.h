@@ -121,9 +121,9 @@
 #define CIC_NOTIF_ENDPOINT               (3)
 #define CIC_NOTIF_ENDP_PACKET_SIZE       (16)
 #define DIC_BULK_IN_ENDPOINT             (1)
-#define DIC_BULK_IN_ENDP_PACKET_SIZE     (16)/* max supported is 64 */
+#define DIC_BULK_IN_ENDP_PACKET_SIZE     (64)/* max supported is 64 */
 #define DIC_BULK_OUT_ENDPOINT            (2)
-#define DIC_BULK_OUT_ENDP_PACKET_SIZE    (16)/* max supported is 64*/
+#define DIC_BULK_OUT_ENDP_PACKET_SIZE    (64)/* max supported is 64*/
 
 #if DIC_ISOCHRONOUS_SETTING
 #define DIC_ISO_IN_ENDPOINT              (1)
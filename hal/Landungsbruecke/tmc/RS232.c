@@ -2,7 +2,7 @@
 #include "hal/RS232.h"
 #include "hal/Landungsbruecke/freescale/Cpu.h"
 
-#define BUFFER_SIZE         1024
+#define BUFFER_SIZE         1024  // Has to be a power of two
 #define INTR_PRI            6
 #define UART_TIMEOUT_VALUE  5
 
@@ -14,13 +14,12 @@ static void txN(uint8_t *str, uint8_t number);
 static uint8_t rxN(uint8_t *ch, uint8_t number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
+static uint32_t bytesFree();
 
 static volatile uint8_t
 	rxBuffer[BUFFER_SIZE],
 	txBuffer[BUFFER_SIZE];
 
-static volatile uint32_t available = 0;
-
 RXTXTypeDef RS232 =
 {
 	.init            = init,
@@ -31,24 +30,12 @@ RXTXTypeDef RS232 =
 	.txN             = txN,
 	.clearBuffers    = clearBuffers,
 	.baudRate        = 115200,
-	.bytesAvailable  = bytesAvailable
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
 };
 
-static RXTXBufferingTypeDef buffers =
-{
-	.rx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = rxBuffer
-	},
-	.tx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = txBuffer
-	}
-};
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
 
 static void init()
 {
@@ -100,19 +87,17 @@ void UART4_RX_TX_IRQHandler(void)
 
 	if(status & UART_S1_RDRF_MASK)
 	{
-		buffers.rx.buffer[buffers.rx.wrote] = UART4_D;
-		buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-		available++;
+		ringbuffer_push(&rxRing, UART4_D); // Dropped if the buffer is full
 
 		UART4_S1 &= ~(UART_S1_RDRF_MASK);
 	}
 
 	if(status & UART_S1_TDRE_MASK)
 	{
-		if(buffers.tx.read != buffers.tx.wrote)
+		uint8_t data;
+		if(ringbuffer_pop(&txRing, &data))
 		{
-			UART4_D	= buffers.tx.buffer[buffers.tx.read];
-			buffers.tx.read = (buffers.tx.read + 1) % BUFFER_SIZE;
+			UART4_D	= data;
 		}
 		else
 		{ // empty buffer -> turn off send interrupt
@@ -124,56 +109,44 @@ void UART4_RX_TX_IRQHandler(void)
 
 static void tx(uint8_t ch)
 {
-	buffers.tx.buffer[buffers.tx.wrote] = ch;
-	buffers.tx.wrote = (buffers.tx.wrote + 1) % BUFFER_SIZE;
-
-	// enable send interrupt
-	UART4_C2 |= UART_C2_TIE_MASK;
+	txN(&ch, 1);
 }
 
 static uint8_t rx(uint8_t *ch)
 {
-	if(buffers.rx.read == buffers.rx.wrote)
-		return 0;
-
-	*ch = buffers.rx.buffer[buffers.rx.read];
-	buffers.rx.read = (buffers.rx.read + 1) % BUFFER_SIZE;
-	available--;
-
-	return 1;
+	return rxN(ch, 1);
 }
 
+// Blocks not fitting into the free space get dropped
 static void txN(uint8_t *str, uint8_t number)
 {
-	for(int32_t i = 0; i < number; i++)
-		tx(str[i]);
+	if(!ringbuffer_pushN(&txRing, str, number))
+		return;
+
+	// enable send interrupt
+	UART4_C2 |= UART_C2_TIE_MASK;
 }
 
 static uint8_t rxN(uint8_t *str, uint8_t number)
 {
-	if(available < number)
-		return 0;
-
-	for(int32_t i = 0; i < number; i++)
-		rx(&str[i]);
-
-	return 1;
+	return ringbuffer_popN(&rxRing, str, number);
 }
 
 static void clearBuffers(void)
 {
 	disable_irq(INT_UART4_RX_TX-16);
-	available         = 0;
-	buffers.rx.read   = 0;
-	buffers.rx.wrote  = 0;
-
-	buffers.tx.read   = 0;
-	buffers.tx.wrote  = 0;
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
 	enable_irq(INT_UART4_RX_TX-16);
 }
 
 static uint32_t bytesAvailable()
 {
-	return available;
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	return ringbuffer_free(&txRing);
 }
 
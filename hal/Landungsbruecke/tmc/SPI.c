@@ -1,21 +1,36 @@
 #include "hal/HAL.h"
 #include "hal/RS232.h"
 
+#define SPI_BUS_CLOCK  48000000  // DSPI protocol clock
+
+// SCK = SPI_BUS_CLOCK / PBR / BR, the array index is the value of the CTAR field
+static const uint8_t ctarPBR[] = { 2, 3, 5, 7 };
+static const uint16_t ctarBR[] = { 2, 4, 6, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768 };
+
 void init();
 void reset_ch1();
 void reset_ch2();
 
 static void setTMCSPIParameters(SPI_MemMapPtr basePtr);
+static uint32_t setFrequency(SPI_MemMapPtr basePtr, uint32_t frequency);
+static uint32_t getFrequency(SPI_MemMapPtr basePtr);
 
 static uint8_t readWrite(SPIChannelTypeDef *SPIChannel, uint8_t data, uint8_t lastTransfer);
+static void readWriteArray(SPIChannelTypeDef *SPIChannel, uint8_t *data, size_t length);
 static uint8_t spi_ch1_readWrite(uint8_t data, uint8_t lastTransfer);
 static uint8_t spi_ch2_readWrite(uint8_t data, uint8_t lastTransfer);
 static void spi_ch1_readWriteArray(uint8_t *data, size_t length);
 static void spi_ch2_readWriteArray(uint8_t *data, size_t length);
+static uint32_t spi_ch1_setFrequency(uint32_t frequency);
+static uint32_t spi_ch2_setFrequency(uint32_t frequency);
+static uint32_t spi_ch1_getFrequency(void);
+static uint32_t spi_ch2_getFrequency(void);
 
 SPIChannelTypeDef *SPIChannel_1_default;
 SPIChannelTypeDef *SPIChannel_2_default;
 
+volatile uint32_t spiBusOwner = 0;
+
 static IOPinTypeDef IODummy = { .bitWeight = DUMMY_BITWEIGHT };
 
 SPITypeDef SPI=
@@ -26,7 +41,9 @@ SPITypeDef SPI=
 		.CSN             = &IODummy,
 		.readWrite       = spi_ch1_readWrite,
 		.readWriteArray  = spi_ch1_readWriteArray,
-		.reset           = reset_ch1
+		.reset           = reset_ch1,
+		.setFrequency    = spi_ch1_setFrequency,
+		.getFrequency    = spi_ch1_getFrequency
 	},
 	.ch2 =
 	{
@@ -34,7 +51,9 @@ SPITypeDef SPI=
 		.CSN             = &IODummy,
 		.readWrite       = spi_ch2_readWrite,
 		.readWriteArray  = spi_ch2_readWriteArray,
-		.reset           = reset_ch2
+		.reset           = reset_ch2,
+		.setFrequency    = spi_ch2_setFrequency,
+		.getFrequency    = spi_ch2_getFrequency
 	},
 	.init = init
 };
@@ -156,6 +175,69 @@ void setTMCSPIParameters(SPI_MemMapPtr basePtr)
 	SPI_MCR_REG(basePtr) &= ~SPI_MCR_FRZ_MASK;
 }
 
+// Only the prescalers are changed, the delays configured in setTMCSPIParameters() are kept
+static uint32_t setFrequency(SPI_MemMapPtr basePtr, uint32_t frequency)
+{
+	uint32_t pbr = 1, br = 2; // default: 48MHz/18 = 2.66MHz
+	uint32_t best = 0;
+
+	if(frequency != SPI_FREQUENCY_DEFAULT)
+	{
+		// slowest possible setting in case the requested frequency is below all others
+		pbr = ARRAY_SIZE(ctarPBR) - 1;
+		br = ARRAY_SIZE(ctarBR) - 1;
+
+		for(uint32_t i = 0; i < ARRAY_SIZE(ctarPBR); i++)
+		{
+			for(uint32_t j = 0; j < ARRAY_SIZE(ctarBR); j++)
+			{
+				uint32_t sck = SPI_BUS_CLOCK / ctarPBR[i] / ctarBR[j];
+				if(sck <= frequency && sck > best)
+				{
+					best = sck;
+					pbr = i;
+					br = j;
+				}
+			}
+		}
+	}
+
+	SPI_MCR_REG(basePtr) |= SPI_MCR_HALT_MASK;
+	SPI_CTAR_REG(basePtr, 0) = (SPI_CTAR_REG(basePtr, 0) & ~(SPI_CTAR_PBR_MASK | SPI_CTAR_BR_MASK | SPI_CTAR_DBR_MASK))
+	                         | SPI_CTAR_PBR(pbr)
+	                         | SPI_CTAR_BR(br);
+	SPI_MCR_REG(basePtr) &= ~SPI_MCR_HALT_MASK;
+
+	return getFrequency(basePtr);
+}
+
+static uint32_t getFrequency(SPI_MemMapPtr basePtr)
+{
+	uint32_t ctar = SPI_CTAR_REG(basePtr, 0);
+
+	return SPI_BUS_CLOCK / ctarPBR[(ctar & SPI_CTAR_PBR_MASK) >> SPI_CTAR_PBR_SHIFT] / ctarBR[(ctar & SPI_CTAR_BR_MASK) >> SPI_CTAR_BR_SHIFT];
+}
+
+static uint32_t spi_ch1_setFrequency(uint32_t frequency)
+{
+	return setFrequency(SPI.ch1.periphery, frequency);
+}
+
+static uint32_t spi_ch2_setFrequency(uint32_t frequency)
+{
+	return setFrequency(SPI.ch2.periphery, frequency);
+}
+
+static uint32_t spi_ch1_getFrequency(void)
+{
+	return getFrequency(SPI.ch1.periphery);
+}
+
+static uint32_t spi_ch2_getFrequency(void)
+{
+	return getFrequency(SPI.ch2.periphery);
+}
+
 void reset_ch1()
 {
 	// configure SPI1 pins PORTB_PCR11(SCK), PORTB_PCR17(SDI), PORTB_PCR15(SDO), PORTB_PCR10(CSN)
@@ -186,16 +268,7 @@ int32_t spi_readInt(SPIChannelTypeDef *SPIChannel, uint8_t address)
 	// clear write bit
 	address &= 0x7F;
 
-	SPIChannel->readWrite(address, false);
-	int value = SPIChannel->readWrite(0, false);
-	value <<= 8;
-	value |= SPIChannel->readWrite(0, false);
-	value <<= 8;
-	value |= SPIChannel->readWrite(0, false);
-	value <<= 8;
-	value |= SPIChannel->readWrite(0, true);
-
-	return value;
+	return spi_datagram40(SPIChannel, address, 0);
 }
 
 int32_t spi_ch1_readInt(uint8_t address)
@@ -210,11 +283,7 @@ int32_t spi_ch2_readInt(uint8_t address)
 
 void spi_writeInt(SPIChannelTypeDef *SPIChannel, uint8_t address, int value)
 {
-	SPIChannel->readWrite(address|0x80, false);
-	SPIChannel->readWrite(0xFF & (value>>24), false);
-	SPIChannel->readWrite(0xFF & (value>>16), false);
-	SPIChannel->readWrite(0xFF & (value>>8), false);
-	SPIChannel->readWrite(0xFF & (value>>0), true);
+	spi_datagram40(SPIChannel, address|0x80, value);
 }
 
 void spi_ch1_writeInt(uint8_t address, int value)
@@ -227,6 +296,28 @@ void spi_ch2_writeInt(uint8_t address, int value)
 	spi_writeInt(SPIChannel_2_default, address, value);
 }
 
+/*
+ * Transfers a 40 bit TMC datagram (address byte and 32 bit value) and returns the 32 bit data of the reply.
+ * The bytes go through the TX FIFO in one go, see readWriteArray().
+ */
+int32_t spi_datagram40(SPIChannelTypeDef *SPIChannel, uint8_t address, int32_t value)
+{
+	uint8_t data[5] = { address, 0xFF & (value>>24), 0xFF & (value>>16), 0xFF & (value>>8), 0xFF & (value>>0) };
+
+	// A board may cover the channel by replacing its readWrite() - transfer byte wise through it then
+	if(SPIChannel->readWrite != spi_ch1_readWrite && SPIChannel->readWrite != spi_ch2_readWrite)
+	{
+		for(uint32_t i = 0; i < ARRAY_SIZE(data); i++)
+			data[i] = SPIChannel->readWrite(data[i], (i == ARRAY_SIZE(data) - 1)? true:false);
+
+		return (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+	}
+
+	readWriteArray(SPIChannel, data, ARRAY_SIZE(data));
+
+	return (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+}
+
 uint8_t spi_ch1_readWrite(uint8_t data, uint8_t lastTransfer)
 {
 	return readWrite(&SPI.ch1, data, lastTransfer);
@@ -239,18 +330,54 @@ uint8_t spi_ch2_readWrite(uint8_t data, uint8_t lastTransfer)
 
 static void spi_ch1_readWriteArray(uint8_t *data, size_t length)
 {
-	for(size_t i = 0; i < length; i++)
-	{
-		data[i] = readWrite(&SPI.ch1, data[i], (i == (length - 1))? true:false);
-	}
+	readWriteArray(&SPI.ch1, data, length);
 }
 
 static void spi_ch2_readWriteArray(uint8_t *data, size_t length)
 {
-	for(size_t i = 0; i < length; i++)
+	readWriteArray(&SPI.ch2, data, length);
+}
+
+/*
+ * Transfers the array with CSN held low. All bytes are pushed into the TX FIFO without waiting
+ * for the single replies, the RX FIFO is drained meanwhile - the SCK runs without gaps.
+ */
+static void readWriteArray(SPIChannelTypeDef *SPIChannel, uint8_t *data, size_t length)
+{
+	if(length == 0)
+		return;
+
+	if(IS_DUMMY_PIN(SPIChannel->CSN))
+	{
+		for(size_t i = 0; i < length; i++)
+			data[i] = 0;
+		return;
+	}
+
+	spi_acquireBus();
+	HAL.IOs->config->setLow(SPIChannel->CSN); // Chip Select
+
+	size_t sent = 0, received = 0;
+	while(received < length)
 	{
-		data[i] = readWrite(&SPI.ch2, data[i], (i == (length - 1))? true:false);
+		// keep the TX FIFO filled - not more than 4 bytes in flight, so the RX FIFO can't overflow
+		if(sent < length && (sent - received) < 4 && ((SPI_SR_REG(SPIChannel->periphery) & SPI_SR_TXCTR_MASK) >> SPI_SR_TXCTR_SHIFT) < 4)
+		{
+			SPI_PUSHR_REG(SPIChannel->periphery) = ((sent == length - 1)? SPI_PUSHR_EOQ_MASK : SPI_PUSHR_CONT_MASK) | SPI_PUSHR_TXDATA(data[sent]);
+			sent++;
+		}
+
+		if((SPI_SR_REG(SPIChannel->periphery) & SPI_SR_RXCTR_MASK) >> SPI_SR_RXCTR_SHIFT)
+			data[received++] = SPI_POPR_REG(SPIChannel->periphery);
 	}
+
+	SPI_SR_REG(SPIChannel->periphery) |= SPI_SR_EOQF_MASK;   // clear EOQ Flag by writing a 1 to EOQF
+
+	// clear TXF and RXF
+	SPI_MCR_REG(SPIChannel->periphery) |= SPI_MCR_CLR_RXF_MASK | SPI_MCR_CLR_TXF_MASK;
+
+	HAL.IOs->config->setHigh(SPIChannel->CSN);
+	spi_releaseBus();
 }
 
 uint8_t spi_ch1_readWriteByte(uint8_t data, uint8_t lastTransfer)
@@ -265,6 +392,12 @@ uint8_t readWrite(SPIChannelTypeDef *SPIChannel, uint8_t writeData, uint8_t last
 	if(IS_DUMMY_PIN(SPIChannel->CSN))
 		return 0;
 
+	if(!SPIChannel->transferActive)
+	{
+		SPIChannel->transferActive = true;
+		spi_acquireBus();
+	}
+
 	HAL.IOs->config->setLow(SPIChannel->CSN); // Chip Select
 
 	if(lastTransfer)
@@ -286,6 +419,9 @@ uint8_t readWrite(SPIChannelTypeDef *SPIChannel, uint8_t writeData, uint8_t last
 
 		// clear TXF and RXF
 		SPI_MCR_REG(SPIChannel->periphery) |= SPI_MCR_CLR_RXF_MASK | SPI_MCR_CLR_TXF_MASK;
+
+		SPIChannel->transferActive = false;
+		spi_releaseBus();
 	} else {
 		// continuous transfer
 		SPI_PUSHR_REG(SPIChannel->periphery) = SPI_PUSHR_CONT_MASK | SPI_PUSHR_TXDATA(writeData); // | SPI_PUSHR_PCS(0x0);
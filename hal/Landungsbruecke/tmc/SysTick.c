@@ -14,6 +14,11 @@ void systick_init()
 {
 	SYST_RVR  = 48000;
 	SYST_CSR  = 7;
+
+	// DWT cycle counter for runtime measurements
+	DEMCR     |= (1 << 24); // TRCENA
+	DWT_CYCCNT = 0;
+	DWT_CTRL  |= 1;         // CYCCNTENA
 }
 
 uint32_t systick_getTick()
@@ -21,6 +26,12 @@ uint32_t systick_getTick()
 	return systick;
 }
 
+// Free running core clock cycle counter (48 MHz), wraps after about 89 seconds
+uint32_t systick_getCycles()
+{
+	return DWT_CYCCNT;
+}
+
 /* Systick values are in milliseconds, accessing the value is faster. As a result
  * we have a random invisible delay of less than a millisecond whenever we use
  * systicks. This can result in a situation where we access the systick just before it changes:
@@ -15,11 +15,26 @@ static uint8_t rxN(uint8_t *ch, uint8_t number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
 
+static void lock(void);
+static void unlock(void);
+static void startTransaction(void);
+static void finishTransaction(UART_TransactionState state);
+static void receive(uint8_t byte);
+static void transmissionComplete(void);
+static void cancelTransactions(void);
+
 static volatile uint8_t
 	rxBuffer[BUFFER_SIZE],
 	txBuffer[BUFFER_SIZE];
 
-static volatile uint32_t available = 0;
+static UART_Transaction transactions[UART_TRANSACTION_QUEUE_SIZE];
+static volatile uint8_t transactionRead = 0;
+static volatile uint8_t transactionCount = 0;
+static volatile bool transactionActive = false;
+static uint32_t transactionStart;
+static uint8_t replyData[8];
+static uint8_t replyLength = 0;
+static uint32_t lockDepth = 0;
 
 UART_Config UART =
 {
@@ -39,22 +54,8 @@ UART_Config UART =
 	}
 };
 
-static RXTXBufferingTypeDef buffers =
-{
-	.rx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = rxBuffer
-	},
-
-	.tx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = txBuffer
-	}
-};
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
 
 static void init()
 {
@@ -164,12 +165,9 @@ void UART0_RX_TX_IRQHandler_UART(void)
 	if(status & UART_S1_RDRF_MASK)
 	{
 		// One-wire UART communication:
-		buffers.rx.buffer[buffers.rx.wrote] = UART0_D;
-		if(!isSending) // Only move ring buffer index & available counter when the received byte wasn't the send echo
-		{
-			buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-			available++;
-		}
+		uint8_t byte = UART0_D;
+		if(!isSending) // Only process the received byte when it wasn't the send echo
+			receive(byte);
 	}
 
 	// Transmission complete interrupt => do not ignore echo any more
@@ -179,16 +177,18 @@ void UART0_RX_TX_IRQHandler_UART(void)
 		// Last bit has been sent
 		isSending = false;
 		UART0_C2 &= ~UART_C2_TCIE_MASK;
+		if(ringbuffer_used(&txRing) == 0)
+			transmissionComplete();
 	}
 
 	// Transmit buffer empty interrupt => send next byte if there is something
 	// to be sent.
 	if(status & UART_S1_TDRE_MASK)
 	{
-		if(buffers.tx.read != buffers.tx.wrote)
+		uint8_t data;
+		if(ringbuffer_pop(&txRing, &data))
 		{
-			UART0_D = buffers.tx.buffer[buffers.tx.read];
-			buffers.tx.read = (buffers.tx.read + 1) % BUFFER_SIZE;
+			UART0_D = data;
 
 			isSending = true; // Ignore echo
 			UART0_C2 |= UART_C2_TCIE_MASK; // Turn on transmission complete interrupt
@@ -209,12 +209,9 @@ void UART2_RX_TX_IRQHandler(void)
 	if(status & UART_S1_RDRF_MASK)
 	{
 		// One-wire UART communication:
-		buffers.rx.buffer[buffers.rx.wrote] = UART2_D;
-		if(!isSending) // Only move ring buffer index & available counter when the received byte wasn't the send echo
-		{
-			buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-			available++;
-		}
+		uint8_t byte = UART2_D;
+		if(!isSending) // Only process the received byte when it wasn't the send echo
+			receive(byte);
 	}
 
 	// Transmission complete interrupt => do not ignore echo any more
@@ -224,16 +221,18 @@ void UART2_RX_TX_IRQHandler(void)
 		// Last bit has been sent
 		isSending = false;
 		UART2_C2 &= ~UART_C2_TCIE_MASK;
+		if(ringbuffer_used(&txRing) == 0)
+			transmissionComplete();
 	}
 
 	// Transmit buffer empty interrupt => send next byte if there is something
 	// to be sent.
 	if(status & UART_S1_TDRE_MASK)
 	{
-		if(buffers.tx.read != buffers.tx.wrote)
+		uint8_t data;
+		if(ringbuffer_pop(&txRing, &data))
 		{
-			UART2_D = buffers.tx.buffer[buffers.tx.read];
-			buffers.tx.read = (buffers.tx.read + 1) % BUFFER_SIZE;
+			UART2_D = data;
 
 			isSending = true; // Ignore echo
 			UART2_C2 |= UART_C2_TCIE_MASK; // Turn on transmission complete interrupt
@@ -245,63 +244,246 @@ void UART2_RX_TX_IRQHandler(void)
 	}
 }
 
-void UART_readInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t *value)
+// Lock out the UART interrupt. Nestable, as the transaction functions get called
+// from the interrupt as well as from the main loop and call each other.
+static void lock(void)
+{
+	switch(UART.pinout) {
+	case UART_PINS_2:
+		disable_irq(INT_UART0_RX_TX-16);
+		break;
+	case UART_PINS_1:
+	default:
+		disable_irq(INT_UART2_RX_TX-16);
+		break;
+	}
+	lockDepth++;
+}
+
+static void unlock(void)
+{
+	if(--lockDepth > 0)
+		return;
+
+	switch(UART.pinout) {
+	case UART_PINS_2:
+		enable_irq(INT_UART0_RX_TX-16);
+		break;
+	case UART_PINS_1:
+	default:
+		enable_irq(INT_UART2_RX_TX-16);
+		break;
+	}
+}
+
+// Send the datagram of the oldest queued transaction - called with the UART interrupt locked
+static void startTransaction(void)
 {
-	uint8_t readData[8], dataRequest[4];
-	uint32_t timeout;
+	UART_Transaction *transaction;
+	uint8_t datagram[8], length;
 
-	dataRequest[0] = 0x05;                        // Sync byte
-	dataRequest[1] = slave;                       // Slave address
-	dataRequest[2] = address;                     // Register address
-	dataRequest[3] = tmc_CRC8(dataRequest, 3, 1); // Cyclic redundancy check
+	if(transactionCount == 0)
+		return;
+
+	transaction = &transactions[transactionRead];
+
+	datagram[0] = 0x05;                          // Sync byte
+	datagram[1] = transaction->slave;            // Slave address
+	datagram[2] = transaction->address;          // Register address
+	if(transaction->address & TMC_WRITE_BIT)
+	{
+		datagram[3] = transaction->value >> 24;  // Register Data
+		datagram[4] = transaction->value >> 16;  // Register Data
+		datagram[5] = transaction->value >> 8;   // Register Data
+		datagram[6] = transaction->value & 0xFF; // Register Data
+		length = 8;
+	}
+	else
+	{
+		length = 4;
+	}
+	datagram[length-1] = tmc_CRC8(datagram, length-1, 1); // Cyclic redundancy check
+
+	transactionActive = true;
+	transactionStart  = systick_getTick();
+	replyLength       = 0;
+
+	txN(datagram, length);
+}
+
+// Complete the active transaction and start the next one - called with the UART interrupt locked
+static void finishTransaction(UART_TransactionState state)
+{
+	UART_Transaction transaction = transactions[transactionRead];
 
-	channel->rxtx.clearBuffers();
-	channel->rxtx.txN(dataRequest, ARRAY_SIZE(dataRequest));
+	transactionRead = (transactionRead + 1) % UART_TRANSACTION_QUEUE_SIZE;
+	transactionCount--;
+	transactionActive = false;
 
-	// Wait for reply with timeout limit
-	timeout = systick_getTick();
-	while(channel->rxtx.bytesAvailable() < ARRAY_SIZE(readData))
-		if(timeSince(timeout) > UART_TIMEOUT_VALUE) // Timeout
+	transaction.state = state;
+	if(transaction.callback)
+		transaction.callback(&transaction);
+
+	// The callback may have started a new transaction already
+	if(!transactionActive)
+		startTransaction();
+}
+
+// Received byte that is not the send echo
+static void receive(uint8_t byte)
+{
+	if(transactionActive && !(transactions[transactionRead].address & TMC_WRITE_BIT))
+	{
+		replyData[replyLength++] = byte;
+		if(replyLength < ARRAY_SIZE(replyData))
+			return;
+
+		// Check if the received data is correct (CRC, Sync, Master address, Register address)
+		// todo CHECK 2: Only keep CRC check? Should be sufficient for wrong transmissions (LH) #1
+		if(replyData[7] != tmc_CRC8(replyData, 7, 1) || replyData[0] != 0x05 || replyData[1] != 0xFF || replyData[2] != transactions[transactionRead].address)
+		{
+			finishTransaction(UART_TRANSACTION_CRC_ERROR);
 			return;
+		}
 
-	channel->rxtx.rxN(readData, ARRAY_SIZE(readData));
-	// Check if the received data is correct (CRC, Sync, Slave address, Register address)
-	// todo CHECK 2: Only keep CRC check? Should be sufficient for wrong transmissions (LH) #1
-	if(readData[7] != tmc_CRC8(readData, 7, 1) || readData[0] != 0x05 || readData[1] != 0xFF || readData[2] != address)
+		transactions[transactionRead].value = replyData[3] << 24 | replyData[4] << 16 | replyData[5] << 8 | replyData[6];
+		finishTransaction(UART_TRANSACTION_DONE);
 		return;
+	}
+
+	// No transaction waiting for a reply -> keep the byte for rx()
+	ringbuffer_push(&rxRing, byte);
+}
 
-	*value = readData[3] << 24 | readData[4] << 16 | readData[5] << 8 | readData[6];
-	return;
+// Last bit of the tx buffer has been sent
+static void transmissionComplete(void)
+{
+	// Write access is done as soon as the datagram is out, there is no reply
+	if(transactionActive && (transactions[transactionRead].address & TMC_WRITE_BIT))
+		finishTransaction(UART_TRANSACTION_DONE);
 }
 
+bool UART_submit(UART_Config *channel, const UART_Transaction *transaction)
+{
+	UNUSED(channel);
+
+	lock();
+	if(transactionCount >= UART_TRANSACTION_QUEUE_SIZE)
+	{
+		unlock();
+		return false;
+	}
+
+	UART_Transaction *queued = &transactions[(transactionRead + transactionCount) % UART_TRANSACTION_QUEUE_SIZE];
+	*queued = *transaction;
+	queued->state = UART_TRANSACTION_PENDING;
+	transactionCount++;
+
+	if(!transactionActive)
+		startTransaction();
+	unlock();
+
+	return true;
+}
+
+void UART_process(UART_Config *channel)
+{
+	UNUSED(channel);
+
+	lock();
+	if(transactionActive && timeSince(transactionStart) > UART_TIMEOUT_VALUE)
+		finishTransaction(UART_TRANSACTION_TIMEOUT);
+	unlock();
+}
+
+uint8_t UART_pendingTransactions(UART_Config *channel)
+{
+	UNUSED(channel);
+
+	return transactionCount;
+}
+
+typedef struct
+{
+	int32_t *value;
+	volatile bool done;
+} ReadIntResult;
+
+static void readIntCallback(UART_Transaction *transaction)
+{
+	ReadIntResult *result = transaction->user;
+
+	if(transaction->state == UART_TRANSACTION_DONE)
+		*result->value = transaction->value;
+
+	result->done = true;
+}
+
+// Blocking read for callers needing the value right away - only waits for this one datagram.
+// Prefer UART_readIntAsync() where the value can be handled later.
+// On timeout or transmission errors the value is left unchanged.
+void UART_readInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t *value)
+{
+	ReadIntResult result = { .value = value, .done = false };
+	UART_Transaction transaction =
+	{
+		.slave     = slave,
+		.address   = address & ~TMC_WRITE_BIT,
+		.callback  = readIntCallback,
+		.user      = &result
+	};
+
+	while(!UART_submit(channel, &transaction))
+		UART_process(channel);
+
+	while(!result.done)
+		UART_process(channel);
+}
+
+// Queues the read access and returns right away, the callback gets the value (transaction->value)
+// once the reply is in. false if the queue is full.
+bool UART_readIntAsync(UART_Config *channel, uint8_t slave, uint8_t address, void (*callback)(UART_Transaction *transaction), void *user)
+{
+	UART_Transaction transaction =
+	{
+		.slave     = slave,
+		.address   = address & ~TMC_WRITE_BIT,
+		.callback  = callback,
+		.user      = user
+	};
+
+	return UART_submit(channel, &transaction);
+}
+
+// Queues the write access and returns right away
 void UART_writeInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t value)
 {
-	uint8_t writeData[8];
-
-	writeData[0] = 0x05;                         // Sync byte
-	writeData[1] = slave;                        // Slave address
-	writeData[2] = address | TMC_WRITE_BIT;      // Register address with write bit set
-	writeData[3] = value >> 24;                  // Register Data
-	writeData[4] = value >> 16;                  // Register Data
-	writeData[5] = value >> 8;                   // Register Data
-	writeData[6] = value & 0xFF;                 // Register Data
-	writeData[7] = tmc_CRC8(writeData, 7, 1);    // Cyclic redundancy check
-
-	channel->rxtx.clearBuffers();
-	for(uint32_t i = 0; i < ARRAY_SIZE(writeData); i++)
-		channel->rxtx.tx(writeData[i]);
-
-	/* Workaround: Give the UART time to send. Otherwise another write/readRegister can do clearBuffers()
-	 * before we're done. This currently is an issue with the IDE when using the Register browser and the
-	 * periodic refresh of values gets requested right after the write request.
-	 */
-	wait(2);
+	UART_Transaction transaction =
+	{
+		.slave     = slave,
+		.address   = address | TMC_WRITE_BIT,
+		.value     = value,
+		.callback  = NULL
+	};
+
+	while(!UART_submit(channel, &transaction))
+		UART_process(channel);
 }
 
 static void tx(uint8_t ch)
 {
-	buffers.tx.buffer[buffers.tx.wrote] = ch;
-	buffers.tx.wrote = (buffers.tx.wrote + 1) % BUFFER_SIZE;
+	txN(&ch, 1);
+}
+
+static uint8_t rx(uint8_t *ch)
+{
+	return rxN(ch, 1);
+}
+
+static void txN(uint8_t *str, uint8_t number)
+{
+	if(!ringbuffer_pushN(&txRing, str, number))
+		return;
 
 	// enable send interrupt
 	switch(UART.pinout) {
@@ -315,62 +497,45 @@ static void tx(uint8_t ch)
 	}
 }
 
-static uint8_t rx(uint8_t *ch)
+static uint8_t rxN(uint8_t *str, uint8_t number)
 {
-	if(buffers.rx.read == buffers.rx.wrote)
-		return 0;
-
-	*ch = buffers.rx.buffer[buffers.rx.read];
-	buffers.rx.read = (buffers.rx.read + 1) % BUFFER_SIZE;
-	available--;
-
-	return 1;
+	return ringbuffer_popN(&rxRing, str, number);
 }
 
-static void txN(uint8_t *str, uint8_t number)
+// Drop all queued transactions - called with the UART interrupt locked.
+// The callbacks run after the queue is empty, so they may submit new transactions.
+static void cancelTransactions(void)
 {
-	for(int32_t i = 0; i < number; i++)
-		tx(str[i]);
-}
+	UART_Transaction dropped[UART_TRANSACTION_QUEUE_SIZE];
+	uint8_t count = transactionCount;
 
-static uint8_t rxN(uint8_t *str, uint8_t number)
-{
-	if(available < number)
-		return 0;
+	for(uint8_t i = 0; i < count; i++)
+		dropped[i] = transactions[(transactionRead + i) % UART_TRANSACTION_QUEUE_SIZE];
 
-	for(int32_t i = 0; i < number; i++)
-		rx(&str[i]);
+	transactionRead    = 0;
+	transactionCount   = 0;
+	transactionActive  = false;
 
-	return 1;
+	for(uint8_t i = 0; i < count; i++)
+	{
+		dropped[i].state = UART_TRANSACTION_CANCELLED;
+		if(dropped[i].callback)
+			dropped[i].callback(&dropped[i]);
+	}
 }
 
 static void clearBuffers(void)
 {
-	switch(UART.pinout) {
-	case UART_PINS_2:
-		disable_irq(INT_UART0_RX_TX-16);
-		available         = 0;
-		buffers.rx.read   = 0;
-		buffers.rx.wrote  = 0;
-		buffers.tx.read   = 0;
-		buffers.tx.wrote  = 0;
-		enable_irq(INT_UART0_RX_TX-16);
-		break;
-	case UART_PINS_1:
-	default:
-		disable_irq(INT_UART2_RX_TX-16);
-		available         = 0;
-		buffers.rx.read   = 0;
-		buffers.rx.wrote  = 0;
-		buffers.tx.read   = 0;
-		buffers.tx.wrote  = 0;
-		enable_irq(INT_UART2_RX_TX-16);
-		break;
-	}
+	lock();
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
+
+	cancelTransactions();
+	unlock();
 }
 
 static uint32_t bytesAvailable()
 {
-	return available;
+	return ringbuffer_used(&rxRing);
 }
 
@@ -7,6 +7,12 @@
 #include "hal/Landungsbruecke/freescale/USB_CDC/Rx1.h"
 #include "hal/Landungsbruecke/freescale/USB_CDC/CDC1.h"
 #include "hal/Landungsbruecke/freescale/USB_CDC/CS1.h"
+#include "hal/Landungsbruecke/freescale/USB_CDC/usb_descriptor.h"
+
+#define BUFFER_SIZE     1024  // Has to be a power of two
+#define PACKET_SIZE     DIC_BULK_IN_ENDP_PACKET_SIZE
+#define TRANSFER_SIZE   (4 * PACKET_SIZE)  // Largest block handed to the USB stack at once
+#define FLUSH_DELAY     1     // [ms] Partial packets wait this long for more data, so replies get coalesced
 
 extern uint8_t USB_DCI_DeInit(void);
 extern uint8_t USB_Class_CDC_DeInit(uint8_t controller_ID);
@@ -20,6 +26,20 @@ static void txN(uint8_t *str, uint8_t number);
 static uint8_t rxN(uint8_t *ch, uint8_t number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
+static uint32_t bytesFree();
+
+static void receivePacket(byte *data, word size);
+static void flush(void);
+
+static volatile uint8_t
+	rxBuffer[BUFFER_SIZE],
+	txBuffer[BUFFER_SIZE];
+
+// Owned by the USB stack while CDC1_TxBusy()
+static uint8_t txTransfer[TRANSFER_SIZE];
+
+static uint32_t lastWrite = 0;
+static bool zeroLengthPending = false;
 
 RXTXTypeDef USB =
 {
@@ -31,48 +51,88 @@ RXTXTypeDef USB =
 	.txN             = txN,
 	.clearBuffers    = clearBuffers,
 	.baudRate        = 115200,
-	.bytesAvailable  = bytesAvailable
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
 };
 
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
+
 void init()
 {
 	USB0_Init();
 	Tx1_Init();
 	Rx1_Init();
 	USB1_Init();
+	CDC1_SetRxPacketHandler(receivePacket);
 	enable_irq(INT_USB0-16);
 }
 
+// Called from the USB interrupt with a whole bulk OUT packet
+static void receivePacket(byte *data, word size)
+{
+	ringbuffer_pushN(&rxRing, data, size); // Packet dropped on overflow
+}
+
+// Hands the queued tx data to the USB stack. Full packets go out right away,
+// a partial packet once no more data came for FLUSH_DELAY. A transfer ending
+// with a full packet gets terminated by a zero length packet, otherwise the
+// host keeps waiting for more data.
+static void flush(void)
+{
+	if(CDC1_TxBusy())
+		return;
+
+	if(!CDC1_IsConnected())
+	{
+		// Nobody listening - drop the data instead of sending stale replies later
+		ringbuffer_clear(&txRing);
+		zeroLengthPending = false;
+		return;
+	}
+
+	uint32_t count = MIN(ringbuffer_used(&txRing), TRANSFER_SIZE);
+
+	if(count >= PACKET_SIZE)
+		count -= count % PACKET_SIZE;
+	else if(timeSince(lastWrite) < FLUSH_DELAY)
+		return;
+
+	if(count == 0)
+	{
+		if(zeroLengthPending && CDC1_SendPacket(txTransfer, 0) == ERR_OK)
+			zeroLengthPending = false;
+		return;
+	}
+
+	ringbuffer_popN(&txRing, txTransfer, count);
+	if(CDC1_SendPacket(txTransfer, count) == ERR_OK)
+		zeroLengthPending = (count % PACKET_SIZE) == 0;
+}
+
 uint8_t rx(uint8_t *ch)
 {
 	return rxN(ch,1);
 }
 
+// tmcl_process() polls rxN() (legacy datagrams) or bytesAvailable() (extended frames) every
+// main loop iteration. Both flush, so a short reply goes out once FLUSH_DELAY has passed.
 uint8_t rxN(uint8_t *str, uint8_t number)
 {
-	if(CDC1_GetCharsInRxBuf() >= number)
-	{
-		for(int32_t i = 0; i < number; i++)
-		{
-			if(CDC1_GetChar(&str[i])!= ERR_OK)
-				return false;
-		}
-		return true;
-	}
-	return false;
+	flush();
+	return ringbuffer_popN(&rxRing, str, number);
 }
 
 void tx(uint8_t ch)
 {
-	CDC1_SendChar(ch);
+	txN(&ch, 1);
 }
 
 void txN(uint8_t *str, uint8_t number)
 {
-	for(int32_t i = 0; i < number; i++)
-	{
-		tx(str[i]);
-	}
+	ringbuffer_pushN(&txRing, str, number); // Dropped if the host doesn't read
+	lastWrite = systick_getTick();
+	flush();
 }
 
 static void clearBuffers(void)
@@ -80,16 +140,26 @@ static void clearBuffers(void)
 	DisableInterrupts;
 	Tx1_Init();
 	Rx1_Init();
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
 	EnableInterrupts;
 }
 
 static uint32_t bytesAvailable()
 {
-	return CDC1_GetCharsInRxBuf();
+	flush();
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	flush();
+	return ringbuffer_free(&txRing);
 }
 
 static void deInit(void)
 {
+	CDC1_SetRxPacketHandler(NULL);
 	USB_DCI_DeInit();
 	USB_Class_CDC_DeInit(0);
 	USB_Class_DeInit(0);
@@ -4,7 +4,7 @@
 
 #include <string.h>
 
-#define BUFFER_SIZE           1024
+#define BUFFER_SIZE           1024  // Has to be a power of two
 #define WLAN_CMD_BUFFER_SIZE  128 // ascii command string buffer
 
 #define CMDBUFFER_END_CHAR '\0'
@@ -21,6 +21,10 @@ static void txN(uint8_t *str, uint8_t number);
 static uint8_t rxN(uint8_t *ch, uint8_t number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
+static uint32_t bytesFree();
+
+static void rawTxN(uint8_t *str, uint8_t number);
+static uint8_t rawRxN(uint8_t *str, uint8_t number);
 
 // ring buffers (used in BufferingTypedef struct)
 static volatile uint8_t rxBuffer[BUFFER_SIZE];
@@ -32,8 +36,6 @@ static uint32_t cmdEnabledTime; // systick timestamp when command mode sequence
 
 static WLANStateTypedef wlanState = WLAN_DATA_MODE;
 
-static volatile uint32_t available = 0;
-
 uint32_t UART0_TimeoutTimer;
 
 RXTXTypeDef WLAN =
@@ -46,26 +48,12 @@ RXTXTypeDef WLAN =
 	.txN             = txN,
 	.clearBuffers    = clearBuffers,
 	.baudRate        = 57600,
-	.bytesAvailable  = bytesAvailable
-
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
 };
 
-static RXTXBufferingTypeDef buffers =
-{
-	.rx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = rxBuffer
-	},
-
-	.tx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = txBuffer
-	}
-};
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
 
 static void init()
 {
@@ -120,9 +108,7 @@ void UART0_RX_TX_IRQHandler_WLAN(void)
 
 	if(status & UART_S1_RDRF_MASK)
 	{
-		buffers.rx.buffer[buffers.rx.wrote] = UART0_D;
-		buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-		available++;
+		ringbuffer_push(&rxRing, UART0_D); // Dropped if the buffer is full
 
 		// reset timeout value
 		UART0_TimeoutTimer = UART_TIMEOUT_VALUE;
@@ -131,10 +117,10 @@ void UART0_RX_TX_IRQHandler_WLAN(void)
 
 	if(status & UART_S1_TDRE_MASK)
 	{
-		if(buffers.tx.read != buffers.tx.wrote)
+		uint8_t data;
+		if(ringbuffer_pop(&txRing, &data))
 		{
-			UART0_D	= buffers.tx.buffer[buffers.tx.read];
-			buffers.tx.read = (buffers.tx.read + 1) % BUFFER_SIZE;
+			UART0_D	= data;
 		}
 		else // empty buffer -> turn off send interrupt
 		{
@@ -144,20 +130,25 @@ void UART0_RX_TX_IRQHandler_WLAN(void)
 	}
 }
 
-// Send without checking for CMD/Data mode
-static void rawTx(uint8_t ch)
+// Send without checking for CMD/Data mode.
+// Blocks not fitting into the free space get dropped.
+static void rawTxN(uint8_t *str, uint8_t number)
 {
 	if(wlanState == WLAN_INIT_CMD_MODE)
 		return;
 
-	buffers.tx.buffer[buffers.tx.wrote] = ch;
-
-	buffers.tx.wrote = (buffers.tx.wrote + 1) % BUFFER_SIZE;	// Move ring buffer index
+	if(!ringbuffer_pushN(&txRing, str, number))
+		return;
 
 	// enable send interrupt
 	UART0_C2 |= UART_C2_TIE_MASK;
 }
 
+static void rawTx(uint8_t ch)
+{
+	rawTxN(&ch, 1);
+}
+
 // Wrapper for rawTx, will silently fail if we're not in data mode
 // todo CHECK ADD 3: Should tx be given a return type in order to report failure to send? (LH) #1
 static void tx(uint8_t ch)
@@ -166,16 +157,15 @@ static void tx(uint8_t ch)
 		rawTx(ch);
 }
 
-static uint8_t rawRx(uint8_t *ch)
+// Receive without checking for CMD/Data mode
+static uint8_t rawRxN(uint8_t *str, uint8_t number)
 {
-	if(buffers.rx.read == buffers.rx.wrote)
-		return 0;
-
-	*ch = buffers.rx.buffer[buffers.rx.read];
-	buffers.rx.read = (buffers.rx.read + 1) % BUFFER_SIZE;	// Move ring buffer index
-	available--;
+	return ringbuffer_popN(&rxRing, str, number);
+}
 
-	return 1;
+static uint8_t rawRx(uint8_t *ch)
+{
+	return rawRxN(ch, 1);
 }
 
 static uint8_t rx(uint8_t *ch)
@@ -189,36 +179,35 @@ static uint8_t rx(uint8_t *ch)
 // todo CHECK ADD 3: Should txN be given a return type in order to report failure to send? (LH) #2
 static void txN(uint8_t *str, uint8_t number)
 {
-	for(int32_t i = 0; i < number; i++)
-		tx(str[i]);
+	if(checkReadyToSend())
+		rawTxN(str, number);
 }
 
 static uint8_t rxN(uint8_t *str, uint8_t number)
 {
-	if(available < number)
+	if(wlanState != WLAN_DATA_MODE)
 		return 0;
 
-	for(int32_t i = 0; i < number; i++)
-		rx(&str[i]);
-
-	return 1;
+	return rawRxN(str, number);
 }
 
 static void clearBuffers(void)
 {
 	disable_irq(INT_UART0_RX_TX-16);
-	available         = 0;
-	buffers.rx.read   = 0;
-	buffers.rx.wrote  = 0;
-
-	buffers.tx.read   = 0;
-	buffers.tx.wrote  = 0;
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
 	enable_irq(INT_UART0_RX_TX-16);
 }
 
 static uint32_t bytesAvailable()
 {
-	return available;
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	// txN() discards everything while the module is in command mode
+	return (checkReadyToSend())? ringbuffer_free(&txRing) : 0;
 }
 
 uint32_t checkReadyToSend()
@@ -258,7 +247,7 @@ uint32_t checkCmdModeEnabled()
 		return false;
 
 	uint8_t reply[4] = { 0 };	// expected reply: {'C','M','D'}, we're appending \0 so we have a NULL-terminated string that we can use in strcmp()
-	if(rxN(reply, 3))
+	if(rawRxN(reply, 3)) // Not in data mode yet - rxN() would refuse
 	{
 		if(strcmp((const char *)reply, "CMD") == 0)
 		{
@@ -2,6 +2,7 @@
 #define RXTX_H_
 
 #include "tmc/helpers/API_Header.h"
+#include "RingBuffer.h"
 
 #if defined(Landungsbruecke)
 typedef enum {
@@ -21,20 +22,8 @@ typedef struct
 	uint8_t (*rxN)(uint8_t *ch, unsigned char number);
 	void (*clearBuffers)(void);
 	uint32_t (*bytesAvailable)(void);
+	uint32_t (*bytesFree)(void);  // Bytes txN() can take right now without dropping
 	uint32_t baudRate;
 } RXTXTypeDef;
 
-typedef struct
-{
-	unsigned int read;
-	unsigned int wrote;
-	volatile uint8_t *buffer;
-} BufferingTypeDef;
-
-typedef struct
-{
-	BufferingTypeDef tx;
-	BufferingTypeDef rx;
-} RXTXBufferingTypeDef;
-
 #endif /* RXTX_H_ */
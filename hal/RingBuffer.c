@@ -0,0 +1,130 @@
+/*
+ * RingBuffer.c
+ *
+ * Single producer/single consumer ring buffer used by the RXTX interfaces.
+ * Bulk transfers copy at most two contiguous segments around the wrap and
+ * publish the new index once.
+ */
+
+#include <string.h>
+
+#include "RingBuffer.h"
+
+// Compiler barrier - the buffer contents have to be written/read before an index gets published.
+// The processors are single core, so this is all the ordering needed between interrupt and main loop.
+// The host build runs producer and consumer as threads on several cores and needs a real memory fence.
+#if defined(Host)
+#define BARRIER()  __sync_synchronize()
+#else
+#define BARRIER()  __asm__ volatile ("" ::: "memory")
+#endif
+
+uint32_t ringbuffer_used(RingBufferTypeDef *ring)
+{
+	return (ring->wrote - ring->read) & ring->mask;
+}
+
+uint32_t ringbuffer_free(RingBufferTypeDef *ring)
+{
+	return (ring->read - ring->wrote - 1) & ring->mask;
+}
+
+static void updateStatistics(RingBufferTypeDef *ring, uint32_t wrote)
+{
+	uint32_t used = (wrote - ring->read) & ring->mask;
+
+	if(used > ring->highWaterMark)
+		ring->highWaterMark = used;
+}
+
+bool ringbuffer_push(RingBufferTypeDef *ring, uint8_t data)
+{
+	uint32_t wrote = ring->wrote;
+	uint32_t next = (wrote + 1) & ring->mask;
+
+	if(next == ring->read)
+	{
+		ring->dropped++;
+		return false;
+	}
+
+	ring->buffer[wrote] = data;
+	BARRIER();
+	ring->wrote = next;
+	updateStatistics(ring, next);
+
+	return true;
+}
+
+bool ringbuffer_pushN(RingBufferTypeDef *ring, const uint8_t *data, uint32_t length)
+{
+	uint32_t wrote = ring->wrote;
+	uint32_t first = MIN(length, ring->mask + 1 - wrote);
+
+	if(length > ringbuffer_free(ring))
+	{
+		ring->dropped += length;
+		return false;
+	}
+
+	memcpy((uint8_t *) &ring->buffer[wrote], data, first);
+	memcpy((uint8_t *) &ring->buffer[0], data + first, length - first);
+	BARRIER();
+	ring->wrote = (wrote + length) & ring->mask;
+	updateStatistics(ring, ring->wrote);
+
+	return true;
+}
+
+bool ringbuffer_pop(RingBufferTypeDef *ring, uint8_t *data)
+{
+	uint32_t read = ring->read;
+
+	if(read == ring->wrote)
+		return false;
+
+	*data = ring->buffer[read];
+	BARRIER();
+	ring->read = (read + 1) & ring->mask;
+
+	return true;
+}
+
+bool ringbuffer_popN(RingBufferTypeDef *ring, uint8_t *data, uint32_t length)
+{
+	uint32_t read = ring->read;
+	uint32_t first = MIN(length, ring->mask + 1 - read);
+
+	if(length > ringbuffer_used(ring))
+		return false;
+
+	memcpy(data, (uint8_t *) &ring->buffer[read], first);
+	memcpy(data + first, (uint8_t *) &ring->buffer[0], length - first);
+	BARRIER();
+	ring->read = (read + length) & ring->mask;
+
+	return true;
+}
+
+// Read the byte at the given offset from the oldest one without removing it
+bool ringbuffer_peek(RingBufferTypeDef *ring, uint32_t offset, uint8_t *data)
+{
+	if(offset >= ringbuffer_used(ring))
+		return false;
+
+	*data = ring->buffer[(ring->read + offset) & ring->mask];
+
+	return true;
+}
+
+void ringbuffer_clear(RingBufferTypeDef *ring)
+{
+	ring->read   = 0;
+	ring->wrote  = 0;
+}
+
+void ringbuffer_resetStatistics(RingBufferTypeDef *ring)
+{
+	ring->highWaterMark  = 0;
+	ring->dropped        = 0;
+}
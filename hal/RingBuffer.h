@@ -0,0 +1,40 @@
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+	#include "tmc/helpers/API_Header.h"
+
+	/* Lock-free ring buffer for a single producer and a single consumer,
+	 * e.g. a receive interrupt and the main loop.
+	 * The producer only moves "wrote", the consumer only moves "read", so neither side
+	 * has to lock out the other. The size has to be a power of two, one byte stays
+	 * unused to tell a full from an empty buffer.
+	 */
+	typedef struct
+	{
+		volatile uint32_t read;
+		volatile uint32_t wrote;
+		uint32_t mask;                    // Buffer size - 1
+		volatile uint8_t *buffer;
+		volatile uint32_t highWaterMark;  // Highest fill level seen by the producer
+		volatile uint32_t dropped;        // Bytes rejected by the producer because the buffer was full
+	} RingBufferTypeDef;
+
+	#define RINGBUFFER_INIT(data) { .read = 0, .wrote = 0, .mask = ARRAY_SIZE(data) - 1, .buffer = data, .highWaterMark = 0, .dropped = 0 }
+
+	uint32_t ringbuffer_used(RingBufferTypeDef *ring);
+	uint32_t ringbuffer_free(RingBufferTypeDef *ring);
+
+	// Producer side
+	bool ringbuffer_push(RingBufferTypeDef *ring, uint8_t data);
+	bool ringbuffer_pushN(RingBufferTypeDef *ring, const uint8_t *data, uint32_t length);  // All or nothing
+
+	// Consumer side
+	bool ringbuffer_pop(RingBufferTypeDef *ring, uint8_t *data);
+	bool ringbuffer_popN(RingBufferTypeDef *ring, uint8_t *data, uint32_t length);        // All or nothing
+	bool ringbuffer_peek(RingBufferTypeDef *ring, uint32_t offset, uint8_t *data);
+
+	// Only with both sides stopped
+	void ringbuffer_clear(RingBufferTypeDef *ring);
+	void ringbuffer_resetStatistics(RingBufferTypeDef *ring);
+
+#endif /* RINGBUFFER_H_ */
@@ -4,10 +4,15 @@
 	#include "derivative.h"
 	#include "IOs.h"
 
+	// setFrequency() argument to restore the default SCK frequency of a channel
+	#define SPI_FREQUENCY_DEFAULT  0
+
 	typedef struct
 	{
-		#ifdef Startrampe
+		#if defined(Startrampe)
 			SPI_TypeDef *periphery; // pointer to ST SPI configuration structure
+		#elif defined(Host)
+			HostSPI_MemMapPtr periphery; // pointer to simulated SPI bus
 		#else
 			SPI_MemMapPtr periphery; // pointer to freescale SPI memory base pointer
 		#endif
@@ -16,6 +21,9 @@
 		unsigned char (*readWrite) (unsigned char data, unsigned char lastTransfer);
 		void (*readWriteArray) (uint8_t *data, size_t length);
 		void (*reset) (void);
+		uint32_t (*setFrequency) (uint32_t frequency);  // sets the highest possible SCK frequency not above the given one [Hz], returns the set frequency
+		uint32_t (*getFrequency) (void);
+		bool transferActive;  // readWrite() holds the bus owner from the first byte until the last one
 	} SPIChannelTypeDef;
 
 	typedef struct
@@ -27,10 +35,29 @@
 
 	SPITypeDef SPI;
 
+	// Bus owner of the main loop, counts the nested holds (defined by the SPI.c of each HAL).
+	// The transfer functions hold the bus for each datagram, including the time after CSN
+	// is released until the reply is read. Callers hold it across several datagrams that
+	// belong together, e.g. both datagrams of a read from a chip with delayed replies.
+	// Interrupts transferring on their own (RAMDebug register channels) skip while it is held.
+	extern volatile uint32_t spiBusOwner;
+
+	#if defined(Host)
+		// The simulated interrupts run in threads of their own - wait for a running one to finish
+		static inline void spi_acquireBus(void)  { host_irq_disable(); spiBusOwner++; host_irq_enable(); }
+	#else
+		static inline void spi_acquireBus(void)  { spiBusOwner++; }
+	#endif
+	static inline void spi_releaseBus(void)  { spiBusOwner--; }
+	static inline bool spi_busOwned(void)    { return spiBusOwner != 0; }
+
 	// read/write 32 bit value at address
 	int32_t spi_readInt(SPIChannelTypeDef *SPIChannel, uint8_t address);
 	void spi_writeInt(SPIChannelTypeDef *SPIChannel, uint8_t address, int value);
 
+	// transfer a 40 bit datagram (address byte, 32 bit value), returns the 32 bit reply data
+	int32_t spi_datagram40(SPIChannelTypeDef *SPIChannel, uint8_t address, int32_t value);
+
 	// for default channels
 	uint8_t spi_ch1_readWriteByte(uint8_t data, uint8_t lastTransfer);
 
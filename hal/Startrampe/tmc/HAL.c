@@ -13,6 +13,10 @@ static const IOsFunctionsTypeDef IOFunctions =
 	.pins    = &IOMap,
 };
 
+// Nesting state of DisableInterrupts/EnableInterrupts, see hal/derivative.h
+uint32_t interruptLockDepth = 0;
+uint32_t interruptLockPrimask = 0;
+
 const HALTypeDef HAL =
 {
 	.init         = init,
@@ -1,7 +1,7 @@
 #include "hal/HAL.h"
 #include "hal/RS232.h"
 
-#define BUFFER_SIZE  1024
+#define BUFFER_SIZE  1024  // Has to be a power of two
 #define INTR_PRI     6
 
 static void init();
@@ -12,13 +12,12 @@ static void txN(uint8_t *str, unsigned char number);
 static uint8_t rxN(uint8_t *ch, unsigned char number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
+static uint32_t bytesFree();
 
 static volatile uint8_t
 	rxBuffer[BUFFER_SIZE],
 	txBuffer[BUFFER_SIZE];
 
-static uint32_t available = 0;
-
 RXTXTypeDef RS232 =
 {
 	.init            = init,
@@ -29,25 +28,12 @@ RXTXTypeDef RS232 =
 	.txN             = txN,
 	.clearBuffers    = clearBuffers,
 	.baudRate        = 115200,
-	.bytesAvailable  = bytesAvailable
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
 };
 
-static RXTXBufferingTypeDef buffers =
-{
-	.rx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = rxBuffer
-	},
-
-	.tx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = txBuffer
-	}
-};
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
 
 void __attribute__ ((interrupt)) USART6_IRQHandler(void);
 
@@ -123,17 +109,15 @@ void USART6_IRQHandler(void)
 {
 	if(USART6->SR & USART_FLAG_RXNE)
 	{
-		buffers.rx.buffer[buffers.rx.wrote] = USART6->DR;
-		buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-		available++;
+		ringbuffer_push(&rxRing, USART6->DR); // Dropped if the buffer is full
 	}
 
 	if(USART6->SR & USART_FLAG_TXE)
 	{
-		if(buffers.tx.read != buffers.tx.wrote)
+		uint8_t data;
+		if(ringbuffer_pop(&txRing, &data))
 		{
-			USART6->DR	= buffers.tx.buffer[buffers.tx.read];
-			buffers.tx.read = (buffers.tx.read + 1) % BUFFER_SIZE;
+			USART6->DR	= data;
 		}
 		else
 		{
@@ -147,54 +131,43 @@ void USART6_IRQHandler(void)
 
 static void tx(uint8_t ch)
 {
-	buffers.tx.buffer[buffers.tx.wrote] = ch;
-	buffers.tx.wrote = (buffers.tx.wrote + 1) % BUFFER_SIZE;
-	USART_ITConfig(USART6, USART_IT_TXE, ENABLE);
+	txN(&ch, 1);
 }
 
 static uint8_t rx(uint8_t *ch)
 {
-	if(buffers.rx.read == buffers.rx.wrote)
-		return 0;
-
-	*ch = buffers.rx.buffer[buffers.rx.read];
-	buffers.rx.read = (buffers.rx.read + 1) % BUFFER_SIZE;
-	available--;
-
-	return 1;
+	return rxN(ch, 1);
 }
 
+// Blocks not fitting into the free space get dropped
 static void txN(uint8_t *str, unsigned char number)
 {
-	for(int32_t i = 0; i < number; i++)
-		tx(str[i]);
+	if(!ringbuffer_pushN(&txRing, str, number))
+		return;
+
+	USART_ITConfig(USART6, USART_IT_TXE, ENABLE);
 }
 
 static uint8_t rxN(uint8_t *str, unsigned char number)
 {
-	if(bytesAvailable() < number)
-		return 0;
-
-	for(int32_t i = 0; i < number; i++)
-		rx(&str[i]);
-
-	return 1;
+	return ringbuffer_popN(&rxRing, str, number);
 }
 
 static void clearBuffers(void)
 {
 	__disable_irq();
-	available         = 0;
-	buffers.rx.read   = 0;
-	buffers.rx.wrote  = 0;
-
-	buffers.tx.read   = 0;
-	buffers.tx.wrote  = 0;
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
 	__enable_irq();
 }
 
 static uint32_t bytesAvailable()
 {
-	return available;
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	return ringbuffer_free(&txRing);
 }
 
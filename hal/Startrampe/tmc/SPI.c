@@ -10,10 +10,18 @@ static unsigned char spi_ch1_readWrite(uint8_t data, uint8_t lastTransfer);
 static unsigned char spi_ch2_readWrite(uint8_t data, uint8_t lastTransfer);
 static void spi_ch1_readWriteArray(uint8_t *data, size_t length);
 static void spi_ch2_readWriteArray(uint8_t *data, size_t length);
+static uint32_t setFrequency(SPI_TypeDef *periphery, uint32_t frequency, uint16_t defaultPrescaler);
+static uint32_t getFrequency(SPI_TypeDef *periphery);
+static uint32_t spi_ch1_setFrequency(uint32_t frequency);
+static uint32_t spi_ch2_setFrequency(uint32_t frequency);
+static uint32_t spi_ch1_getFrequency(void);
+static uint32_t spi_ch2_getFrequency(void);
 
 SPIChannelTypeDef *SPIChannel_1_default;
 SPIChannelTypeDef *SPIChannel_2_default;
 
+volatile uint32_t spiBusOwner = 0;
+
 static IOPinTypeDef IODummy = { .bitWeight = DUMMY_BITWEIGHT };
 
 SPITypeDef SPI=
@@ -24,7 +32,9 @@ SPITypeDef SPI=
 		.CSN             = &IODummy,
 		.readWrite       = spi_ch1_readWrite,
 		.readWriteArray  = spi_ch1_readWriteArray,
-		.reset           = reset_ch1
+		.reset           = reset_ch1,
+		.setFrequency    = spi_ch1_setFrequency,
+		.getFrequency    = spi_ch1_getFrequency
 	},
 
 	.ch2 =
@@ -33,7 +43,9 @@ SPITypeDef SPI=
 		.CSN             = &IODummy,
 		.readWrite       = spi_ch2_readWrite,
 		.readWriteArray  = spi_ch2_readWriteArray,
-		.reset           = reset_ch2
+		.reset           = reset_ch2,
+		.setFrequency    = spi_ch2_setFrequency,
+		.getFrequency    = spi_ch2_getFrequency
 	},
 	.init = init
 };
@@ -94,6 +106,61 @@ static void init(void)
 	SPIChannel_2_default->CSN = &HAL.IOs->pins->SPI2_CSN0;
 }
 
+// SPI2 and SPI3 run on APB1: SCK = PCLK1 / 2^(BR+1)
+static uint32_t setFrequency(SPI_TypeDef *periphery, uint32_t frequency, uint16_t defaultPrescaler)
+{
+	uint16_t prescaler = defaultPrescaler;
+
+	if(frequency != SPI_FREQUENCY_DEFAULT)
+	{
+		RCC_ClocksTypeDef clocks;
+		RCC_GetClocksFreq(&clocks);
+
+		uint16_t br;
+		for(br = 0; br < 7; br++)
+			if((clocks.PCLK1_Frequency >> (br + 1)) <= frequency)
+				break;
+
+		prescaler = br << 3;
+	}
+
+	// The prescaler must not be changed during a transfer
+	while(SPI_I2S_GetFlagStatus(periphery, SPI_I2S_FLAG_BSY) == SET) {};
+	SPI_Cmd(periphery, DISABLE);
+	periphery->CR1 = (periphery->CR1 & ~SPI_BaudRatePrescaler_256) | prescaler;
+	SPI_Cmd(periphery, ENABLE);
+
+	return getFrequency(periphery);
+}
+
+static uint32_t getFrequency(SPI_TypeDef *periphery)
+{
+	RCC_ClocksTypeDef clocks;
+	RCC_GetClocksFreq(&clocks);
+
+	return clocks.PCLK1_Frequency >> (((periphery->CR1 & SPI_BaudRatePrescaler_256) >> 3) + 1);
+}
+
+static uint32_t spi_ch1_setFrequency(uint32_t frequency)
+{
+	return setFrequency(SPI.ch1.periphery, frequency, SPI_BaudRatePrescaler_32);
+}
+
+static uint32_t spi_ch2_setFrequency(uint32_t frequency)
+{
+	return setFrequency(SPI.ch2.periphery, frequency, SPI_BaudRatePrescaler_8);
+}
+
+static uint32_t spi_ch1_getFrequency(void)
+{
+	return getFrequency(SPI.ch1.periphery);
+}
+
+static uint32_t spi_ch2_getFrequency(void)
+{
+	return getFrequency(SPI.ch2.periphery);
+}
+
 static void reset_ch1()
 {
 	SPI.ch1.CSN        = &IODummy;
@@ -113,16 +180,7 @@ int32_t spi_readInt(SPIChannelTypeDef *SPIChannel, uint8_t address)
 	// clear write bit
 	address &= 0x7F;
 
-	SPIChannel->readWrite(address, false);
-	int value = SPIChannel->readWrite(0, false);
-	value <<= 8;
-	value |= SPIChannel->readWrite(0, false);
-	value <<= 8;
-	value |= SPIChannel->readWrite(0, false);
-	value <<= 8;
-	value |= SPIChannel->readWrite(0, true);
-
-	return value;
+	return spi_datagram40(SPIChannel, address, 0);
 }
 
 int32_t spi_ch1_readInt(uint8_t address)
@@ -137,11 +195,7 @@ int32_t spi_ch2_readInt(uint8_t address)
 
 void spi_writeInt(SPIChannelTypeDef *SPIChannel, uint8_t address, int value)
 {
-	SPIChannel->readWrite(address | 0x80, false);
-	SPIChannel->readWrite(0xFF & (value>>24), false);
-	SPIChannel->readWrite(0xFF & (value>>16), false);
-	SPIChannel->readWrite(0xFF & (value>>8), false);
-	SPIChannel->readWrite(0xFF & (value>>0), true);
+	spi_datagram40(SPIChannel, address | 0x80, value);
 }
 
 void spi_ch1_writeInt(uint8_t address, int value)
@@ -154,6 +208,49 @@ void spi_ch2_writeInt(uint8_t address, int value)
 	spi_writeInt(SPIChannel_2_default, address, value);
 }
 
+/*
+ * Transfers a 40 bit TMC datagram (address byte and 32 bit value) and returns the 32 bit data of the reply.
+ * The next byte is written into the TX buffer while the previous one is still shifted out, so the SCK runs without gaps.
+ */
+int32_t spi_datagram40(SPIChannelTypeDef *SPIChannel, uint8_t address, int32_t value)
+{
+	uint8_t data[5] = { address, 0xFF & (value>>24), 0xFF & (value>>16), 0xFF & (value>>8), 0xFF & (value>>0) };
+
+	// A board may cover the channel by replacing its readWrite() - transfer byte wise through it then
+	if(SPIChannel->readWrite != spi_ch1_readWrite && SPIChannel->readWrite != spi_ch2_readWrite)
+	{
+		for(uint32_t i = 0; i < ARRAY_SIZE(data); i++)
+			data[i] = SPIChannel->readWrite(data[i], (i == ARRAY_SIZE(data) - 1)? true:false);
+
+		return (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+	}
+
+	if(IS_DUMMY_PIN(SPIChannel->CSN))
+		return 0;
+
+	spi_acquireBus();
+	HAL.IOs->config->setLow(SPIChannel->CSN); // Chip Select
+
+	while(SPI_I2S_GetFlagStatus(SPIChannel->periphery, SPI_I2S_FLAG_TXE) == RESET) {};
+	SPI_I2S_SendData(SPIChannel->periphery, data[0]);
+
+	for(uint32_t i = 1; i < ARRAY_SIZE(data); i++)
+	{
+		while(SPI_I2S_GetFlagStatus(SPIChannel->periphery, SPI_I2S_FLAG_TXE) == RESET) {};
+		SPI_I2S_SendData(SPIChannel->periphery, data[i]);
+		while(SPI_I2S_GetFlagStatus(SPIChannel->periphery, SPI_I2S_FLAG_RXNE) == RESET) {};
+		data[i-1] = SPI_I2S_ReceiveData(SPIChannel->periphery);
+	}
+
+	while(SPI_I2S_GetFlagStatus(SPIChannel->periphery, SPI_I2S_FLAG_RXNE) == RESET) {};
+	data[4] = SPI_I2S_ReceiveData(SPIChannel->periphery);
+
+	HAL.IOs->config->setHigh(SPIChannel->CSN);
+	spi_releaseBus();
+
+	return (data[1] << 24) | (data[2] << 16) | (data[3] << 8) | data[4];
+}
+
 static unsigned char spi_ch1_readWrite(unsigned char data, unsigned char lastTransfer)
 {
 	 return readWrite(&SPI.ch1, data, lastTransfer);
@@ -190,13 +287,25 @@ static unsigned char readWrite(SPIChannelTypeDef *SPIChannel, uint8_t data, uint
 	if(IS_DUMMY_PIN(SPIChannel->CSN))
 		return 0;
 
+	if(!SPIChannel->transferActive)
+	{
+		SPIChannel->transferActive = true;
+		spi_acquireBus();
+	}
+
 	HAL.IOs->config->setLow(SPIChannel->CSN);
 
 	while(SPI_I2S_GetFlagStatus(SPIChannel->periphery, SPI_I2S_FLAG_TXE) == RESET) {};
 	SPI_I2S_SendData(SPIChannel->periphery, data);
 	while(SPI_I2S_GetFlagStatus(SPIChannel->periphery, SPI_I2S_FLAG_RXNE) == RESET) {};
+	data = SPI_I2S_ReceiveData(SPIChannel->periphery);
+
 	if(lastTransfer)
+	{
 		HAL.IOs->config->setHigh(SPIChannel->CSN);
+		SPIChannel->transferActive = false;
+		spi_releaseBus();
+	}
 
-	return SPI_I2S_ReceiveData(SPIChannel->periphery);
+	return data;
 }
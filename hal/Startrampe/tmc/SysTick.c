@@ -1,6 +1,10 @@
 #include "hal/HAL.h"
 #include "hal/SysTick.h"
 
+// The CMSIS header of the standard peripheral library has no DWT definitions
+#define DWT_CTRL    (*(volatile uint32_t *) 0xE0001000)
+#define DWT_CYCCNT  (*(volatile uint32_t *) 0xE0001004)
+
 volatile uint32_t systick = 0;
 
 void __attribute__ ((interrupt)) SysTick_Handler(void);
@@ -14,6 +18,11 @@ void systick_init()
 {
 	SysTick_Config(15000);
 	SysTick_CLKSourceConfig(SysTick_CLKSource_HCLK_Div8);
+
+	// DWT cycle counter for runtime measurements
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT_CYCCNT  = 0;
+	DWT_CTRL   |= 1; // CYCCNTENA
 }
 
 uint32_t systick_getTick()
@@ -21,6 +30,12 @@ uint32_t systick_getTick()
 	return systick;
 }
 
+// Free running core clock cycle counter (120 MHz), wraps after about 35 seconds
+uint32_t systick_getCycles()
+{
+	return DWT_CYCCNT;
+}
+
 /* Systick values are in milliseconds, accessing the value is faster. As a result
  * we have a random invisible delay of less than a millisecond whenever we use
  * systicks. This can result in a situation where we access the systick just before it changes:
@@ -44,33 +44,21 @@ static void txN(uint8_t *str, unsigned char number);
 static uint8_t rxN(uint8_t *ch, unsigned char number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
+static uint32_t bytesFree();
 extern void USBD_GetString(uint8_t *desc, uint8_t *unicode, uint16_t *len);
 
 USB_OTG_CORE_HANDLE USB_OTG_dev;  // Handle for USB Core Functions
 extern uint8_t  APP_Rx_Buffer[];  // TX Buffer
 extern uint32_t APP_Rx_ptr_in;    // TX ptr
+extern uint32_t APP_Rx_ptr_out;   // TX ptr of the CDC stack
 
 
 static volatile uint8_t rxBuffer[BUFFER_SIZE];
 
-static volatile uint32_t available = 0;
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
 
-static RXTXBufferingTypeDef buffers =
-{
-	.rx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = rxBuffer
-	},
-
-	.tx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = APP_Rx_Buffer
-	}
-};
+// The tx data goes to the buffer of the CDC stack directly
+static uint32_t txWrote = 0;
 
 RXTXTypeDef USB =
 {
@@ -82,7 +70,8 @@ RXTXTypeDef USB =
 	.txN             = txN,
 	.clearBuffers    = clearBuffers,
 	.baudRate        = 115200,
-	.bytesAvailable  = bytesAvailable
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
 };
 
 typedef struct
@@ -415,12 +404,7 @@ static uint16_t VCP_DataTx (uint8_t* Buf, uint32_t Len)
 
 static uint16_t VCP_DataRx (uint8_t* Buf, uint32_t Len)
 {
-	for(uint32_t i = 0; i < Len; i++)
-	{
-		buffers.rx.buffer[buffers.rx.wrote] = Buf[i];
-		buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-		available++;
-	}
+	ringbuffer_pushN(&rxRing, Buf, Len); // Packet dropped if the buffer is full
 
 	return USBD_OK;
 }
@@ -454,20 +438,14 @@ static void init(void)
 
 static void tx(uint8_t ch)
 {
-	buffers.tx.buffer[buffers.tx.wrote] = ch;
-	buffers.tx.wrote = (buffers.tx.wrote + 1) % BUFFER_SIZE;
-	APP_Rx_ptr_in = buffers.tx.wrote;
+	APP_Rx_Buffer[txWrote] = ch;
+	txWrote = (txWrote + 1) % BUFFER_SIZE;
+	APP_Rx_ptr_in = txWrote;
 }
 
 static uint8_t rx(uint8_t *ch)
 {
-	if(!available)
-		return 0;
-	*ch = buffers.rx.buffer[buffers.rx.read];
-	buffers.rx.read = (buffers.rx.read + 1) % BUFFER_SIZE;
-	available--;
-
-	return 1;
+	return rxN(ch, 1);
 }
 
 static void txN(uint8_t *str, unsigned char number)
@@ -478,30 +456,26 @@ static void txN(uint8_t *str, unsigned char number)
 
 static uint8_t rxN(uint8_t *str, unsigned char number)
 {
-	if(bytesAvailable() < number)
-		return 0;
-
-	for(int32_t i = 0; i < number; i++)
-		rx(&str[i]);
-
-	return 1;
+	return ringbuffer_popN(&rxRing, str, number);
 }
 
 static void clearBuffers(void)
 {
 	__disable_irq();
-	available         = 0;
-	buffers.rx.read   = 0;
-	buffers.rx.wrote  = 0;
-
-	buffers.tx.read   = 0;
-	buffers.tx.wrote  = 0;
+	ringbuffer_clear(&rxRing);
+	txWrote = 0;
 	__enable_irq();
 }
 
 static uint32_t bytesAvailable()
 {
-	return available;
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	// One byte stays unused, the CDC stack takes equal pointers as an empty buffer
+	return (APP_Rx_ptr_out - txWrote - 1) % BUFFER_SIZE;
 }
 
 static void deInit(void)
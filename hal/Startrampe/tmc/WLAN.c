@@ -3,7 +3,7 @@
 #include "hal/WLAN.h"
 #include "hal/RXTX.h"
 
-#define BUFFER_SIZE  1024
+#define BUFFER_SIZE  1024  // Has to be a power of two
 #define INTR_PRI     6
 
 static void init();
@@ -14,12 +14,11 @@ static void txN(uint8_t *str, unsigned char number);
 static uint8_t rxN(uint8_t *ch, unsigned char number);
 static void clearBuffers(void);
 static uint32_t bytesAvailable();
+static uint32_t bytesFree();
 
 static volatile uint8_t rxBuffer[BUFFER_SIZE];
 static volatile uint8_t txBuffer[BUFFER_SIZE];
 
-static volatile uint32_t available = 0;
-
 RXTXTypeDef WLAN =
 {
 	.init            = init,
@@ -30,25 +29,12 @@ RXTXTypeDef WLAN =
 	.txN             = txN,
 	.clearBuffers    = clearBuffers,
 	.baudRate        = 115200,
-	.bytesAvailable  = bytesAvailable
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
 };
 
-static RXTXBufferingTypeDef buffers =
-{
-	.rx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = rxBuffer
-	},
-
-	.tx =
-	{
-		.read    = 0,
-		.wrote   = 0,
-		.buffer  = txBuffer
-	}
-};
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
 
 
 void __attribute__ ((interrupt)) USART3_IRQHandler(void);
@@ -129,17 +115,15 @@ void USART3_IRQHandler(void)
 {
 	if(USART3->SR & USART_FLAG_RXNE)
 	{
-		buffers.rx.buffer[buffers.rx.wrote] = USART3->DR;
-		buffers.rx.wrote = (buffers.rx.wrote + 1) % BUFFER_SIZE;
-		available++;
+		ringbuffer_push(&rxRing, USART3->DR); // Dropped if the buffer is full
 	}
 
 	if(USART3->SR & USART_FLAG_TXE)
 	{
-		if(buffers.tx.read != buffers.tx.wrote)
+		uint8_t data;
+		if(ringbuffer_pop(&txRing, &data))
 		{
-			USART3->DR	= buffers.tx.buffer[buffers.tx.read];
-			buffers.tx.read = (buffers.tx.read + 1) % BUFFER_SIZE;
+			USART3->DR	= data;
 		}
 		else
 		{
@@ -155,55 +139,44 @@ void USART3_IRQHandler(void)
 
 static void tx(uint8_t ch)
 {
-	buffers.tx.buffer[buffers.tx.wrote] = ch;
-	buffers.tx.wrote = (buffers.tx.wrote + 1) % BUFFER_SIZE;
-	USART_ITConfig(USART3, USART_IT_TXE, ENABLE);
+	txN(&ch, 1);
 }
 
 static uint8_t rx(uint8_t *ch)
 {
-	if(buffers.rx.read == buffers.rx.wrote)
-		return 0;
-
-	*ch = buffers.rx.buffer[buffers.rx.read];
-	buffers.rx.read = (buffers.rx.read + 1) % BUFFER_SIZE;
-	available--;
-
-	return 1;
+	return rxN(ch, 1);
 }
 
+// Blocks not fitting into the free space get dropped
 static void txN(uint8_t *str, unsigned char number)
 {
-	for(int32_t i = 0; i < number; i++)
-		tx(str[i]);
+	if(!ringbuffer_pushN(&txRing, str, number))
+		return;
+
+	USART_ITConfig(USART3, USART_IT_TXE, ENABLE);
 }
 
 static uint8_t rxN(uint8_t *str, unsigned char number)
 {
-	if(bytesAvailable() < number)
-		return 0;
-
-	for(int32_t i = 0; i < number; i++)
-		rx(&str[i]);
-
-	return 1;
+	return ringbuffer_popN(&rxRing, str, number);
 }
 
 static void clearBuffers(void)
 {
 	__disable_irq();
-	available         = 0;
-	buffers.rx.read   = 0;
-	buffers.rx.wrote  = 0;
-
-	buffers.tx.read   = 0;
-	buffers.tx.wrote  = 0;
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
 	__enable_irq();
 }
 
 static uint32_t bytesAvailable()
 {
-	return available;
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree()
+{
+	return ringbuffer_free(&txRing);
 }
 
 // todo ADD 3: Implement WLAN Configuration functionality for Startrampe (LH)
@@ -7,5 +7,6 @@
 	uint32_t systick_getTick();
 	void wait(uint32_t delay);
 	uint32_t timeSince(uint32_t tick);
+	uint32_t systick_getCycles();
 
 #endif /* SysTick_H */
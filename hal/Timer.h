@@ -3,7 +3,7 @@
 
 #include "derivative.h"
 
-#if defined(Landungsbruecke)
+#if defined(Landungsbruecke) || defined(Host)
 #define TIMER_MAX 8000
 #elif defined(Startrampe)
 #define TIMER_MAX 10000 // Frequenz von 6kHz => 166,66us pro Periode => 8000 Schritte bei 48Mhz
@@ -20,10 +20,42 @@ typedef struct {
 	RXTXTypeDef rxtx;
 } UART_Config;
 
+#define UART_TRANSACTION_QUEUE_SIZE  16
+
+typedef enum {
+	UART_TRANSACTION_PENDING,
+	UART_TRANSACTION_DONE,
+	UART_TRANSACTION_TIMEOUT,
+	UART_TRANSACTION_CRC_ERROR, // Reply with wrong CRC, sync byte or register address
+	UART_TRANSACTION_CANCELLED  // Dropped from the queue by clearBuffers()
+} UART_TransactionState;
+
+/* Register access on the TMC UART bus.
+ * Transactions get copied into a queue by UART_submit() and are sent one after another,
+ * driven by the UART interrupt. The callback is called on completion - from the
+ * interrupt, from UART_process() on a timeout or from clearBuffers() when the queue gets
+ * dropped. A callback may submit new transactions.
+ */
+typedef struct UART_Transaction UART_Transaction;
+struct UART_Transaction
+{
+	uint8_t slave;                                    // Slave address
+	uint8_t address;                                  // Register address, TMC_WRITE_BIT set for write access
+	int32_t value;                                    // Write data / received data of a completed read
+	UART_TransactionState state;
+	void (*callback)(UART_Transaction *transaction);  // May be NULL
+	void *user;                                       // Free for use by the callback
+};
+
 UART_Config UART;
 
 void UART0_RX_TX_IRQHandler_UART(void);
 void UART_readInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t *value);
+bool UART_readIntAsync(UART_Config *channel, uint8_t slave, uint8_t address, void (*callback)(UART_Transaction *transaction), void *user);
 void UART_writeInt(UART_Config *channel, uint8_t slave, uint8_t address, int32_t value);
 
+bool UART_submit(UART_Config *channel, const UART_Transaction *transaction); // false if the queue is full
+void UART_process(UART_Config *channel);                                     // Handles timeouts, call periodically
+uint8_t UART_pendingTransactions(UART_Config *channel);
+
 #endif /* __UART_H_ */
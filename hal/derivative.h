@@ -7,7 +7,7 @@
  * The Build process already selects one via makefile & makeFor.h files,
  * this choice will therefore not influence the build process.
  */
-#if !defined(Landungsbruecke) && !defined(Startrampe)
+#if !defined(Landungsbruecke) && !defined(Startrampe) && !defined(Host)
 #warning "No Board selected by makefile, defining one for debug purposes"
 #define Landungsbruecke
 //#define Startrampe
@@ -18,6 +18,29 @@
 	#if defined(Startrampe)
 		#define MODULE_ID "0011"
 		#include "stm32f2xx.h"
+
+		// Nesting interrupt lock: The outermost EnableInterrupts restores the PRIMASK
+		// found by the outermost DisableInterrupts, inner pairs leave interrupts disabled.
+		// The counters are only touched with interrupts disabled (see hal/Startrampe/tmc/HAL.c).
+		extern uint32_t interruptLockDepth;
+		extern uint32_t interruptLockPrimask;
+
+		static inline void interruptLock(void)
+		{
+			uint32_t primask = __get_PRIMASK();
+			__disable_irq();
+			if(interruptLockDepth++ == 0)
+				interruptLockPrimask = primask;
+		}
+
+		static inline void interruptUnlock(void)
+		{
+			if(interruptLockDepth && --interruptLockDepth == 0)
+				__set_PRIMASK(interruptLockPrimask);
+		}
+
+		#define EnableInterrupts   interruptUnlock()
+		#define DisableInterrupts  interruptLock()
 	#elif defined(Landungsbruecke)
 		#define MODULE_ID "0012"
 		#include <MK20D10.h>
@@ -25,6 +48,10 @@
 		#include "hal/Landungsbruecke/freescale/nvic.h"
 		#define CPU_LITTLE_ENDIAN
 		#define __MK_xxx_H__
+	#elif defined(Host)
+		// Native simulation build - reports as Landungsbruecke to the IDE
+		#define MODULE_ID "0012"
+		#include "hal/Host/sim/HostSim.h"
 	#else
 	#error "No Board selected"
 	#endif
@@ -4,6 +4,7 @@
 #include "hal/HAL.h"
 #include "tmc/IdDetection.h"
 #include "tmc/TMCL.h"
+#include "tmc/RAMDebug.h"
 #include "tmc/VitalSignsMonitor.h"
 #include "tmc/BoardAssignment.h"
 
@@ -35,6 +36,9 @@ extern SPIChannelTypeDef *TMC6200_SPIChannel;
 
 
 static void TMC6200_readRegister(uint8_t motor, uint8_t address, int32_t *value);
+#if defined(Host)
+static void hostMain(void);
+#endif
 
 
 /* Check if jumping into bootloader is forced                                           */
@@ -78,6 +82,7 @@ static void init()
 	HAL.init();                  // Initialize Hardware Abstraction Layer
 	IDDetection_init();          // Initialize board detection
 	tmcl_init();                 // Initialize TMCL communication
+	RAMDebug_init();             // Initialize RAM debug capture
 
 /*
 	tmcdriver_init();            // Initialize dummy driver board --> preset EvalBoards.ch2
@@ -117,7 +122,11 @@ static void TMC6200_writeRegister(uint8_t motor, uint8_t address, int32_t value)
 static void TMC6200_readRegister(uint8_t motor, uint8_t address, int32_t *value)
 {
 	UNUSED(motor);
+
+	// The TMC6200 replies with the data of the previous datagram, hold the bus across both
+	spi_acquireBus();
 	*value = tmc6200_readInt(0, address);
+	spi_releaseBus();
 }
 
 static void enableDriverInMain(DriverState state)
@@ -163,12 +172,48 @@ void TMC6200_init_InMain(void)
 }
 
 
+#if defined(Host)
+/* The simulation runs the regular TMCL main loop instead of the TMC6200 test,  */
+/* with the boards given by the environment variables TMC_HOST_ID_CH1/_CH2.    */
+static void hostMain(void)
+{
+	tmcdriver_init();            // Initialize dummy driver board --> preset EvalBoards.ch2
+	tmcmotioncontroller_init();  // Initialize dummy motion controller board  --> preset EvalBoards.ch1
+
+	VitalSignsMonitor.busy = 1;
+	Evalboards.driverEnable = DRIVER_ENABLE;
+
+	IdAssignmentTypeDef ids;
+	IDDetection_initialScan(&ids);
+	Board_assign(&ids);
+
+	VitalSignsMonitor.busy = 0;
+
+	while(1)
+	{
+		// Check all parameters and life signs and mark errors
+		vitalsignsmonitor_checkVitalSigns();
+
+		// Perodic jobs of Motion controller/Driver boards
+		Evalboards.ch1.periodicJob(systick_getTick());
+		Evalboards.ch2.periodicJob(systick_getTick());
+
+		// Process TMCL communication
+		tmcl_process();
+	}
+}
+#endif
+
 /* main function */
 int main(void)
 {
 	// Start all initialization routines
 	init();
 
+#if defined(Host)
+	hostMain();
+#endif
+
 	int32_t value = 0;
 	int32_t value1 = 0;
 	uint8_t readVal;
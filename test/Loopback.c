@@ -0,0 +1,154 @@
+/*
+ * Loopback.c
+ *
+ * In-memory TMCL interface, see Loopback.h
+ */
+
+#include "Loopback.h"
+#include "tmc/TMCL.h"
+
+extern RXTXTypeDef interfaces[];
+extern uint32_t numberOfInterfaces;
+
+static void init(void);
+static void tx(uint8_t ch);
+static uint8_t rx(uint8_t *ch);
+static void txN(uint8_t *str, unsigned char number);
+static uint8_t rxN(uint8_t *str, unsigned char number);
+static void clearBuffers(void);
+static uint32_t bytesAvailable(void);
+static uint32_t bytesFree(void);
+
+// The rx buffer holds the requests, the tx buffer the replies
+static volatile uint8_t
+	rxBuffer[LOOPBACK_BUFFER],
+	txBuffer[LOOPBACK_BUFFER];
+
+static RingBufferTypeDef rxRing = RINGBUFFER_INIT(rxBuffer);
+static RingBufferTypeDef txRing = RINGBUFFER_INIT(txBuffer);
+
+static RXTXTypeDef Loopback =
+{
+	.init            = init,
+	.deInit          = clearBuffers,
+	.rx              = rx,
+	.tx              = tx,
+	.rxN             = rxN,
+	.txN             = txN,
+	.clearBuffers    = clearBuffers,
+	.baudRate        = 0,
+	.bytesAvailable  = bytesAvailable,
+	.bytesFree       = bytesFree
+};
+
+void loopback_attach(void)
+{
+	interfaces[0] = Loopback;
+	numberOfInterfaces = 1;
+	Loopback.init();
+}
+
+bool loopback_send(uint8_t opcode, uint8_t type, uint8_t motor, int32_t value)
+{
+	uint8_t datagram[9];
+
+	datagram[0] = LOOPBACK_MODULE_ADDRESS;
+	datagram[1] = opcode;
+	datagram[2] = type;
+	datagram[3] = motor;
+	datagram[4] = (value >> 24) & 0xFF;
+	datagram[5] = (value >> 16) & 0xFF;
+	datagram[6] = (value >> 8)  & 0xFF;
+	datagram[7] = (value >> 0)  & 0xFF;
+	datagram[8] = 0;
+
+	for(int i = 0; i < 8; i++)
+		datagram[8] += datagram[i];
+
+	return ringbuffer_pushN(&rxRing, datagram, 9);
+}
+
+bool loopback_receive(uint8_t *status, int32_t *value)
+{
+	uint8_t reply[9];
+
+	if(!ringbuffer_popN(&txRing, reply, 9))
+		return false;
+
+	*status = reply[2];
+	*value = reply[4] << 24 | reply[5] << 16 | reply[6] << 8 | reply[7];
+	return true;
+}
+
+bool loopback_execute(uint8_t opcode, uint8_t type, uint8_t motor, int32_t *value)
+{
+	uint8_t status;
+
+	if(!loopback_send(opcode, type, motor, *value))
+		return false;
+
+	tmcl_process();
+
+	return loopback_receive(&status, value) && status == LOOPBACK_REPLY_OK;
+}
+
+uint32_t loopback_requestsFree(void)
+{
+	return ringbuffer_free(&rxRing) / 9;
+}
+
+uint32_t loopback_requestsPending(void)
+{
+	return ringbuffer_used(&rxRing) / 9;
+}
+
+uint32_t loopback_replies(void)
+{
+	return ringbuffer_used(&txRing) / 9;
+}
+
+void loopback_clearReplies(void)
+{
+	ringbuffer_clear(&txRing);
+}
+
+static void init(void)
+{
+	clearBuffers();
+}
+
+static void tx(uint8_t ch)
+{
+	txN(&ch, 1);
+}
+
+static uint8_t rx(uint8_t *ch)
+{
+	return rxN(ch, 1);
+}
+
+static void txN(uint8_t *str, unsigned char number)
+{
+	ringbuffer_pushN(&txRing, str, number);
+}
+
+static uint8_t rxN(uint8_t *str, unsigned char number)
+{
+	return ringbuffer_popN(&rxRing, str, number);
+}
+
+static void clearBuffers(void)
+{
+	ringbuffer_clear(&rxRing);
+	ringbuffer_clear(&txRing);
+}
+
+static uint32_t bytesAvailable(void)
+{
+	return ringbuffer_used(&rxRing);
+}
+
+static uint32_t bytesFree(void)
+{
+	return ringbuffer_free(&txRing);
+}
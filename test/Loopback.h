@@ -0,0 +1,35 @@
+/*
+ * Loopback.h
+ *
+ * In-memory TMCL interface for the host tests and benchmarks. Replaces the interfaces of
+ * tmcl_init(), requests are executed by tmcl_process() and the replies are read back here.
+ */
+
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+	#include "hal/HAL.h"
+
+	#define LOOPBACK_BUFFER  2048  // Ring buffers, the replies of a full request buffer have to fit into the reply buffer
+
+	// From TMCL.c
+	#define LOOPBACK_MODULE_ADDRESS  1
+	#define LOOPBACK_REPLY_OK        100
+
+	void loopback_attach(void);
+
+	// Queues a request datagram, returns false if the request buffer is full
+	bool loopback_send(uint8_t opcode, uint8_t type, uint8_t motor, int32_t value);
+
+	// Takes the oldest reply, returns false if there is none
+	bool loopback_receive(uint8_t *status, int32_t *value);
+
+	// Queues a request, runs tmcl_process() and takes the reply - returns false on a failed command
+	bool loopback_execute(uint8_t opcode, uint8_t type, uint8_t motor, int32_t *value);
+
+	uint32_t loopback_requestsFree(void);     // Datagrams fitting into the request buffer
+	uint32_t loopback_requestsPending(void);  // Datagrams not processed yet
+	uint32_t loopback_replies(void);          // Reply datagrams not taken yet
+	void loopback_clearReplies(void);
+
+#endif /* LOOPBACK_H */
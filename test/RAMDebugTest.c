@@ -0,0 +1,123 @@
+/*
+ * RAMDebugTest.c
+ *
+ * Captures a register channel of ch1 while TMCL commands access the same chip like a
+ * polling host: every millisecond a writeRegister, a readRegister and a GAP, every
+ * 100ms a block read of TMCL_REGISTER_BLOCK_MAX registers. The board is a TMC5130,
+ * which replies with the data of the previous datagram, so both datagrams of a read
+ * have to stay together. The simulated chip answers from its register file.
+ * Checks:
+ *   The capture completes with at most TEST_MAX_COLLISIONS percent repeated samples
+ *   Every sample has the value of the captured register
+ *   Every TMCL read returns the value written before - a RAMDebug datagram between the
+ *   two datagrams of the read would return the captured register instead
+ *
+ * Build and run with: make DEVICE=Host test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Loopback.h"
+#include "tmc/BoardAssignment.h"
+#include "tmc/IdDetection.h"
+#include "tmc/RAMDebug.h"
+#include "tmc/TMCL.h"
+
+#define TEST_FREQUENCY       10000       // [Hz]
+#define TEST_MAX_COLLISIONS  10          // [%] of the samples
+#define TEST_TIMEOUT         5000000000ull  // [ns]
+#define TEST_PERIOD          1000000     // [ns] between the polls of the host
+#define TEST_BLOCK_PERIOD    100         // Polls between the block reads
+
+#define TEST_REGISTER        0x21        // XACTUAL, written and read over TMCL
+#define TEST_CAPTURED        0x22        // VACTUAL, captured by RAMDebug
+#define TEST_CAPTURED_VALUE  0x12345678
+
+// From TMCL.c
+#define TMCL_GAP                     6
+#define TMCL_writeRegisterChannel_1  146
+#define TMCL_readRegisterChannel_1   148
+#define TMCL_readRegisterBlock_1     153
+#define TMCL_REGISTER_BLOCK_MAX      128
+
+int main(void)
+{
+	IdAssignmentTypeDef ids;
+	uint32_t polls = 0, readErrors = 0, sampleErrors = 0;
+	uint32_t samples, collisions;
+	int32_t value;
+
+	setenv("TMC_HOST_ID_CH1", "5", 1); // TMC5130-EVAL
+
+	HAL.init();
+	IDDetection_init();
+	tmcl_init();
+	IDDetection_initialScan(&ids);
+	Board_assign(&ids);
+
+	loopback_attach();
+
+	spi_writeInt(&HAL.SPI->ch1, TEST_CAPTURED, TEST_CAPTURED_VALUE);
+
+	RAMDebug_init();
+	if(!RAMDebug_addChannel(RAMDEBUG_CHANNEL_REGISTER_CH1, TEST_CAPTURED | RAMDEBUG_REGISTER_DELAYED)
+	|| !RAMDebug_setFrequency(TEST_FREQUENCY)
+	|| !RAMDebug_enableTrigger(RAMDEBUG_TRIGGER_UNCONDITIONAL, 0))
+	{
+		printf("RAMDebug test FAILED: capture not started\n");
+		return EXIT_FAILURE;
+	}
+
+	uint64_t start = host_getTimeNs();
+	uint64_t next = start;
+	while(RAMDebug_getState() != RAMDEBUG_COMPLETE && host_getTimeNs() - start < TEST_TIMEOUT)
+	{
+		if(host_getTimeNs() < next)
+			continue;
+		next += TEST_PERIOD;
+
+		value = polls;
+		loopback_execute(TMCL_writeRegisterChannel_1, TEST_REGISTER, 0, &value);
+
+		value = 0;
+		if(!loopback_execute(TMCL_readRegisterChannel_1, TEST_REGISTER, 0, &value) || value != (int32_t) polls)
+			readErrors++;
+
+		value = 0;
+		if(!loopback_execute(TMCL_GAP, 1, 0, &value) || value != (int32_t) polls)
+			readErrors++;
+
+		if(polls % TEST_BLOCK_PERIOD == 0)
+		{
+			loopback_send(TMCL_readRegisterBlock_1, 0, 0, TMCL_REGISTER_BLOCK_MAX);
+			tmcl_process();
+			loopback_clearReplies();
+		}
+
+		polls++;
+	}
+
+	if(RAMDebug_getState() != RAMDEBUG_COMPLETE)
+	{
+		printf("RAMDebug test FAILED: capture not complete after %u polls\n", polls);
+		return EXIT_FAILURE;
+	}
+
+	RAMDebug_getInfo(RAMDEBUG_INFO_SAMPLE_COUNT, &samples);
+	RAMDebug_getInfo(RAMDEBUG_INFO_SPI_COLLISIONS, &collisions);
+
+	// A sample repeated at the start of the capture has no previous value yet
+	for(uint32_t i = 0; i < samples; i++)
+		if(RAMDebug_getSample(i, &value) && value != TEST_CAPTURED_VALUE)
+			sampleErrors++;
+
+	bool passed = readErrors == 0
+	           && sampleErrors <= collisions
+	           && collisions * 100 <= samples * TEST_MAX_COLLISIONS;
+
+	printf("RAMDebug test %s: %u samples during %u polls, %u repeated (%.1f%%), %u wrong samples, %u wrong reads\n",
+			passed ? "passed" : "FAILED", samples, polls, collisions, 100.0 * collisions / samples, sampleErrors, readErrors);
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,156 @@
+/*
+ * RingBufferTest.c
+ *
+ * Stress test of hal/RingBuffer.c with a real producer and consumer thread.
+ * The producer pushes a known byte sequence in randomly sized chunks, the
+ * consumer pops in randomly sized chunks and checks that every byte arrives
+ * once and in order. Further runs keep the buffer full or empty to exercise
+ * the all-or-nothing path of ringbuffer_pushN()/ringbuffer_popN() at the wrap.
+ * A side that has to wait yields, so the test also finishes on a single core.
+ *
+ * Build and run with: make DEVICE=Host test
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal/RingBuffer.h"
+
+#define TEST_BYTES      (4 * 1024 * 1024)
+#define TEST_MAX_CHUNK  100
+
+// Byte at the given stream position. The period isn't a divisor of the buffer
+// size, so a stale byte left over from the previous lap doesn't pass the check.
+#define TEST_DATA(index)  ((uint8_t) ((index) % 251))
+
+typedef struct
+{
+	RingBufferTypeDef *ring;
+	uint32_t seed;
+	uint32_t maxChunk;
+	uint32_t errors;
+	uint32_t firstError;
+} TestThread;
+
+static volatile uint8_t buffer[256];
+
+// Small xorshift, rand() isn't thread safe
+static uint32_t random32(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static uint32_t chunkLength(TestThread *thread, uint32_t remaining)
+{
+	uint32_t length = 1 + random32(&thread->seed) % thread->maxChunk;
+
+	return MIN(length, remaining);
+}
+
+static void *producer(void *arg)
+{
+	TestThread *thread = arg;
+	uint8_t chunk[TEST_MAX_CHUNK];
+
+	for(uint32_t sent = 0; sent < TEST_BYTES; )
+	{
+		uint32_t length = chunkLength(thread, TEST_BYTES - sent);
+
+		for(uint32_t i = 0; i < length; i++)
+			chunk[i] = TEST_DATA(sent + i);
+
+		if(length == 1)
+		{
+			if(!ringbuffer_push(thread->ring, chunk[0]))
+			{
+				sched_yield();
+				continue;
+			}
+		}
+		else if(!ringbuffer_pushN(thread->ring, chunk, length))
+		{
+			sched_yield();
+			continue;
+		}
+
+		sent += length;
+	}
+
+	return NULL;
+}
+
+static void *consumer(void *arg)
+{
+	TestThread *thread = arg;
+	uint8_t chunk[TEST_MAX_CHUNK];
+
+	for(uint32_t received = 0; received < TEST_BYTES; )
+	{
+		uint32_t length = chunkLength(thread, TEST_BYTES - received);
+
+		if(length == 1)
+		{
+			if(!ringbuffer_pop(thread->ring, chunk))
+			{
+				sched_yield();
+				continue;
+			}
+		}
+		else if(!ringbuffer_popN(thread->ring, chunk, length))
+		{
+			sched_yield();
+			continue;
+		}
+
+		for(uint32_t i = 0; i < length; i++)
+		{
+			if(chunk[i] != TEST_DATA(received + i))
+			{
+				if(thread->errors++ == 0)
+					thread->firstError = received + i;
+			}
+		}
+
+		received += length;
+	}
+
+	return NULL;
+}
+
+static bool run(const char *name, uint32_t producerChunk, uint32_t consumerChunk)
+{
+	RingBufferTypeDef ring = RINGBUFFER_INIT(buffer);
+	TestThread tx = { .ring = &ring, .seed = 0x12345678, .maxChunk = producerChunk };
+	TestThread rx = { .ring = &ring, .seed = 0x9ABCDEF0, .maxChunk = consumerChunk };
+	pthread_t producerThread, consumerThread;
+
+	pthread_create(&consumerThread, NULL, consumer, &rx);
+	pthread_create(&producerThread, NULL, producer, &tx);
+	pthread_join(producerThread, NULL);
+	pthread_join(consumerThread, NULL);
+
+	bool passed = (rx.errors == 0) && (ringbuffer_used(&ring) == 0);
+
+	printf("%-30s %s: %u bytes, %u errors", name, passed ? "passed" : "FAILED", TEST_BYTES, rx.errors);
+	if(rx.errors)
+		printf(" (first at byte %u)", rx.firstError);
+	printf(", high water mark %u, %u bytes refused\n", ring.highWaterMark, ring.dropped);
+
+	return passed;
+}
+
+int main(void)
+{
+	bool passed = true;
+
+	passed &= run("Random chunks", TEST_MAX_CHUNK, TEST_MAX_CHUNK);
+	passed &= run("Slow consumer (full buffer)", TEST_MAX_CHUNK, 3);
+	passed &= run("Slow producer (empty buffer)", 3, TEST_MAX_CHUNK);
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
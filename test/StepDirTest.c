@@ -0,0 +1,178 @@
+/*
+ * StepDirTest.c
+ *
+ * Ramp check of the StepDir generator. Runs the channel tick of the interrupt on a
+ * scratch channel (see StepDir_testTick()). Each move goes to a random target with random
+ * maximum velocity and acceleration, a random S-curve jerk time, and random parameter
+ * changes during the move. Every tick is checked for one step at most, the maximum
+ * velocity and the velocity change allowed by the acceleration. Each move has to end at
+ * the target in time. Moves without an acceleration decrease must not overshoot by more
+ * than TEST_MAX_OVERSHOOT steps. Prints the simulated ticks per second as a benchmark.
+ *
+ * Build and run with: make DEVICE=Host test
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "tmc/StepDir.h"
+
+#define TEST_MOVES          2000
+#define TEST_MAX_OVERSHOOT  9  // Steps, single digit (see "Position mode" in tmc/StepDir.c)
+
+typedef enum {
+	CHECK_PASSED        = 0,
+	CHECK_STEP_RATE     = 1,  // More than one step in a tick
+	CHECK_VELOCITY      = 2,  // Velocity above the maximum velocity
+	CHECK_ACCELERATION  = 3,  // Velocity change of a tick above the acceleration
+	CHECK_OVERSHOOT     = 4,  // Target overshot by more than a few steps
+	CHECK_TIMEOUT       = 5   // Move did not end at the target in time
+} Check;
+
+static const char *checkNames[] = { "passed", "step rate", "velocity", "acceleration", "overshoot", "timeout" };
+
+static StepDirectionTypedef channel;
+static volatile uint32_t pinRegister;
+static IOPinTypeDef pin = { .setBitRegister = &pinRegister, .resetBitRegister = &pinRegister, .bitWeight = 1 };
+
+// xorshift32 - the same sequence on every run, so failures can be repeated
+static uint32_t random32(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+
+	return *state;
+}
+
+// Random value in [2^digits, 2^(digits+1)) with digits in [minDigits, maxDigits]
+static uint32_t randomRange(uint32_t *state, uint8_t minDigits, uint8_t maxDigits)
+{
+	uint8_t digits = minDigits + random32(state) % (maxDigits - minDigits + 1);
+
+	return (1u << digits) + random32(state) % (1u << digits);
+}
+
+static uint32_t randomAcceleration(uint32_t *state)
+{
+	uint32_t acceleration = randomRange(state, 16, 29);
+
+	return MIN(acceleration, STEPDIR_MAX_ACCELERATION);
+}
+
+static Check move(StepDirectionTypedef *ch, uint32_t *random, uint64_t *ticks)
+{
+	int32_t position = ch->ramp.rampPosition - ch->jerkLag;
+	int32_t distance = randomRange(random, 0, 13);
+	if(random32(random) & 1)
+		distance = -distance;
+	int32_t target = position + distance;
+
+	uint32_t velocityMax   = randomRange(random, 12, 15);
+	uint32_t acceleration  = randomAcceleration(random);
+
+	// Limits over the whole move
+	uint32_t velocityLimit      = velocityMax;
+	uint32_t accelerationLimit  = acceleration;
+	uint32_t velocitySlowest    = velocityMax;
+	uint32_t accelerationLowest = acceleration;
+	bool slower = false;
+	int32_t overshoot = 0;
+	uint64_t moveTicks = 0;
+
+	// The history is empty after standing still for the jerk time
+	uint32_t jerkTime = (random32(random) & 3) ? 16 * (random32(random) % 65) : 0;
+	ch->jerkIndex       = 0;
+	ch->jerkStillTicks  = jerkTime;
+	ch->jerkTime        = jerkTime;
+
+	StepDir_testSetParameters(ch, velocityMax, acceleration);
+	tmc_ramp_linear_set_targetPosition(&ch->ramp, target);
+
+	for(;;)
+	{
+		int32_t lastPosition = position;
+		int32_t lastVelocity = ch->ramp.rampVelocity;
+
+		// Parameter change during the move
+		if((random32(random) & 0xFFF) == 0)
+		{
+			velocityMax   = randomRange(random, 12, 15);
+			uint32_t next = randomAcceleration(random);
+			slower       |= next < acceleration;
+			acceleration  = next;
+
+			velocityLimit       = MAX(velocityLimit, velocityMax);
+			accelerationLimit   = MAX(accelerationLimit, acceleration);
+			velocitySlowest     = MIN(velocitySlowest, velocityMax);
+			accelerationLowest  = MIN(accelerationLowest, acceleration);
+
+			StepDir_testSetParameters(ch, velocityMax, acceleration);
+		}
+
+		StepDir_testTick(ch);
+		(*ticks)++;
+		moveTicks++;
+
+		position = ch->ramp.rampPosition - ch->jerkLag;
+		int32_t velocity = ch->ramp.rampVelocity;
+
+		if(abs(position - lastPosition) > 1)
+			return CHECK_STEP_RATE;
+
+		if((uint32_t) abs(velocity) > velocityLimit)
+			return CHECK_VELOCITY;
+
+		// Stopping at the target may drop the remaining low velocity at once
+		if(velocity != 0 && (uint32_t) abs(velocity - lastVelocity) > accelerationLimit / ch->ramp.precision + 1)
+			return CHECK_ACCELERATION;
+
+		overshoot = MAX(overshoot, (distance > 0) ? position - target : target - position);
+
+		if(position == target && velocity == 0 && ch->jerkLag == 0 && ch->jerkStillTicks >= ch->jerkTime)
+			break;
+
+		// Time of a move with the slowest parameters, doubled, plus the S-curve and a second for homing in
+		uint64_t limit = 2 * ((uint64_t) abs(distance) * ch->ramp.precision / velocitySlowest
+		                    + (uint64_t) velocityLimit * ch->ramp.precision / accelerationLowest)
+		               + 2 * jerkTime + ch->ramp.precision;
+		if(moveTicks > limit)
+			return CHECK_TIMEOUT;
+	}
+
+	if(!slower && overshoot > TEST_MAX_OVERSHOOT)
+		return CHECK_OVERSHOOT;
+
+	return CHECK_PASSED;
+}
+
+int main(void)
+{
+	StepDirectionTypedef *ch = &channel;
+	uint32_t random = 1;
+	uint64_t ticks = 0;
+	Check result = CHECK_PASSED;
+	uint32_t moves;
+	clock_t start = clock();
+
+	*ch = (StepDirectionTypedef) { .stepPin = &pin, .dirPin = &pin };
+	tmc_ramp_linear_init(&ch->ramp);
+	tmc_ramp_linear_set_precision(&ch->ramp, StepDir_getBaseFrequency());
+	tmc_ramp_linear_set_mode(&ch->ramp, TMC_RAMP_LINEAR_MODE_POSITION);
+
+	for(moves = 0; moves < TEST_MOVES && result == CHECK_PASSED; moves++)
+		result = move(ch, &random, &ticks);
+
+	double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	if(result != CHECK_PASSED)
+	{
+		printf("StepDir ramp check FAILED: %s at move %u\n", checkNames[result], moves);
+		return EXIT_FAILURE;
+	}
+
+	printf("StepDir ramp check passed: %u moves, %llu ticks, %.0f ticks/s\n",
+			moves, (unsigned long long) ticks, ticks / MAX(seconds, 1e-6));
+
+	return EXIT_SUCCESS;
+}
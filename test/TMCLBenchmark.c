@@ -0,0 +1,153 @@
+/*
+ * TMCLBenchmark.c
+ *
+ * Benchmark of the TMCL command processing in the host build. The datagrams go through
+ * the in-memory loopback interface (see Loopback.h) and get executed by tmcl_process()
+ * against the boards given by TMC_HOST_ID_CH1 and TMC_HOST_ID_CH2 (see tmc/IdDetection_Host.c).
+ *
+ * Each command (GAP, SAP, readRegister and writeRegister of channel 1) and the mix of all
+ * four runs in two phases:
+ *   Latency: One datagram at a time, median and 99th percentile of tmcl_process() [ns]
+ *   Throughput: The rx buffer kept filled like a streaming host [commands/s], and the share
+ *   of the time spent in tmcl_process() - the rest is the transport
+ *
+ * Build and run with: make DEVICE=Host benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Loopback.h"
+#include "tmc/BoardAssignment.h"
+#include "tmc/IdDetection.h"
+#include "tmc/TMCL.h"
+
+#define BENCHMARK_SAMPLES   4096
+#define BENCHMARK_DURATION  500000000ull  // [ns] per phase
+
+// From TMCL.c
+#define TMCL_SAP                     5
+#define TMCL_GAP                     6
+#define TMCL_writeRegisterChannel_1  146
+#define TMCL_readRegisterChannel_1   148
+
+typedef struct
+{
+	const char  *name;
+	uint8_t     opcode;
+	uint8_t     type;
+	uint8_t     motor;
+	int32_t     value;
+} BenchmarkCommand;
+
+static uint64_t samples[BENCHMARK_SAMPLES];
+
+static void send(const BenchmarkCommand *cmd)
+{
+	loopback_send(cmd->opcode, cmd->type, cmd->motor, cmd->value);
+}
+
+// Executes a command, returns false on a failed command
+static bool execute(const BenchmarkCommand *cmd, int32_t *value)
+{
+	*value = cmd->value;
+	return loopback_execute(cmd->opcode, cmd->type, cmd->motor, value);
+}
+
+static int compareSamples(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void run(const char *name, const BenchmarkCommand *commands, uint32_t count)
+{
+	// Latency: One datagram at a time
+	uint32_t taken = 0;
+	uint64_t start = host_getTimeNs();
+	while(host_getTimeNs() - start < BENCHMARK_DURATION && taken < BENCHMARK_SAMPLES)
+	{
+		send(&commands[taken % count]);
+
+		uint64_t time = host_getTimeNs();
+		tmcl_process();
+		samples[taken++] = host_getTimeNs() - time;
+
+		loopback_clearReplies();
+	}
+
+	qsort(samples, taken, sizeof(samples[0]), compareSamples);
+
+	// Throughput: Keep the rx buffer filled like a streaming host
+	uint64_t commandsDone = 0;
+	uint64_t processing = 0;
+	uint32_t next = 0;
+	start = host_getTimeNs();
+	while(host_getTimeNs() - start < BENCHMARK_DURATION)
+	{
+		while(loopback_requestsFree())
+			send(&commands[next++ % count]);
+
+		uint64_t time = host_getTimeNs();
+		while(loopback_requestsPending())
+			tmcl_process();
+		processing += host_getTimeNs() - time;
+
+		commandsDone += loopback_replies();
+		loopback_clearReplies();
+	}
+	uint64_t elapsed = host_getTimeNs() - start;
+
+	printf("%-18s %8llu %8llu %12llu %9.1f%%\n", name,
+			(unsigned long long) samples[taken / 2],
+			(unsigned long long) samples[taken * 99 / 100],
+			(unsigned long long) (commandsDone * 1000000000ull / elapsed),
+			100.0 * processing / elapsed);
+}
+
+int main(void)
+{
+	IdAssignmentTypeDef ids;
+	BenchmarkCommand commands[4];
+	uint32_t count = 0;
+	int32_t value;
+
+	HAL.init();
+	IDDetection_init();
+	tmcl_init();
+	IDDetection_initialScan(&ids);
+	Board_assign(&ids);
+
+	loopback_attach();
+
+	// Write commands send the value read before, so the boards keep their settings.
+	// Commands whose value can't be read are left out.
+	BenchmarkCommand gap    = { .name = "GAP 4",             .opcode = TMCL_GAP, .type = 4 };
+	BenchmarkCommand readCh = { .name = "readRegister ch1",  .opcode = TMCL_readRegisterChannel_1 };
+
+	if(execute(&gap, &value))
+	{
+		commands[count++] = gap;
+		commands[count++] = (BenchmarkCommand) { .name = "SAP 4", .opcode = TMCL_SAP, .type = 4, .value = value };
+	}
+	if(execute(&readCh, &value))
+	{
+		commands[count++] = readCh;
+		commands[count++] = (BenchmarkCommand) { .name = "writeRegister ch1", .opcode = TMCL_writeRegisterChannel_1, .value = value };
+	}
+
+	if(count == 0)
+	{
+		printf("No command could be executed - set TMC_HOST_ID_CH1/TMC_HOST_ID_CH2 to attach boards\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%-18s %8s %8s %12s %10s\n", "Command", "p50 [ns]", "p99 [ns]", "Commands/s", "Processing");
+	for(uint32_t i = 0; i < count; i++)
+		run(commands[i].name, &commands[i], 1);
+	run("Mix", commands, count);
+
+	return EXIT_SUCCESS;
+}
@@ -95,7 +95,10 @@ static uint8_t assignCh1(uint8_t id, uint8_t justCheck)
 {
 	uint8_t ok = ID_STATE_NOT_IN_FW;
 	if(!justCheck)
+	{
 		tmcmotioncontroller_init();
+		HAL.SPI->ch1.setFrequency(SPI_FREQUENCY_DEFAULT); // boards raise it to their maximum in init
+	}
 
 	for(size_t i = 0, sz = ARRAY_SIZE(init_ch1); i < sz; i++)
 	{
@@ -118,6 +121,9 @@ static uint8_t assignCh2(uint8_t id, uint8_t justCheck)
 //	if(!justCheck)
 //		tmcdriver_init();
 
+	if(!justCheck)
+		HAL.SPI->ch2.setFrequency(SPI_FREQUENCY_DEFAULT); // boards raise it to their maximum in init
+
 #if defined(Startrampe)
 	if(id == ID_TMC2208 && EEPROM.ch2.hw == 0x0103)
 		return ok;
@@ -62,7 +62,7 @@ int32_t Board_supported(IdAssignmentTypeDef *ids);  // ids and states of support
 #define ID_TMC2041         5
 #define ID_TMC2208         6
 #define ID_TMC2224         7
-#if defined(Landungsbruecke)
+#if defined(Landungsbruecke) || defined(Host)
 #define ID_TMC2209		   8
 #endif
 #define ID_TMCC160         9
@@ -133,7 +133,7 @@ static const init_assignment init_ch2[] =
 	{ .id = ID_TMC2100,     .init = TMC2100_init     },
 	{ .id = ID_TMC2041,     .init = TMC2041_init     },
 	{ .id = ID_TMC2208,     .init = TMC2208_init     },
-#if defined(Landungsbruecke)
+#if defined(Landungsbruecke) || defined(Host)
 	{ .id = ID_TMC2209,     .init = TMC2209_init     },
 #endif
 	{ .id = ID_TMC2224,     .init = TMC2224_init     },
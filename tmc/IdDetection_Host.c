@@ -0,0 +1,99 @@
+/*
+ * IdDetection_Host.c
+ *
+ *  Calling IDDetection_detect(IdAssignmentTypeDef *result) will start the ID detection process.
+ *  The simulation has no monoflops or EEPROMs - the IDs of the "attached" boards are taken
+ *  from the environment variables TMC_HOST_ID_CH1 (driver) and TMC_HOST_ID_CH2 (motion controller).
+ *  Unset or invalid variables result in ID_STATE_NO_ANSWER for that channel.
+ *
+ *  As on the boards the first call starts the scan and returns false, the next call
+ *  returns the results. Calling the function again afterwards will start another scan.
+ */
+
+#include <stdlib.h>
+
+#include "tmc/helpers/API_Header.h"
+
+#include "hal/derivative.h"
+#include "hal/HAL.h"
+#include "BoardAssignment.h"
+#include "IdDetection.h"
+#include "VitalSignsMonitor.h"
+#include "TMCL.h"
+
+static void detectChannel(IdStateTypeDef *state, const char *variable);
+
+static bool isScanning;
+IdAssignmentTypeDef IdState = { 0 };
+
+void IDDetection_init(void)
+{
+	isScanning = false;
+}
+
+void IDDetection_deInit()
+{
+	isScanning = false;
+}
+
+static void detectChannel(IdStateTypeDef *state, const char *variable)
+{
+	const char *value = getenv(variable);
+	char *end;
+	long id;
+
+	state->id          = 0;
+	state->state       = ID_STATE_NO_ANSWER;
+	state->detectedBy  = FOUND_BY_NONE;
+
+	if(!value)
+		return;
+
+	id = strtol(value, &end, 0);
+	if(end == value || *end != '\0' || id <= 0 || id > 0xFF)
+	{
+		state->state = ID_STATE_INVALID;
+		return;
+	}
+
+	state->id          = id;
+	state->state       = ID_STATE_DONE;
+	state->detectedBy  = FOUND_BY_EEPROM;
+}
+
+// Detect IDs of attached boards - returns true when done
+uint8_t IDDetection_detect(IdAssignmentTypeDef *out)
+{
+	if(!isScanning)
+	{
+		IdState.ch1.state       = ID_STATE_WAIT_LOW;
+		IdState.ch1.detectedBy  = FOUND_BY_NONE;
+		IdState.ch2.state       = ID_STATE_WAIT_LOW;
+		IdState.ch2.detectedBy  = FOUND_BY_NONE;
+		isScanning = true;
+
+		return false;
+	}
+
+	// Scan complete
+	isScanning = false;
+
+	detectChannel(&IdState.ch1, "TMC_HOST_ID_CH1");
+	detectChannel(&IdState.ch2, "TMC_HOST_ID_CH2");
+
+	out->ch1.state  = IdState.ch1.state;
+	out->ch1.id     = IdState.ch1.id;
+	out->ch2.state  = IdState.ch2.state;
+	out->ch2.id     = IdState.ch2.id;
+
+	return true;
+}
+
+void IDDetection_initialScan(IdAssignmentTypeDef *ids)
+{
+	while(!IDDetection_detect(ids))
+	{
+		vitalsignsmonitor_checkVitalSigns();
+		tmcl_process();
+	}
+}
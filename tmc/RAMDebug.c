@@ -0,0 +1,583 @@
+/*
+ * RAMDebug.c
+ *
+ * Captures up to RAMDEBUG_MAX_CHANNELS values with a fixed sample frequency into RAM,
+ * for signals too fast to be polled over TMCL (e.g. TMC4671 current loop values).
+ * The buffer is uploaded afterwards with TMCL_RamDebug.
+ *
+ * Sampling:
+ *   The samples are taken by a timer interrupt of their own (Landungsbruecke: PIT0,
+ *   Startrampe: TIM3, Host: simulated periodic interrupt), so the sample frequency does
+ *   not depend on the StepDir interrupt frequency or its step timed mode.
+ *   It has the same priority as the StepDir interrupt - a capture of register channels
+ *   delays the StepDir interrupt by the SPI transfers.
+ *
+ * Register channels:
+ *   The chip is read directly with a 40 bit SPI datagram. The board functions
+ *   (readRegister(), GAP()) can't be used from the interrupt: UART boards wait for the
+ *   reply and axis parameters may need several accesses. Axis parameters of the StepDir
+ *   generator are available as StepDir channels.
+ *   When the interrupt hits the main loop while it owns the SPI bus (see spi_acquireBus()),
+ *   the previous value of the channel is repeated and counted (RAMDEBUG_INFO_SPI_COLLISIONS).
+ *   The bus owner covers each board access of a TMCL command, so the interrupt can't get
+ *   between the two datagrams of a read from a chip with delayed replies either, but keeps
+ *   sampling between the accesses (test/RAMDebugTest.c).
+ *   The transfers of all register channels (and the trigger channel) may take at most
+ *   SPI_LOAD_PERCENT of the sample period at the current SCK frequency, otherwise the
+ *   interrupt would starve the main loop. Higher frequencies are rejected by
+ *   RAMDebug_setFrequency() and RAMDebug_enableTrigger() (RAMDEBUG_INFO_MAX_FREQUENCY).
+ *
+ * Capture:
+ *   RAMDebug_enableTrigger() starts the timer. The values go into a ring buffer of the
+ *   sample count. First the pretrigger values are captured, then the trigger condition
+ *   is checked with every sample. The sample fulfilling the condition is the first one
+ *   after the trigger. When the remaining values are captured the timer stops.
+ *   The values of one sample are consecutive in channel order, index 0 of
+ *   RAMDebug_getSample() is the oldest value.
+ */
+
+#include "RAMDebug.h"
+#include "hal/derivative.h"
+#include "hal/HAL.h"
+#include "tmc/StepDir.h"
+
+#if defined(Startrampe)
+	#define RAMDEBUG_INTERRUPT  TIM3_IRQHandler
+	#define TIMER_CLOCK         1000000   // 60MHz timer clock, prescaled by 60
+#elif defined(Landungsbruecke)
+	#define RAMDEBUG_INTERRUPT  PIT0_IRQHandler
+	#define TIMER_CLOCK         48000000  // Bus clock
+#elif defined(Host)
+	#define RAMDEBUG_INTERRUPT  RAMDebug_hostTimerHandler
+#endif
+
+// Register channels limit the sample frequency, their transfers may take this share of the sample period
+#define SPI_LOAD_PERCENT    50
+#define DATAGRAM_OVERHEAD   2000  // [ns] per datagram besides the 40 SCK periods (CSN, FIFO handling)
+
+typedef struct
+{
+	RAMDebugChannelType  type;
+	uint32_t             value;
+	int32_t              last;  // Repeated on SPI collisions
+} RAMDebugChannel;
+
+static void timerStart(void);
+static void timerStop(void);
+static bool channelValid(RAMDebugChannelType type, uint32_t value);
+static bool readRegister(SPIChannelTypeDef *spi, uint32_t value, int32_t *result);
+static int32_t readChannel(RAMDebugChannel *channel);
+static bool checkTrigger(void);
+static bool configurable(void);
+static uint32_t transferTime(RAMDebugChannel *channel);
+static uint32_t maxFrequency(bool withTrigger);
+
+// Configuration
+static RAMDebugChannel channels[RAMDEBUG_MAX_CHANNELS];
+static uint8_t channelCount = 0;
+static RAMDebugChannel triggerChannel;
+static uint32_t triggerMask = 0xFFFFFFFF;
+static uint8_t triggerShift = 0;
+static RAMDebugTrigger trigger = RAMDEBUG_TRIGGER_UNCONDITIONAL;
+static int32_t triggerThreshold = 0;
+static uint32_t sampleCount = RAMDEBUG_BUFFER_ELEMENTS;
+static uint32_t pretriggerCount = 0;
+static uint32_t actualFrequency = RAMDEBUG_DEFAULT_FREQUENCY;
+#if defined(Startrampe) || defined(Landungsbruecke)
+	static uint32_t timerTicks = TIMER_CLOCK / RAMDEBUG_DEFAULT_FREQUENCY;  // Timer clocks per sample
+#endif
+
+// Capture, changed by the interrupt while running
+static volatile RAMDebugState state = RAMDEBUG_IDLE;
+static int32_t buffer[RAMDEBUG_BUFFER_ELEMENTS];
+static uint32_t captureCount;       // Sample count rounded down to whole samples
+static uint32_t capturePretrigger;  // Pretrigger count rounded down to whole samples
+static uint32_t writeIndex;
+static uint32_t written;            // Values written before the trigger check starts
+static uint32_t remaining;          // Values to capture after the trigger
+static uint32_t triggerPrevious;
+static bool triggerPreviousValid;
+static volatile uint32_t spiCollisions = 0;
+
+void RAMDEBUG_INTERRUPT()
+{
+#if defined(Startrampe)
+	if(TIM_GetITStatus(TIM3, TIM_IT_Update) == RESET)
+		return;
+	TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+#elif defined(Landungsbruecke)
+	PIT_TFLG0 = PIT_TFLG_TIF_MASK;
+#endif
+
+	if(state == RAMDEBUG_IDLE || state == RAMDEBUG_COMPLETE)
+		return;
+
+	// Check the trigger channel before taking the sample, so its previous value stays up to date
+	bool triggered = checkTrigger();
+
+	for(uint8_t i = 0; i < channelCount; i++)
+	{
+		buffer[writeIndex] = readChannel(&channels[i]);
+		if(++writeIndex == captureCount)
+			writeIndex = 0;
+	}
+
+	switch(state)
+	{
+	case RAMDEBUG_PRETRIGGER:
+		written += channelCount;
+		if(written >= capturePretrigger)
+			state = RAMDEBUG_TRIGGER;
+		break;
+	case RAMDEBUG_TRIGGER:
+		if(!triggered)
+			break;
+		state = RAMDEBUG_CAPTURE;
+		remaining = captureCount - capturePretrigger;
+		// fall through - the sample with the trigger condition counts after the trigger
+	case RAMDEBUG_CAPTURE:
+		remaining -= channelCount;
+		if(remaining == 0)
+		{
+			state = RAMDEBUG_COMPLETE;
+#if defined(Startrampe) || defined(Landungsbruecke)
+			timerStop(); // The simulation can't stop its interrupt thread from within, it stops with the next configuration
+#endif
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void RAMDebug_init(void)
+{
+	#if defined(Startrampe)
+		NVIC_InitTypeDef NVIC_InitStructure;
+
+		RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
+
+		// Same priority as the StepDir interrupt, neither interrupts the other
+		NVIC_InitStructure.NVIC_IRQChannel                    = TIM3_IRQn;
+		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority  = 1;
+		NVIC_InitStructure.NVIC_IRQChannelSubPriority         = 2;
+		NVIC_InitStructure.NVIC_IRQChannelCmd                 = ENABLE;
+		NVIC_Init(&NVIC_InitStructure);
+	#elif defined(Landungsbruecke)
+		SIM_SCGC6 |= SIM_SCGC6_PIT_MASK;
+		PIT_MCR = 0; // Enable the PIT module
+		enable_irq(INT_PIT0-16);
+	#endif
+
+	timerStop();
+	state = RAMDEBUG_IDLE;
+
+	channelCount          = 0;
+	triggerChannel.type   = RAMDEBUG_CHANNEL_DISABLED;
+	triggerChannel.value  = 0;
+	triggerMask           = 0xFFFFFFFF;
+	triggerShift          = 0;
+	trigger               = RAMDEBUG_TRIGGER_UNCONDITIONAL;
+	triggerThreshold      = 0;
+	sampleCount           = RAMDEBUG_BUFFER_ELEMENTS;
+	pretriggerCount       = 0;
+	spiCollisions         = 0;
+	RAMDebug_setFrequency(RAMDEBUG_DEFAULT_FREQUENCY);
+}
+
+void RAMDebug_deInit(void)
+{
+	timerStop();
+	state = RAMDEBUG_IDLE;
+}
+
+static void timerStart(void)
+{
+	#if defined(Startrampe)
+		TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+
+		TIM_DeInit(TIM3);
+		TIM_TimeBaseStructure.TIM_Period         = timerTicks - 1;
+		TIM_TimeBaseStructure.TIM_Prescaler      = 60 - 1;
+		TIM_TimeBaseStructure.TIM_ClockDivision  = 0;
+		TIM_TimeBaseStructure.TIM_CounterMode    = TIM_CounterMode_Up;
+		TIM_TimeBaseInit(TIM3, &TIM_TimeBaseStructure);
+		TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+		TIM_ITConfig(TIM3, TIM_IT_Update, ENABLE);
+		TIM_Cmd(TIM3, ENABLE);
+	#elif defined(Landungsbruecke)
+		PIT_TCTRL0  = 0;
+		PIT_LDVAL0  = timerTicks - 1;
+		PIT_TFLG0   = PIT_TFLG_TIF_MASK;
+		PIT_TCTRL0  = PIT_TCTRL_TIE_MASK | PIT_TCTRL_TEN_MASK;
+	#elif defined(Host)
+		host_irq_startPeriodic(RAMDEBUG_INTERRUPT, actualFrequency);
+	#endif
+}
+
+static void timerStop(void)
+{
+	#if defined(Startrampe)
+		TIM_Cmd(TIM3, DISABLE);
+		TIM_ITConfig(TIM3, TIM_IT_Update, DISABLE);
+	#elif defined(Landungsbruecke)
+		PIT_TCTRL0 = 0;
+	#elif defined(Host)
+		host_irq_stopPeriodic(RAMDEBUG_INTERRUPT);
+	#endif
+}
+
+static bool channelValid(RAMDebugChannelType type, uint32_t value)
+{
+	switch(type)
+	{
+	case RAMDEBUG_CHANNEL_REGISTER_CH1:
+	case RAMDEBUG_CHANNEL_REGISTER_CH2:
+		return (value & ~(RAMDEBUG_REGISTER_DELAYED | 0x7F)) == 0;
+	case RAMDEBUG_CHANNEL_STEPDIR:
+		return (value >> 8) < STEP_DIR_CHANNELS && (value & 0xFF) <= RAMDEBUG_STEPDIR_STATUS;
+	case RAMDEBUG_CHANNEL_ADC:
+		return value <= RAMDEBUG_ADC_VM;
+	default:
+		return false;
+	}
+}
+
+// Returns false without a transfer while the main loop owns the SPI bus
+static bool readRegister(SPIChannelTypeDef *spi, uint32_t value, int32_t *result)
+{
+	if(spi_busOwned())
+		return false;
+
+	uint8_t address = value & 0x7F;
+
+	if(value & RAMDEBUG_REGISTER_DELAYED)
+		spi_datagram40(spi, address, 0);
+
+	*result = spi_datagram40(spi, address, 0);
+	return true;
+}
+
+static int32_t readChannel(RAMDebugChannel *channel)
+{
+	int32_t value = channel->last;
+	uint8_t motor = channel->value >> 8;
+
+	switch(channel->type)
+	{
+	case RAMDEBUG_CHANNEL_REGISTER_CH1:
+		if(!readRegister(&HAL.SPI->ch1, channel->value, &value))
+			spiCollisions++;
+		break;
+	case RAMDEBUG_CHANNEL_REGISTER_CH2:
+		if(!readRegister(&HAL.SPI->ch2, channel->value, &value))
+			spiCollisions++;
+		break;
+	case RAMDEBUG_CHANNEL_STEPDIR:
+		switch(channel->value & 0xFF)
+		{
+		case RAMDEBUG_STEPDIR_ACTUAL_POSITION:
+			value = StepDir_getActualPosition(motor);
+			break;
+		case RAMDEBUG_STEPDIR_ACTUAL_VELOCITY:
+			value = StepDir_getActualVelocity(motor);
+			break;
+		case RAMDEBUG_STEPDIR_TARGET_POSITION:
+			value = StepDir_getTargetPosition(motor);
+			break;
+		case RAMDEBUG_STEPDIR_STATUS:
+			value = StepDir_getStatus(motor);
+			break;
+		}
+		break;
+	case RAMDEBUG_CHANNEL_ADC:
+		switch(channel->value)
+		{
+		case RAMDEBUG_ADC_AIN0:
+			value = *HAL.ADCs->AIN0;
+			break;
+		case RAMDEBUG_ADC_AIN1:
+			value = *HAL.ADCs->AIN1;
+			break;
+		case RAMDEBUG_ADC_AIN2:
+			value = *HAL.ADCs->AIN2;
+			break;
+		case RAMDEBUG_ADC_DIO4:
+			value = *HAL.ADCs->DIO4;
+			break;
+		case RAMDEBUG_ADC_DIO5:
+			value = *HAL.ADCs->DIO5;
+			break;
+		case RAMDEBUG_ADC_VM:
+			value = *HAL.ADCs->VM;
+			break;
+		}
+		break;
+	default:
+		value = 0;
+		break;
+	}
+
+	channel->last = value;
+	return value;
+}
+
+// Edge detection on the masked and shifted trigger channel value
+static bool checkTrigger(void)
+{
+	if(trigger == RAMDEBUG_TRIGGER_UNCONDITIONAL)
+		return true;
+
+	uint32_t value = ((uint32_t) readChannel(&triggerChannel) & triggerMask) >> triggerShift;
+	uint32_t previous = triggerPrevious;
+	bool previousValid = triggerPreviousValid;
+
+	triggerPrevious = value;
+	triggerPreviousValid = true;
+
+	if(!previousValid)
+		return false;
+
+	bool rising, falling;
+	if(trigger <= RAMDEBUG_TRIGGER_DUAL_EDGE_SIGNED)
+	{
+		rising   = (int32_t) previous <  triggerThreshold && (int32_t) value >= triggerThreshold;
+		falling  = (int32_t) previous >= triggerThreshold && (int32_t) value <  triggerThreshold;
+	}
+	else
+	{
+		rising   = previous <  (uint32_t) triggerThreshold && value >= (uint32_t) triggerThreshold;
+		falling  = previous >= (uint32_t) triggerThreshold && value <  (uint32_t) triggerThreshold;
+	}
+
+	switch(trigger)
+	{
+	case RAMDEBUG_TRIGGER_RISING_EDGE_SIGNED:
+	case RAMDEBUG_TRIGGER_RISING_EDGE_UNSIGNED:
+		return rising;
+	case RAMDEBUG_TRIGGER_FALLING_EDGE_SIGNED:
+	case RAMDEBUG_TRIGGER_FALLING_EDGE_UNSIGNED:
+		return falling;
+	default:
+		return rising || falling;
+	}
+}
+
+// Time of the SPI transfers for one sample of a channel [ns], 0 for channels without transfers
+static uint32_t transferTime(RAMDebugChannel *channel)
+{
+	SPIChannelTypeDef *spi;
+
+	switch(channel->type)
+	{
+	case RAMDEBUG_CHANNEL_REGISTER_CH1:
+		spi = &HAL.SPI->ch1;
+		break;
+	case RAMDEBUG_CHANNEL_REGISTER_CH2:
+		spi = &HAL.SPI->ch2;
+		break;
+	default:
+		return 0;
+	}
+
+	uint32_t datagrams = (channel->value & RAMDEBUG_REGISTER_DELAYED) ? 2 : 1;
+	uint32_t datagramTime = 40ull * 1000000000ull / MAX(spi->getFrequency(), 1) + DATAGRAM_OVERHEAD;
+
+	return datagrams * datagramTime;
+}
+
+// Highest sample frequency the register channels allow [Hz]
+static uint32_t maxFrequency(bool withTrigger)
+{
+	uint32_t time = 0;
+
+	for(uint8_t i = 0; i < channelCount; i++)
+		time += transferTime(&channels[i]);
+
+	if(withTrigger)
+		time += transferTime(&triggerChannel);
+
+	if(time == 0)
+		return RAMDEBUG_MAX_FREQUENCY;
+
+	return MIN(10000000ull * SPI_LOAD_PERCENT / time, RAMDEBUG_MAX_FREQUENCY);
+}
+
+// A running capture has to be restarted with RAMDebug_enableTrigger() after configuration changes
+static bool configurable(void)
+{
+	if(state != RAMDEBUG_IDLE && state != RAMDEBUG_COMPLETE)
+		return false;
+
+	timerStop();
+	state = RAMDEBUG_IDLE;
+	return true;
+}
+
+bool RAMDebug_addChannel(RAMDebugChannelType type, uint32_t value)
+{
+	if(channelCount >= RAMDEBUG_MAX_CHANNELS || !channelValid(type, value) || !configurable())
+		return false;
+
+	channels[channelCount].type   = type;
+	channels[channelCount].value  = value;
+	channels[channelCount].last   = 0;
+	channelCount++;
+
+	return true;
+}
+
+bool RAMDebug_setTriggerChannel(RAMDebugChannelType type, uint32_t value)
+{
+	if(!channelValid(type, value) || !configurable())
+		return false;
+
+	triggerChannel.type   = type;
+	triggerChannel.value  = value;
+	triggerChannel.last   = 0;
+
+	return true;
+}
+
+void RAMDebug_setTriggerMaskShift(uint32_t mask, uint8_t shift)
+{
+	triggerMask   = mask;
+	triggerShift  = MIN(shift, 31);
+}
+
+bool RAMDebug_setSampleCount(uint32_t count)
+{
+	if(count == 0 || count > RAMDEBUG_BUFFER_ELEMENTS || !configurable())
+		return false;
+
+	sampleCount = count;
+	return true;
+}
+
+bool RAMDebug_setPretriggerCount(uint32_t count)
+{
+	if(count > RAMDEBUG_BUFFER_ELEMENTS || !configurable())
+		return false;
+
+	pretriggerCount = count;
+	return true;
+}
+
+bool RAMDebug_setFrequency(uint32_t frequency)
+{
+	if(frequency < RAMDEBUG_MIN_FREQUENCY || frequency > RAMDEBUG_MAX_FREQUENCY || !configurable())
+		return false;
+
+	// Nearest frequency the timer can do
+	#if defined(Startrampe) || defined(Landungsbruecke)
+		uint32_t ticks = (TIMER_CLOCK + frequency / 2) / frequency;
+		uint32_t actual = TIMER_CLOCK / ticks;
+	#elif defined(Host)
+		uint32_t actual = frequency;
+	#endif
+
+	// The trigger type isn't known yet, a configured trigger channel counts
+	if(actual > maxFrequency(triggerChannel.type != RAMDEBUG_CHANNEL_DISABLED))
+		return false;
+
+	#if defined(Startrampe) || defined(Landungsbruecke)
+		timerTicks = ticks;
+	#endif
+	actualFrequency = actual;
+
+	return true;
+}
+
+bool RAMDebug_enableTrigger(RAMDebugTrigger type, int32_t threshold)
+{
+	if(type > RAMDEBUG_TRIGGER_DUAL_EDGE_UNSIGNED || channelCount == 0)
+		return false;
+
+	if(type != RAMDEBUG_TRIGGER_UNCONDITIONAL && triggerChannel.type == RAMDEBUG_CHANNEL_DISABLED)
+		return false;
+
+	// Channels added or the SCK frequency lowered after setting the sample frequency
+	if(actualFrequency > maxFrequency(type != RAMDEBUG_TRIGGER_UNCONDITIONAL))
+		return false;
+
+	timerStop();
+
+	// Whole samples only, at least one of them after the trigger
+	captureCount       = sampleCount - sampleCount % channelCount;
+	capturePretrigger  = pretriggerCount - pretriggerCount % channelCount;
+	if(captureCount == 0 || capturePretrigger >= captureCount)
+		return false;
+
+	trigger               = type;
+	triggerThreshold      = threshold;
+	triggerPreviousValid  = false;
+	writeIndex            = 0;
+	written               = 0;
+	spiCollisions         = 0;
+	state                 = (capturePretrigger) ? RAMDEBUG_PRETRIGGER : RAMDEBUG_TRIGGER;
+
+	timerStart();
+
+	return true;
+}
+
+RAMDebugState RAMDebug_getState(void)
+{
+	return state;
+}
+
+bool RAMDebug_getSample(uint32_t index, int32_t *value)
+{
+	if(state != RAMDEBUG_COMPLETE || index >= captureCount)
+		return false;
+
+	// The buffer is full when the capture completes, the oldest value is at the write index
+	index += writeIndex;
+	if(index >= captureCount)
+		index -= captureCount;
+
+	*value = buffer[index];
+	return true;
+}
+
+bool RAMDebug_getInfo(RAMDebugInfo info, uint32_t *value)
+{
+	switch(info)
+	{
+	case RAMDEBUG_INFO_MAX_CHANNELS:
+		*value = RAMDEBUG_MAX_CHANNELS;
+		break;
+	case RAMDEBUG_INFO_BUFFER_ELEMENTS:
+		*value = RAMDEBUG_BUFFER_ELEMENTS;
+		break;
+	case RAMDEBUG_INFO_FREQUENCY:
+		*value = actualFrequency;
+		break;
+	case RAMDEBUG_INFO_SAMPLE_COUNT:
+		*value = (channelCount) ? sampleCount - sampleCount % channelCount : 0;
+		break;
+	case RAMDEBUG_INFO_PRETRIGGER:
+		*value = (channelCount) ? pretriggerCount - pretriggerCount % channelCount : 0;
+		break;
+	case RAMDEBUG_INFO_SPI_COLLISIONS:
+		*value = spiCollisions;
+		break;
+	case RAMDEBUG_INFO_MAX_FREQUENCY:
+		*value = maxFrequency(triggerChannel.type != RAMDEBUG_CHANNEL_DISABLED);
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+bool RAMDebug_getChannel(uint8_t channel, RAMDebugChannelType *type, uint32_t *value)
+{
+	if(channel >= channelCount)
+		return false;
+
+	*type   = channels[channel].type;
+	*value  = channels[channel].value;
+	return true;
+}
@@ -0,0 +1,88 @@
+#ifndef RAM_DEBUG_H_
+#define RAM_DEBUG_H_
+
+	#include "tmc/helpers/API_Header.h"
+
+	#define RAMDEBUG_MAX_CHANNELS     4
+	#define RAMDEBUG_BUFFER_ELEMENTS  4096    // Captured values of all channels together (16KB)
+
+	#define RAMDEBUG_MIN_FREQUENCY    20      // Sample frequency limits [Hz]
+	#define RAMDEBUG_MAX_FREQUENCY    100000
+	#define RAMDEBUG_DEFAULT_FREQUENCY 1000
+
+	// Register channel value bit: The chip replies with the data of the previous datagram
+	// (e.g. TMC2130, TMC5130, TMC6200), the address gets sent twice for every sample
+	#define RAMDEBUG_REGISTER_DELAYED  0x100
+
+	typedef enum {
+		RAMDEBUG_IDLE        = 0,
+		RAMDEBUG_TRIGGER     = 1,  // Waiting for the trigger condition, pretrigger values are complete
+		RAMDEBUG_CAPTURE     = 2,  // Triggered, capturing the remaining values
+		RAMDEBUG_COMPLETE    = 3,
+		RAMDEBUG_PRETRIGGER  = 4   // Capturing the pretrigger values, trigger not checked yet
+	} RAMDebugState; // Numbers are used by TMCL_RamDebug
+
+	typedef enum {
+		RAMDEBUG_CHANNEL_DISABLED      = 0,
+		RAMDEBUG_CHANNEL_REGISTER_CH1  = 1,  // Value: Register address (| RAMDEBUG_REGISTER_DELAYED)
+		RAMDEBUG_CHANNEL_REGISTER_CH2  = 2,
+		RAMDEBUG_CHANNEL_STEPDIR       = 3,  // Value: Motor << 8 | RAMDebugStepDirValue
+		RAMDEBUG_CHANNEL_ADC           = 4   // Value: RAMDebugADC
+	} RAMDebugChannelType;
+
+	typedef enum {
+		RAMDEBUG_STEPDIR_ACTUAL_POSITION  = 0,
+		RAMDEBUG_STEPDIR_ACTUAL_VELOCITY  = 1,
+		RAMDEBUG_STEPDIR_TARGET_POSITION  = 2,
+		RAMDEBUG_STEPDIR_STATUS           = 3
+	} RAMDebugStepDirValue;
+
+	typedef enum {
+		RAMDEBUG_ADC_AIN0  = 0,
+		RAMDEBUG_ADC_AIN1  = 1,
+		RAMDEBUG_ADC_AIN2  = 2,
+		RAMDEBUG_ADC_DIO4  = 3,
+		RAMDEBUG_ADC_DIO5  = 4,
+		RAMDEBUG_ADC_VM    = 5   // Raw ADC value
+	} RAMDebugADC;
+
+	typedef enum {
+		RAMDEBUG_TRIGGER_UNCONDITIONAL           = 0,
+		RAMDEBUG_TRIGGER_RISING_EDGE_SIGNED      = 1,
+		RAMDEBUG_TRIGGER_FALLING_EDGE_SIGNED     = 2,
+		RAMDEBUG_TRIGGER_DUAL_EDGE_SIGNED        = 3,
+		RAMDEBUG_TRIGGER_RISING_EDGE_UNSIGNED    = 4,
+		RAMDEBUG_TRIGGER_FALLING_EDGE_UNSIGNED   = 5,
+		RAMDEBUG_TRIGGER_DUAL_EDGE_UNSIGNED      = 6
+	} RAMDebugTrigger;
+
+	typedef enum {
+		RAMDEBUG_INFO_MAX_CHANNELS     = 0,
+		RAMDEBUG_INFO_BUFFER_ELEMENTS  = 1,
+		RAMDEBUG_INFO_FREQUENCY        = 2,  // Actual sample frequency of the timer [Hz]
+		RAMDEBUG_INFO_SAMPLE_COUNT     = 3,  // Values of the capture (multiple of the channel count)
+		RAMDEBUG_INFO_PRETRIGGER       = 4,  // Values before the trigger
+		RAMDEBUG_INFO_SPI_COLLISIONS   = 5,  // Register samples repeated because the main loop used the SPI channel
+		RAMDEBUG_INFO_MAX_FREQUENCY    = 6   // Highest sample frequency the register channels allow [Hz]
+	} RAMDebugInfo;
+
+	void RAMDebug_init(void);
+	void RAMDebug_deInit(void);
+
+	// Configuration, only while no capture is running (RAMDEBUG_IDLE or RAMDEBUG_COMPLETE)
+	bool RAMDebug_addChannel(RAMDebugChannelType type, uint32_t value);
+	bool RAMDebug_setTriggerChannel(RAMDebugChannelType type, uint32_t value);
+	void RAMDebug_setTriggerMaskShift(uint32_t mask, uint8_t shift);
+	bool RAMDebug_setSampleCount(uint32_t count);
+	bool RAMDebug_setPretriggerCount(uint32_t count);
+	bool RAMDebug_setFrequency(uint32_t frequency);
+
+	// Starts the capture
+	bool RAMDebug_enableTrigger(RAMDebugTrigger trigger, int32_t threshold);
+
+	RAMDebugState RAMDebug_getState(void);
+	bool RAMDebug_getSample(uint32_t index, int32_t *value);
+	bool RAMDebug_getInfo(RAMDebugInfo info, uint32_t *value);
+	bool RAMDebug_getChannel(uint8_t channel, RAMDebugChannelType *type, uint32_t *value);
+
+#endif /* RAM_DEBUG_H_ */
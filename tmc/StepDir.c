@@ -12,6 +12,16 @@
  *   A high frequency (2^17 Hz) Interrupt calculates acceleration, velocity and
  *   position. Position and velocity are calculated with 17 binary decimal places
  *   of precision.
+ *   The interrupt frequency can be raised to 2^18 or 2^19 Hz with
+ *   setBaseFrequency() while all channels stand still. The ramp precision
+ *   follows the frequency, so velocities stay in pps and accelerations in pps^2,
+ *   the maximum velocity rises with the frequency. Jerk times are counted in
+ *   interrupt ticks and get shorter accordingly.
+ *
+ *   The interrupt only services channels with step and direction pins set
+ *   (setPins()), so boards with a single motor do not pay for the second channel.
+ *   At constant velocity in velocity mode only the position accumulator changes,
+ *   the interrupt handles that case itself instead of calling the ramp.
  *
  * Velocity mode:
  *   In velocity mode, the generator will accelerate towards a target velocity.
@@ -51,6 +61,118 @@
  *   position differences. Decreasing acceleration or moving the target position
  *   towards the actual position might result in bigger misses of the target.
  *
+ * Step timed interrupt:
+ *   With setStepTimed() enabled, a board with a single active channel does not
+ *   need the interrupt every tick while the motor runs at constant velocity in
+ *   velocity mode. The interrupt then reprograms the timer period to the number
+ *   of ticks until the next step, so it only runs twice per step (or once per
+ *   longest timer period at low velocities). The steps stay on the tick grid,
+ *   the step times are the same as with the tick interrupt. Every function
+ *   changing the motion (rotate(), moveTo(), stop(), setters, ...) first switches
+ *   back to the tick interrupt, accounting for the ticks of the running period.
+ *   Ramps, position mode, S-curve mode, queued segments and coordinated moves
+ *   always use the tick interrupt.
+ *   The step pins are not timer outputs on the evaluation boards, so the step
+ *   output is still written by the interrupt. A period ending with a step is
+ *   followed by a single tick period that clears the step output again, so the
+ *   pulse is one tick high like with the tick interrupt. The following step is
+ *   at least one more tick away, which keeps the low phase at least one tick.
+ *
+ * Position compare:
+ *   Each channel has a table of up to STEPDIR_COMPARE_SIZE positions, added with
+ *   addCompare() and kept sorted. Whenever the step output reaches one of the
+ *   positions (from either side), the interrupt sets the compare output pin
+ *   of the channel high or low, counts the event and stores the cycle counter
+ *   as timestamp. The interrupt only compares against the neighbouring entries
+ *   of the output position, so the cost per tick does not depend on the table
+ *   size. Only the main code changes the table, with the interrupt locked.
+ *   Channels with compare entries always use the tick interrupt.
+ *
+ * Encoder feedback:
+ *   With setEncoderPins() a quadrature encoder is decoded by the interrupt:
+ *   Every tick samples the A and B inputs and counts the transitions. None of
+ *   the connector pins carrying the encoder signals on the evaluation boards is
+ *   a quadrature input of a timer, so the count rate is limited to one count per
+ *   tick (2^17 counts/s at 2^17 Hz). The encoder factor converts the counts to
+ *   steps (16.16 fixed point, negative for a reversed encoder).
+ *   With a maximum deviation set, the interrupt compares the step output with
+ *   the encoder position every tick. If the difference exceeds the limit, the
+ *   channel either stops with the STATUS_DEVIATION halting condition, or - with
+ *   deviation correction enabled - continues from the encoder position. Position
+ *   mode then drives the missing steps to the target. Axes of a coordinated move
+ *   always stop. Setting the maximum deviation clears the halting condition.
+ *   setActualPosition() moves the encoder position along.
+ *   Channels with an encoder always use the tick interrupt.
+ *
+ * Interrupt runtime statistics:
+ *   setCycleStatistics() measures the interrupt with the cycle counter of the
+ *   SysTick HAL (DWT cycle counter on the boards, simulated from the monotonic
+ *   clock in the host build). Minimum, average and maximum cycles are kept for
+ *   each channel and for the whole interrupt, the load is the share of the
+ *   interrupt cycles in all cycles since the reset. getCycles() returns the
+ *   values. Enabling the statistics resets them, the interrupt clears them on
+ *   its next tick. While disabled the interrupt only checks the enable flag.
+ *   The interrupt entry and the timer flag handling are not included.
+ *
+ * Parameter updates:
+ *   Setters of ramp parameters (acceleration, maximum velocity) never wait for
+ *   the interrupt. They write the new values into a pending parameter block of
+ *   the channel, the interrupt copies the pending values into the ramp at the
+ *   start of its next tick. A sequence counter guards the block: The main code
+ *   makes it odd before and even again after writing. The interrupt only takes
+ *   the block if the counter is even and has changed since the last update, an
+ *   interrupted write is therefore picked up one tick later. Several setter
+ *   calls before the next tick are applied together in the same tick.
+ *   The getters return pending values, so reading a parameter back right after
+ *   setting it gives the new value.
+ *   The braking distance correction for a new acceleration in position mode
+ *   (see above) is calculated by the interrupt with the velocity of that tick.
+ *
+ * Motion segment queue:
+ *   Instead of setting one target with moveTo(), a sequence of target positions
+ *   with their own maximum velocity and acceleration can be queued with
+ *   queueSegment(). The interrupt starts the next segment as soon as the ramp
+ *   position reaches the target of the current one. As long as the direction
+ *   does not change, the ramp target is the end of the whole chain of segments,
+ *   so the motor drives through the segment boundaries without stopping. If the
+ *   next segment has a lower maximum velocity, the interrupt lowers the velocity
+ *   early enough to enter it at its maximum velocity (lookahead of one segment).
+ *   Direction changes stop at the boundary.
+ *   The segment parameters replace the velocity and acceleration of the channel.
+ *   rotate(), moveTo(), stop() and coordinated moves drop the queued segments.
+ *
+ * Coordinated moves:
+ *   StepDir_moveToSynchronized() moves all channels to new target positions
+ *   along a straight line. A single master ramp runs along the longest axis with
+ *   the maximum velocity and acceleration of that axis. The steps of the other
+ *   axes are derived from the master steps with Bresenham's line algorithm, so
+ *   all axes start and finish together. The channel ramps are not computed while
+ *   a channel follows the master ramp. Stopping any of the axes stops the master
+ *   ramp, a halting condition on any of the axes pauses it. rotate() or moveTo()
+ *   on one of the axes aborts the coordinated move: All axes continue from their
+ *   share of the master velocity on their own ramps, the commanded axis with the
+ *   new command, the other axes brake to a stop.
+ *   With S-curve mode all axes need the same jerk time to stay on the line.
+ *
+ * S-curve mode:
+ *   Setting a jerk time switches a channel from the trapezoidal profile of the
+ *   linear ramp to a jerk-limited S-curve. The steps of the linear ramp are not
+ *   output directly but averaged over the last jerkTime interrupt ticks first.
+ *   Averaging a trapezoidal velocity profile over a window turns each change of
+ *   acceleration into a linear transition over the window length, the jerk is
+ *   therefore limited to acceleration / jerkTime. Maximum velocity and
+ *   acceleration stay the same, each ramp takes jerkTime ticks longer.
+ *   The average of the positions ends up exactly at the final position of the
+ *   linear ramp, so the target position is reached without any correction.
+ *   Velocity mode, position mode and parameter changes during a ramp behave like
+ *   with the linear ramp.
+ *
+ *   The average is tracked incrementally: Each tick the number of linear ramp
+ *   steps within the window is added to a remainder. Whenever the remainder
+ *   leaves [0, jerkTime) an output step is generated. This only takes a few
+ *   additions per tick, no multiplication or division.
+ *   The jerk time can only be changed while the channel is standing still.
+ *
  * StallGuard:
  *   The StepDir generator supports the StallGuard feature, either by a input pin
  *   signal or with external monitoring. The function periodicJob() will check,
@@ -83,12 +205,15 @@
  * Landungsbrücke, the worst case of two motors/channels (TMC2041) is able to
  * still run at 2^17 Hz. Since the bulk of the calculation is per-motor/channel,
  * using a chip with only one motor/channel would allow a frequency of 2^18 Hz.
+ * Single channel boards spending most of the time at constant velocity can go
+ * up to 2^19 Hz. Acceleration phases, S-curve mode and coordinated moves cost
+ * more per tick, the board has to pick a frequency that still fits its worst case.
  * (Note that quite a few calculations have to divide by the frequency, so
  *  choosing a power of two simplifies those to right-shifts.)
  *
  * The limit on Step pulses is one generated pulse per interrupt.
  * The maximum velocity therefore is equal to the interrupt frequency:
- *   Max Velocity: 2^17 pps = 131072 pps
+ *   Max Velocity: 2^17 pps = 131072 pps (2^19 pps = 524288 pps at 2^19 Hz)
  *
  * Each tick the acceleration value gets added to the velocity accumulator
  * variable (uint32_t). The upper 15 digits are added to the velocity, the lower
@@ -104,6 +229,10 @@
  * maximum acceleration:
  *   ceil( (VMAX- (-VMAX)) / AMAX) = ceil(8,000244) = 9
  *
+ * The S-curve step history takes 2 bits per tick of the longest jerk time
+ * (STEPDIR_MAX_JERK_TIME) for each channel:
+ *   Max jerk time: 8192 ticks = 62.5ms, 2 KiB RAM per channel
+ *
  * ***** Side notes ******
  * [1]: Technically periodicJob() is not interrupt-safe, since it updates the
  *      haltingCondition bitfield. Read-Modify-Write cycles of the main code
@@ -117,108 +246,1041 @@
 
 #include "StepDir.h"
 #include "hal/derivative.h"
+#include "hal/SysTick.h"
+#include "boards/Board.h"
 
 #if defined(Startrampe)
 	#define TIMER_INTERRUPT TIM2_IRQHandler
 #elif defined(Landungsbruecke)
 	#define TIMER_INTERRUPT FTM1_IRQHandler
+#elif defined(Host)
+	#define TIMER_INTERRUPT StepDir_hostTimerHandler
 #endif
 
-#define STEP_DIR_CHANNELS 2
+// Timer period for an interrupt frequency of STEPDIR_FREQUENCY times 1, 2 or 4
+#if defined(Startrampe)
+	#define TIMER_PERIOD(frequency)  ((458 * STEPDIR_FREQUENCY + (frequency) / 2) / (frequency)) // 60MHz timer clock
+#elif defined(Landungsbruecke)
+	#define TIMER_PERIOD(frequency)  ((367 * STEPDIR_FREQUENCY + (frequency) / 2) / (frequency)) // 48MHz bus clock
+#endif
+
+// Longest timer period of the step timed interrupt in ticks
+#if defined(Startrampe) || defined(Landungsbruecke)
+	#define STEP_TIMED_MAX_TICKS  (65536 / TIMER_PERIOD(baseFrequency))
+#elif defined(Host)
+	#define STEP_TIMED_MAX_TICKS  1024
+#endif
+
+// IO map pin ID of the connector pin DIO<n> (DIO0 is pin ID 3, see GP 6 in TMCL.c)
+#define COMPARE_PIN_ID(dio)  ((dio) + 3)
 
 // Reset value for stallguard threshold. Since Stallguard is motor/application-specific we can't choose a good value here,
 // so this value is rather randomly chosen. Leaving it at zero means stall detection turned off.
 #define STALLGUARD_THRESHOLD 0
 
-StepDirectionTypedef StepDir[STEP_DIR_CHANNELS];
+StepDirectionTypedef StepDir[STEP_DIR_CHANNELS];
+
+static uint32_t baseFrequency = STEPDIR_FREQUENCY;
+static volatile uint8_t activeChannels = 0; // Bit mask of the channels with step and direction pins
+
+IOPinTypeDef DummyPin = { .bitWeight = DUMMY_BITWEIGHT };
+
+// Compiler barrier for data shared with the interrupt
+#define BARRIER() __asm__ volatile("" ::: "memory")
+
+// Step timed interrupt
+static bool stepTimedEnabled = false;
+static volatile bool stepTimedActive = false;
+static uint8_t stepTimedChannel;
+static uint32_t stepTimedRunning;  // Ticks of the running timer period
+static uint32_t stepTimedLoaded;   // Ticks of the following timer period
+
+#if defined(Host)
+	// Emulated timer reload, the periodic handler runs every tick
+	static uint32_t hostTimerCount = 0;
+	static uint32_t hostTimerPeriod = 1;
+	static uint32_t hostTimerLoad = 1;
+#endif
+
+// Interrupt runtime statistics in CPU cycles
+typedef struct
+{
+	uint32_t  min;
+	uint32_t  max;
+	uint64_t  sum;
+	uint32_t  count;
+} CycleStatistics;
+
+static volatile bool cycleStatisticsEnabled = false;
+static volatile bool cycleStatisticsReset = false;      // Main code requests clearing the statistics
+static volatile uint32_t cycleStatisticsUpdates = 0;    // Counts the measured interrupts, never cleared
+static CycleStatistics cycleStatistics[STEP_DIR_CHANNELS + 1]; // Channels, last entry: whole interrupt
+static uint64_t cycleStatisticsElapsed;  // Cycles between the measured interrupts since the reset
+static uint32_t cycleStatisticsLast;     // Cycle counter at the last interrupt entry
+
+// Coordinated moves
+static TMC_LinearRamp InterpolationRamp; // Master ramp, runs from 0 to interpolationLength
+static uint32_t interpolationLength;
+static volatile bool interpolationActive = false;
+
+int32_t calculateStepDifference(int32_t velocity, uint32_t oldAccel, uint32_t newAccel);
+
+// Constant velocity in velocity mode: Same as tmc_ramp_linear_compute() with only the position update left
+static inline int32_t cruiseStep(TMC_LinearRamp *ramp)
+{
+	int32_t dx;
+
+	ramp->accumulatorPosition += ramp->rampVelocity;
+	dx = ramp->accumulatorPosition / (int32_t) ramp->precision;
+	ramp->accumulatorPosition -= dx * (int32_t) ramp->precision;
+	ramp->rampPosition += dx;
+
+	return dx;
+}
+
+// ===== Position compare =====
+// First entry above the output position - called with the interrupt locked
+static void compareFindNext(StepDirectionTypedef *ch)
+{
+	int32_t position = ch->ramp.rampPosition - ch->jerkLag;
+	uint8_t next = 0;
+
+	while(next < ch->compareCount && ch->compares[next].position <= position)
+		next++;
+
+	ch->compareNext = next;
+}
+
+static inline void compareTrigger(StepDirectionTypedef *ch, StepDirCompare *entry)
+{
+	IOPinTypeDef *pin = ch->comparePin;
+
+	if(pin && entry->action != STEPDIR_COMPARE_NONE)
+		*((entry->action == STEPDIR_COMPARE_HIGH) ? pin->setBitRegister : pin->resetBitRegister) = pin->bitWeight;
+
+	ch->compareTimestamp = systick_getCycles();
+	ch->compareEvents++;
+}
+
+// Step of one position: Check the neighbouring entries of the new output position
+static inline void compareStep(StepDirectionTypedef *ch, int32_t dx)
+{
+	int32_t position = ch->ramp.rampPosition - ch->jerkLag;
+	uint8_t next = ch->compareNext;
+
+	if(dx > 0)
+	{	// Reached the next entry from below
+		if(next < ch->compareCount && ch->compares[next].position == position)
+		{
+			compareTrigger(ch, &ch->compares[next]);
+			ch->compareNext = next + 1;
+		}
+	}
+	else
+	{	// Left the entry of the last position downwards
+		if(next > 0 && ch->compares[next-1].position == position + 1)
+			ch->compareNext = --next;
+
+		// Reached an entry from above
+		if(next > 0 && ch->compares[next-1].position == position)
+			compareTrigger(ch, &ch->compares[next-1]);
+	}
+}
+
+// ===== Encoder feedback =====
+// Quadrature decoder: Count change for the transition from the old (upper two bits) to the new input levels.
+// Both levels changing at once means a missed transition, it is not counted.
+static const int8_t encoderTransitions[16] = { 0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0 };
+
+// Input level of a pin, read directly for the interrupt
+static inline uint8_t readPin(IOPinTypeDef *pin)
+{
+	#if defined(Startrampe)
+		return (pin->port->IDR & pin->bitWeight) ? 1 : 0;
+	#elif defined(Landungsbruecke)
+		return (GPIO_PDIR_REG(pin->GPIOBase) & pin->bitWeight) ? 1 : 0;
+	#elif defined(Host)
+		return (pin->GPIOBase->PDIR & pin->bitWeight) ? 1 : 0;
+	#endif
+}
+
+static inline int32_t encoderSteps(StepDirectionTypedef *ch)
+{
+	return (int32_t) (((int64_t) ch->encoderCount * ch->encoderFactor) >> 16) + ch->encoderOffset;
+}
+
+// Decode the encoder and check the deviation of the step output
+static inline void encoderTick(StepDirectionTypedef *ch)
+{
+	uint8_t state = (readPin(ch->encoderA) << 1) | readPin(ch->encoderB);
+
+	ch->encoderCount += encoderTransitions[(ch->encoderState << 2) | state];
+	ch->encoderState = state;
+
+	if(ch->maxDeviation == 0 || ch->haltingCondition)
+		return;
+
+	int32_t deviation = (ch->ramp.rampPosition - ch->jerkLag) - encoderSteps(ch);
+	if((uint32_t) abs(deviation) <= ch->maxDeviation)
+		return;
+
+	if(ch->deviationCorrection && !ch->interpolated)
+	{	// Continue from the encoder position
+		ch->ramp.rampPosition -= deviation;
+		ch->deviationCorrections++;
+	}
+	else
+	{
+		ch->haltingCondition |= STATUS_DEVIATION;
+	}
+}
+
+// ===== Interrupt runtime statistics =====
+static inline void addCycles(CycleStatistics *statistics, uint32_t cycles)
+{
+	if(cycles < statistics->min)
+		statistics->min = cycles;
+	if(cycles > statistics->max)
+		statistics->max = cycles;
+	statistics->sum += cycles;
+	statistics->count++;
+}
+
+// Interrupt entry: Returns the start of the measurement
+static uint32_t cycleStatisticsEnter(void)
+{
+	uint32_t now = systick_getCycles();
+
+	if(cycleStatisticsReset)
+	{
+		for(uint8_t i = 0; i < ARRAY_SIZE(cycleStatistics); i++)
+			cycleStatistics[i] = (CycleStatistics) { .min = UINT32_MAX };
+
+		cycleStatisticsElapsed  = 0;
+		cycleStatisticsReset    = false;
+	}
+	else
+	{
+		cycleStatisticsElapsed += now - cycleStatisticsLast;
+	}
+	cycleStatisticsLast = now;
+
+	return systick_getCycles();
+}
+
+// Interrupt exit: Account the cycles of the whole interrupt
+static void cycleStatisticsLeave(uint32_t start)
+{
+	addCycles(&cycleStatistics[STEP_DIR_CHANNELS], systick_getCycles() - start);
+	cycleStatisticsUpdates++;
+}
+
+// ===== Step timed interrupt =====
+// Set the length of the timer period following the running one
+static void timerLoadPeriod(uint32_t ticks)
+{
+	#if defined(Startrampe)
+		TIM_SetAutoreload(TIM2, ticks * TIMER_PERIOD(baseFrequency) - 1); // ARR is preloaded
+	#elif defined(Landungsbruecke)
+		FTM1_CNTIN = 65536 - ticks * TIMER_PERIOD(baseFrequency); // Taken over at the next overflow
+	#elif defined(Host)
+		hostTimerLoad = ticks;
+	#endif
+}
+
+// Restart the running timer period with the tick period
+static void timerRestart(void)
+{
+	#if defined(Startrampe)
+		TIM_SetAutoreload(TIM2, TIMER_PERIOD(baseFrequency) - 1);
+		TIM_GenerateEvent(TIM2, TIM_EventSource_Update);
+		TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+	#elif defined(Landungsbruecke)
+		FTM1_CNTIN = 65536 - TIMER_PERIOD(baseFrequency);
+		FTM1_CNT = 0; // Any write loads CNTIN
+	#elif defined(Host)
+		hostTimerCount   = 0;
+		hostTimerPeriod  = 1;
+		hostTimerLoad    = 1;
+	#endif
+}
+
+// Whole ticks passed in the running timer period
+static uint32_t timerElapsedTicks(void)
+{
+	#if defined(Startrampe)
+		return TIM_GetCounter(TIM2) / TIMER_PERIOD(baseFrequency);
+	#elif defined(Landungsbruecke)
+		return (FTM1_CNT - (65536 - stepTimedRunning * TIMER_PERIOD(baseFrequency))) / TIMER_PERIOD(baseFrequency);
+	#elif defined(Host)
+		return hostTimerCount;
+	#endif
+}
+
+// The running timer period ended, but the interrupt did not run yet
+static bool timerTakePending(void)
+{
+	#if defined(Startrampe)
+		if(TIM_GetITStatus(TIM2, TIM_IT_Update) == RESET)
+			return false;
+		TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+		return true;
+	#elif defined(Landungsbruecke)
+		if(!(FTM1_SC & FTM_SC_TOF_MASK))
+			return false;
+		FTM1_SC &= ~FTM_SC_TOF_MASK;
+		return true;
+	#elif defined(Host)
+		return false; // The emulated timer only runs with the interrupt
+	#endif
+}
+
+// Ticks from the end of the running period to the next step, or to the end of the step pulse
+static uint32_t stepTimedNextPeriod(TMC_LinearRamp *ramp)
+{
+	int32_t precision  = ramp->precision;
+	int32_t speed      = abs(ramp->rampVelocity);
+	int32_t accumulator = (ramp->rampVelocity > 0)? ramp->accumulatorPosition : -ramp->accumulatorPosition;
+
+	// Accumulator at the end of the running period. The period ends with a step or before it.
+	accumulator += stepTimedRunning * speed;
+
+	// The step at the end of the running period gets cleared one tick later.
+	// At most one step per two ticks (see stepTimedPossible()), so that tick has no step.
+	if(accumulator >= precision)
+		return 1;
+
+	return MIN((uint32_t) ((precision - accumulator + speed - 1) / speed), STEP_TIMED_MAX_TICKS);
+}
+
+// Move the channel by the given number of ticks at constant velocity and output the step, if any
+static void stepTimedAdvance(uint32_t ticks)
+{
+	StepDirectionTypedef *currCh = &StepDir[stepTimedChannel];
+	int32_t precision = currCh->ramp.precision;
+	int32_t dx;
+
+	// Reset step output (falling edge of last pulse)
+	*currCh->stepPin->resetBitRegister = currCh->stepPin->bitWeight;
+
+	currCh->ramp.accumulatorPosition += (int32_t) ticks * currCh->ramp.rampVelocity;
+	dx = currCh->ramp.accumulatorPosition / precision;
+	currCh->ramp.accumulatorPosition -= dx * precision;
+	currCh->ramp.rampPosition += dx;
+
+	if(dx == 0)
+		return;
+
+	*((dx > 0) ? currCh->dirPin->resetBitRegister : currCh->dirPin->setBitRegister) = currCh->dirPin->bitWeight;
+	*currCh->stepPin->setBitRegister = currCh->stepPin->bitWeight;
+}
+
+// Interrupt in step timed mode: The running period ended
+static void stepTimedEvent(void)
+{
+	uint32_t elapsed = stepTimedRunning;
+
+	stepTimedRunning = stepTimedLoaded;
+	stepTimedAdvance(elapsed);
+
+	stepTimedLoaded = stepTimedNextPeriod(&StepDir[stepTimedChannel].ramp);
+	timerLoadPeriod(stepTimedLoaded);
+}
+
+// Check at the end of a tick whether the step timed interrupt can take over
+static bool stepTimedPossible(void)
+{
+	uint8_t active = activeChannels;
+
+	if(interpolationActive)
+		return false;
+
+	// Exactly one active channel
+	if(active == 0 || (active & (active - 1)))
+		return false;
+
+	StepDirectionTypedef *ch = &StepDir[__builtin_ctz(active)];
+	int32_t velocity = ch->ramp.rampVelocity;
+
+	// Less than one step per two ticks, otherwise the tick interrupt is just as fast
+	if(velocity == 0 || abs(velocity) > (int32_t) ch->ramp.precision / 2)
+		return false;
+
+	return ch->haltingCondition == 0
+	    && ch->ramp.rampMode == TMC_RAMP_LINEAR_MODE_VELOCITY
+	    && velocity == ch->ramp.targetVelocity
+	    && ch->jerkTime == 0
+	    && ch->segmentRead == ch->segmentWrote
+	    && !ch->segmentClear
+	    && ch->parameterSequence == ch->parameterApplied
+	    && ch->compareCount == 0
+	    && ch->encoderA == NULL;
+}
+
+// Called by the tick interrupt. The running period is a single tick.
+static void enterStepTimed(void)
+{
+	stepTimedChannel  = __builtin_ctz(activeChannels);
+	stepTimedRunning  = 1;
+	stepTimedLoaded   = stepTimedNextPeriod(&StepDir[stepTimedChannel].ramp);
+	timerLoadPeriod(stepTimedLoaded);
+	stepTimedActive   = true;
+}
+
+// Switch back to the tick interrupt - called by the main code before changing the motion
+static void leaveStepTimed(void)
+{
+	if(!stepTimedActive)
+		return;
+
+	DisableInterrupts;
+	if(stepTimedActive)
+	{
+		// Finish a period that ended while the interrupt was locked
+		if(timerTakePending())
+			stepTimedEvent();
+
+		stepTimedAdvance(timerElapsedTicks());
+		timerRestart();
+		stepTimedActive = false;
+	}
+	EnableInterrupts;
+}
+
+// Feed a step of the linear ramp into the S-curve window and return the smoothed step
+static inline int32_t smoothStep(StepDirectionTypedef *channel, int32_t dx)
+{
+	uint32_t *entry = &channel->jerkHistory[channel->jerkIndex >> 4];
+	uint32_t shift = (channel->jerkIndex & 0x0F) << 1;
+	int32_t oldDx = ((int32_t) (*entry << (30 - shift))) >> 30; // Sign extend the 2 bit entry
+	int32_t step = 0;
+
+	dx = (dx > 0) - (dx < 0); // Limit: 1 Step per interrupt
+
+	*entry = (*entry & ~(3UL << shift)) | (((uint32_t) dx & 3) << shift);
+	if(++channel->jerkIndex >= channel->jerkTime)
+		channel->jerkIndex = 0;
+
+	channel->jerkWindow += dx - oldDx;
+	channel->jerkRemainder += channel->jerkWindow;
+
+	// The window moves by at most one step per tick -> at most one carry
+	if(channel->jerkRemainder >= (int32_t) channel->jerkTime)
+	{
+		channel->jerkRemainder -= channel->jerkTime;
+		step = 1;
+	}
+	else if(channel->jerkRemainder < 0)
+	{
+		channel->jerkRemainder += channel->jerkTime;
+		step = -1;
+	}
+
+	channel->jerkLag += dx - step;
+
+	if(dx)
+		channel->jerkStillTicks = 0;
+	else if(channel->jerkStillTicks < channel->jerkTime)
+		channel->jerkStillTicks++;
+
+	return step;
+}
+
+// Set the ramp target to the end of the segment chain without direction change
+static void updateSegmentChain(StepDirectionTypedef *channel)
+{
+	uint8_t wrote = channel->segmentWrote;
+	uint8_t i = channel->segmentRead;
+	int32_t end = channel->segments[i % STEPDIR_SEGMENT_QUEUE_SIZE].position;
+	int32_t distance = end - tmc_ramp_linear_get_rampPosition(&channel->ramp);
+	int32_t direction = (distance > 0) - (distance < 0);
+
+	for(i++; direction && (i != wrote); i++)
+	{
+		distance = channel->segments[i % STEPDIR_SEGMENT_QUEUE_SIZE].position - end;
+		if(((distance > 0) - (distance < 0)) != direction)
+			break;
+
+		end += distance;
+	}
+
+	tmc_ramp_linear_set_targetPosition(&channel->ramp, end);
+	channel->segmentScanned = wrote;
+}
+
+// Change the acceleration of the ramp - called by the interrupt only
+static void applyAcceleration(StepDirectionTypedef *channel, uint32_t acceleration)
+{
+	uint32_t oldAcceleration = tmc_ramp_linear_get_acceleration(&channel->ramp);
+
+	if(acceleration == oldAcceleration)
+		return;
+
+	if(tmc_ramp_linear_get_mode(&channel->ramp) == TMC_RAMP_LINEAR_MODE_POSITION)
+	{
+		// Position mode does not allow acceleration 0
+		if(acceleration == 0)
+			return;
+
+		// Keep the braking distance of the running ramp consistent with the new acceleration
+		if(oldAcceleration)
+			channel->ramp.accelerationSteps += calculateStepDifference(tmc_ramp_linear_get_rampVelocity(&channel->ramp), oldAcceleration, acceleration);
+	}
+
+	tmc_ramp_linear_set_acceleration(&channel->ramp, acceleration);
+}
+
+// Take over the pending parameters of the main code, unless it is writing them right now
+static inline void applyParameters(StepDirectionTypedef *channel)
+{
+	uint32_t sequence = channel->parameterSequence;
+
+	if(sequence & 1)
+		return;
+
+	if(channel->parameters.changed & STEPDIR_PARAMETER_VELOCITY_MAX)
+		tmc_ramp_linear_set_maxVelocity(&channel->ramp, channel->parameters.velocityMax);
+
+	if(channel->parameters.changed & STEPDIR_PARAMETER_ACCELERATION)
+		applyAcceleration(channel, channel->parameters.acceleration);
+
+	channel->parameters.changed = 0;
+	channel->parameterApplied = sequence;
+}
+
+// Main code side of the parameter sequence counter
+static inline void beginParameterUpdate(StepDirectionTypedef *channel)
+{
+	leaveStepTimed();
+	channel->parameterSequence++;
+	BARRIER();
+}
+
+static inline void endParameterUpdate(StepDirectionTypedef *channel)
+{
+	BARRIER();
+	channel->parameterSequence++;
+}
+
+// Apply the parameters of the oldest queued segment to the ramp
+static void loadSegment(StepDirectionTypedef *channel)
+{
+	StepDirSegment *segment = &channel->segments[channel->segmentRead % STEPDIR_SEGMENT_QUEUE_SIZE];
+
+	applyAcceleration(channel, segment->acceleration);
+	tmc_ramp_linear_set_maxVelocity(&channel->ramp, segment->velocityMax);
+	tmc_ramp_linear_set_mode(&channel->ramp, TMC_RAMP_LINEAR_MODE_POSITION);
+	updateSegmentChain(channel);
+
+	channel->segmentLoaded = true;
+}
+
+// Advance the motion segment queue of a channel - called each tick while segments are queued
+static inline void processSegments(StepDirectionTypedef *channel)
+{
+	if(channel->segmentClear)
+	{
+		channel->segmentRead    = channel->segmentClearIndex;
+		channel->segmentLoaded  = false;
+		channel->segmentClear   = false;
+		return;
+	}
+
+	if(channel->segmentRead == channel->segmentWrote)
+		return;
+
+	if(!channel->segmentLoaded)
+		loadSegment(channel);
+	else if(channel->segmentScanned != channel->segmentWrote)
+		updateSegmentChain(channel); // New segments may extend the chain
+
+	StepDirSegment *segment = &channel->segments[channel->segmentRead % STEPDIR_SEGMENT_QUEUE_SIZE];
+	int32_t position = tmc_ramp_linear_get_rampPosition(&channel->ramp);
+
+	if(position == segment->position)
+	{	// Segment done - continue with the next one right away
+		channel->segmentRead++;
+		channel->segmentLoaded = false;
+		if(channel->segmentRead != channel->segmentWrote)
+			loadSegment(channel);
+		return;
+	}
+
+	// Lookahead: Lower the velocity in time for a slower next segment in the same direction
+	uint8_t next = channel->segmentRead + 1;
+	if(next == channel->segmentWrote)
+		return;
+
+	StepDirSegment *nextSegment = &channel->segments[next % STEPDIR_SEGMENT_QUEUE_SIZE];
+	int64_t velocity = abs(tmc_ramp_linear_get_rampVelocity(&channel->ramp));
+
+	if(nextSegment->velocityMax >= velocity)
+		return;
+
+	if((nextSegment->position > segment->position) != (segment->position > position))
+		return; // Direction change - the ramp stops at the boundary anyway
+
+	// Braking distance to the next segment velocity: (v^2 - vNext^2) / (2a)
+	if(velocity * velocity - (int64_t) nextSegment->velocityMax * nextSegment->velocityMax >= 2 * (int64_t) segment->acceleration * abs(segment->position - position))
+		tmc_ramp_linear_set_maxVelocity(&channel->ramp, nextSegment->velocityMax);
+}
+
+// Compute the master ramp of a coordinated move and return its step (0 or 1)
+static inline int32_t interpolationStep(void)
+{
+	for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
+		if(StepDir[ch].interpolated && StepDir[ch].haltingCondition)
+			return 0; // A halted axis pauses the whole move
+
+	// Move finished or stopped -> hand the axes back to their own ramps
+	if(tmc_ramp_linear_get_rampVelocity(&InterpolationRamp) == 0
+	&& (tmc_ramp_linear_get_rampPosition(&InterpolationRamp) == (int32_t) interpolationLength
+	   || tmc_ramp_linear_get_mode(&InterpolationRamp) == TMC_RAMP_LINEAR_MODE_VELOCITY))
+	{
+		for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
+		{
+			if(!StepDir[ch].interpolated)
+				continue;
+
+			StepDir[ch].ramp.targetPosition = StepDir[ch].ramp.rampPosition;
+			StepDir[ch].interpolated = false;
+		}
+		interpolationActive = false;
+		return 0;
+	}
+
+	tmc_ramp_linear_compute(&InterpolationRamp, 1);
+
+	return tmc_ramp_linear_get_dx(&InterpolationRamp);
+}
+
+// Tick of a single channel
+static inline __attribute__((always_inline)) void channelTick(StepDirectionTypedef *currCh, int32_t masterStep)
+{
+	int32_t dx = 0;
+
+	// Encoder feedback, also while halted
+	if(currCh->encoderA)
+		encoderTick(currCh);
+
+	// Parameter changes of the main code
+	if(currCh->parameterSequence != currCh->parameterApplied)
+		applyParameters(currCh);
+
+	// If any halting condition is present, abort immediately
+	if(currCh->haltingCondition)
+		return;
+
+	// Reset step output (falling edge of last pulse)
+	*currCh->stepPin->resetBitRegister = currCh->stepPin->bitWeight;
+
+	if(currCh->interpolated)
+	{	// Bresenham: Derive the axis steps from the master steps
+		if(masterStep)
+		{
+			currCh->interpolationError += currCh->interpolationDistance;
+			if(currCh->interpolationError >= interpolationLength)
+			{
+				currCh->interpolationError -= interpolationLength;
+				dx = currCh->interpolationDirection;
+			}
+		}
+		currCh->ramp.rampPosition += dx;
+	}
+	else
+	{
+		if(currCh->segmentRead != currCh->segmentWrote || currCh->segmentClear)
+			processSegments(currCh);
+
+		if(currCh->ramp.rampMode == TMC_RAMP_LINEAR_MODE_VELOCITY && currCh->ramp.rampVelocity == currCh->ramp.targetVelocity)
+		{	// Fast path: Constant velocity
+			dx = cruiseStep(&currCh->ramp);
+		}
+		else
+		{	// Compute ramp
+			tmc_ramp_linear_compute(&currCh->ramp, 1); // delta = 1 => velocity unit: steps/delta-tick
+			dx = tmc_ramp_linear_get_dx(&currCh->ramp);
+		}
+	}
+
+	// S-curve: Output the averaged linear ramp
+	if(currCh->jerkTime)
+		dx = smoothStep(currCh, dx);
+
+	// Step
+	if(dx == 0) // No change in position -> skip step generation
+		return;
+
+	// Direction
+	*((dx > 0) ? currCh->dirPin->resetBitRegister : currCh->dirPin->setBitRegister) = currCh->dirPin->bitWeight;
+
+	// Set step output (rising edge of step pulse)
+	*currCh->stepPin->setBitRegister = currCh->stepPin->bitWeight;
+
+	// Position compare
+	if(currCh->compareCount)
+		compareStep(currCh, dx);
+}
+
+void TIMER_INTERRUPT()
+{
+#if defined(Startrampe)
+	if(TIM_GetITStatus(TIM2, TIM_IT_Update) == RESET)
+		return;
+	TIM_ClearITPendingBit(TIM2, TIM_IT_Update); // clear pending flag
+#elif defined(Landungsbruecke)
+	if(!(FTM1_SC & FTM_SC_TOF_MASK))
+		return; // Flag already handled by leaveStepTimed()
+	FTM1_SC &= ~FTM_SC_TOF_MASK; // clear timer overflow flag
+#elif defined(Host)
+	if(++hostTimerCount < hostTimerPeriod)
+		return;
+	hostTimerCount = 0;
+	hostTimerPeriod = hostTimerLoad;
+#endif
+
+	bool measure = cycleStatisticsEnabled;
+	uint32_t start = (measure) ? cycleStatisticsEnter() : 0;
+
+	if(stepTimedActive)
+	{
+		uint8_t channel = stepTimedChannel;
+
+		stepTimedEvent();
+
+		if(measure)
+		{
+			addCycles(&cycleStatistics[channel], systick_getCycles() - start);
+			cycleStatisticsLeave(start);
+		}
+		return;
+	}
+
+	// Coordinated move: Compute the master ramp once for all axes
+	int32_t masterStep = (interpolationActive) ? interpolationStep() : 0;
+
+	// Only service channels with pins, lowest channel first
+	for(uint32_t active = activeChannels; active; active &= active - 1)
+	{
+		uint8_t channel = __builtin_ctz(active);
+		uint32_t channelStart = (measure) ? systick_getCycles() : 0;
+
+		channelTick(&StepDir[channel], masterStep);
+
+		if(measure)
+			addCycles(&cycleStatistics[channel], systick_getCycles() - channelStart);
+	}
+
+	if(stepTimedEnabled && stepTimedPossible())
+		enterStepTimed();
+
+	if(measure)
+		cycleStatisticsLeave(start);
+}
+
+// Hand the axes of a coordinated move back to their own ramps at their current velocity,
+// braking to a stop. Called before a single axis command on one of the axes.
+static void abortInterpolation(uint8_t channel)
+{
+	if(!StepDir[channel].interpolated)
+		return;
+
+	DisableInterrupts;
+	if(StepDir[channel].interpolated) // The move may have ended meanwhile
+	{
+		int32_t velocity = tmc_ramp_linear_get_rampVelocity(&InterpolationRamp);
+
+		for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
+		{
+			if(!StepDir[ch].interpolated)
+				continue;
+
+			tmc_ramp_linear_set_mode(&StepDir[ch].ramp, TMC_RAMP_LINEAR_MODE_VELOCITY);
+			tmc_ramp_linear_set_targetVelocity(&StepDir[ch].ramp, 0);
+			tmc_ramp_linear_set_rampVelocity(&StepDir[ch].ramp,
+					((int64_t) velocity * StepDir[ch].interpolationDistance * StepDir[ch].interpolationDirection) / (int32_t) interpolationLength);
+			StepDir[ch].interpolated = false;
+		}
+		interpolationActive = false;
+	}
+	EnableInterrupts;
+}
+
+void StepDir_rotate(uint8_t channel, int velocity)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	abortInterpolation(channel);
+	StepDir_clearSegments(channel);
+
+	// Set the rampmode first - other way around might cause issues
+	tmc_ramp_linear_set_mode(&StepDir[channel].ramp, TMC_RAMP_LINEAR_MODE_VELOCITY);
+	switch(StepDir[channel].mode) {
+	case STEPDIR_INTERNAL:
+		tmc_ramp_linear_set_targetVelocity(&StepDir[channel].ramp, MIN((int32_t) baseFrequency, velocity));
+		break;
+	case STEPDIR_EXTERNAL:
+	default:
+		tmc_ramp_linear_set_targetVelocity(&StepDir[channel].ramp, velocity);
+		break;
+	}
+}
+
+void StepDir_moveTo(uint8_t channel, int position)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	abortInterpolation(channel);
+	StepDir_clearSegments(channel);
+
+	tmc_ramp_linear_set_mode(&StepDir[channel].ramp, TMC_RAMP_LINEAR_MODE_POSITION);
+	tmc_ramp_linear_set_targetPosition(&StepDir[channel].ramp, position);
+}
+
+// Queue a segment to the given position, see "Motion segment queue" above.
+// Returns false if the queue is full.
+bool StepDir_queueSegment(uint8_t channel, int32_t position, uint32_t velocityMax, uint32_t acceleration)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return false;
+
+	// Position mode does not allow acceleration 0
+	if(acceleration == 0)
+		return false;
+
+	leaveStepTimed();
+
+	StepDirectionTypedef *ch = &StepDir[channel];
+	uint8_t wrote = ch->segmentWrote;
+
+	if((uint8_t) (wrote - ch->segmentRead) >= STEPDIR_SEGMENT_QUEUE_SIZE)
+		return false;
+
+	StepDirSegment *segment = &ch->segments[wrote % STEPDIR_SEGMENT_QUEUE_SIZE];
+	segment->position      = position;
+	segment->velocityMax   = velocityMax;
+	segment->acceleration  = acceleration;
+
+	// Segment data has to be complete before the interrupt sees the new index
+	BARRIER();
+	ch->segmentWrote = wrote + 1;
+
+	return true;
+}
+
+uint8_t StepDir_getFreeSegments(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return STEPDIR_SEGMENT_QUEUE_SIZE - (uint8_t) (StepDir[channel].segmentWrote - StepDir[channel].segmentRead);
+}
+
+// Drop all queued segments. The interrupt does this on its next tick, segments queued afterwards are kept.
+void StepDir_clearSegments(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	leaveStepTimed();
+
+	StepDir[channel].segmentClearIndex = StepDir[channel].segmentWrote;
+	StepDir[channel].segmentClear = true;
+}
+
+// Add a position to the compare table with the action set by setCompareAction().
+// Returns false if the table is full or already contains the position.
+bool StepDir_addCompare(uint8_t channel, int32_t position)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return false;
+
+	StepDirectionTypedef *ch = &StepDir[channel];
+	uint8_t i;
+
+	if(ch->compareCount >= STEPDIR_COMPARE_SIZE)
+		return false;
+
+	leaveStepTimed();
+
+	DisableInterrupts;
+	for(i = ch->compareCount; i > 0 && ch->compares[i-1].position > position; i--)
+		ch->compares[i] = ch->compares[i-1];
+
+	if(i > 0 && ch->compares[i-1].position == position)
+	{	// Undo the shift
+		for(; i < ch->compareCount; i++)
+			ch->compares[i] = ch->compares[i+1];
+		EnableInterrupts;
+		return false;
+	}
+
+	ch->compares[i].position  = position;
+	ch->compares[i].action    = ch->compareAction;
+	ch->compareCount++;
+	compareFindNext(ch);
+	EnableInterrupts;
+
+	return true;
+}
+
+// Decode a quadrature encoder on the given input pins, NULL disables the encoder feedback.
+// The encoder position starts at the actual position.
+void StepDir_setEncoderPins(uint8_t channel, IOPinTypeDef *encoderA, IOPinTypeDef *encoderB)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	StepDirectionTypedef *ch = &StepDir[channel];
+
+	if(!encoderA || !encoderB)
+		encoderA = encoderB = NULL;
+
+	leaveStepTimed();
+
+	DisableInterrupts;
+	ch->encoderA  = encoderA;
+	ch->encoderB  = encoderB;
+	if(encoderA)
+	{
+		ch->encoderState  = (readPin(encoderA) << 1) | readPin(encoderB);
+		ch->encoderCount  = 0;
+		ch->encoderOffset = ch->ramp.rampPosition - ch->jerkLag;
+	}
+	ch->haltingCondition &= ~STATUS_DEVIATION;
+	EnableInterrupts;
+}
+
+// Remove all compare positions and reset the event counter
+void StepDir_clearCompares(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	DisableInterrupts;
+	StepDir[channel].compareCount      = 0;
+	StepDir[channel].compareNext       = 0;
+	StepDir[channel].compareEvents     = 0;
+	StepDir[channel].compareTimestamp  = 0;
+	EnableInterrupts;
+}
+
+// Axis parameters 54-58 of the position compare, shared by the boards using the StepDir generator.
+// Returns TMC_ERROR_TYPE for other types, so the boards can call it from the default case.
+uint32_t StepDir_handleCompareParameter(uint8_t type, uint8_t channel, int32_t *value, uint8_t readWrite)
+{
+	uint32_t errors = TMC_ERROR_NONE;
+
+	switch(type)
+	{
+	case 54: // Compare output: DIO number 0-11, -1: none (timestamps only)
+		if(readWrite == READ) {
+			*value = StepDir_getComparePin(channel);
+		} else if(readWrite == WRITE) {
+			if(!StepDir_setComparePin(channel, *value))
+				errors |= TMC_ERROR_VALUE;
+		}
+		break;
+	case 55: // Compare action of added positions: 0: output low, 1: output high, 2: timestamp only
+		if(readWrite == READ) {
+			*value = StepDir_getCompareAction(channel);
+		} else if(readWrite == WRITE) {
+			if(!StepDir_setCompareAction(channel, *value))
+				errors |= TMC_ERROR_VALUE;
+		}
+		break;
+	case 56: // Write adds a compare position, read gives the number of positions
+		if(readWrite == READ) {
+			*value = StepDir_getCompareCount(channel);
+		} else if(readWrite == WRITE) {
+			if(!StepDir_addCompare(channel, *value))
+				errors |= TMC_ERROR_VALUE;
+		}
+		break;
+	case 57: // Compare events, write clears the positions and events
+		if(readWrite == READ) {
+			*value = StepDir_getCompareEvents(channel);
+		} else if(readWrite == WRITE) {
+			StepDir_clearCompares(channel);
+		}
+		break;
+	case 58: // Timestamp of the last compare event [CPU cycles]
+		if(readWrite == READ) {
+			*value = StepDir_getCompareTimestamp(channel);
+		} else if(readWrite == WRITE) {
+			errors |= TMC_ERROR_TYPE;
+		}
+		break;
+	default:
+		errors |= TMC_ERROR_TYPE;
+		break;
+	}
+
+	return errors;
+}
 
-IOPinTypeDef DummyPin = { .bitWeight = DUMMY_BITWEIGHT };
+// Move all channels to the given positions along a straight line, see "Coordinated moves" above.
+// Returns false without moving if any of the moving axes is not standing still.
+bool StepDir_moveToSynchronized(const int32_t position[])
+{
+	int32_t distance[STEP_DIR_CHANNELS];
+	uint8_t master = 0;
 
-int32_t calculateStepDifference(int32_t velocity, uint32_t oldAccel, uint32_t newAccel);
+	if(interpolationActive)
+		return false;
 
-void TIMER_INTERRUPT()
-{
-#ifdef Startrampe
-	if(TIM_GetITStatus(TIM2, TIM_IT_Update) == RESET)
-		return;
-	TIM_ClearITPendingBit(TIM2, TIM_IT_Update); // clear pending flag
-#else
-	FTM1_SC &= ~FTM_SC_TOF_MASK; // clear timer overflow flag
-#endif
+	leaveStepTimed();
 
 	for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
 	{
-		// Temporary variable for the current channel
-		StepDirectionTypedef *currCh = &StepDir[ch];
+		// Distance of the linear ramp - an S-curve output catches up at the end
+		distance[ch] = position[ch] - tmc_ramp_linear_get_rampPosition(&StepDir[ch].ramp);
 
-		// If any halting condition is present, abort immediately
-		if(currCh->haltingCondition)
+		if(distance[ch] == 0)
 			continue;
 
-		// Reset step output (falling edge of last pulse)
-		*currCh->stepPin->resetBitRegister = currCh->stepPin->bitWeight;
-
-		// Compute ramp
-		if(currCh)
-			tmc_ramp_linear_compute(&currCh->ramp, 1); // delta = 1 => velocity unit: steps/delta-tick
+		if(StepDir[ch].haltingCondition || tmc_ramp_linear_get_rampVelocity(&StepDir[ch].ramp) != 0)
+			return false;
 
-		// Step
-		if(tmc_ramp_linear_get_dx(&currCh->ramp) == 0) // No change in position -> skip step generation
-			goto skipStep;
+		if(abs(distance[ch]) > abs(distance[master]))
+			master = ch;
+	}
 
-		// Direction
-		*((tmc_ramp_linear_get_dx(&currCh->ramp) > 0) ? currCh->dirPin->resetBitRegister : currCh->dirPin->setBitRegister) = currCh->dirPin->bitWeight;
+	if(distance[master] == 0)
+		return true;
 
-		// Set step output (rising edge of step pulse)
-		*currCh->stepPin->setBitRegister = currCh->stepPin->bitWeight;
+	interpolationLength = abs(distance[master]);
 
-skipStep:
-		// Synchronised Acceleration update
-		switch(currCh->syncFlag)
-		{
-		case SYNC_SNAPSHOT_REQUESTED:
-			// Apply the new acceleration
-			tmc_ramp_linear_set_acceleration(&currCh->ramp, currCh->newAcceleration);
-			// Save a snapshot of the velocity
-			currCh->oldVelocity  = tmc_ramp_linear_get_rampVelocity(&currCh->ramp);
+	for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
+	{
+		if(distance[ch] == 0)
+			continue;
 
-			currCh->syncFlag = SYNC_SNAPSHOT_SAVED;
-			break;
-		case SYNC_UPDATE_DATA:
-			currCh->ramp.accelerationSteps += currCh->stepDifference;
-			currCh->syncFlag = SYNC_IDLE;
-			break;
-		default:
-			break;
-		}
+		StepDir[ch].interpolationDirection  = (distance[ch] > 0) ? 1 : -1;
+		StepDir[ch].interpolationDistance   = abs(distance[ch]);
+		StepDir[ch].interpolationError      = interpolationLength / 2; // Round to the nearest step
+		// Stop the channel ramp first, the target is only kept for the end of the move
+		StepDir[ch].interpolated = true;
+		StepDir_clearSegments(ch);
+		tmc_ramp_linear_set_mode(&StepDir[ch].ramp, TMC_RAMP_LINEAR_MODE_POSITION);
+		tmc_ramp_linear_set_targetPosition(&StepDir[ch].ramp, tmc_ramp_linear_get_rampPosition(&StepDir[ch].ramp) + distance[ch]);
 	}
-}
-
-void StepDir_rotate(uint8_t channel, int velocity)
-{
-	if(channel >= STEP_DIR_CHANNELS)
-		return;
 
-	// Set the rampmode first - other way around might cause issues
-	tmc_ramp_linear_set_mode(&StepDir[channel].ramp, TMC_RAMP_LINEAR_MODE_VELOCITY);
-	switch(StepDir[channel].mode) {
-	case STEPDIR_INTERNAL:
-		tmc_ramp_linear_set_targetVelocity(&StepDir[channel].ramp, MIN(STEPDIR_MAX_VELOCITY, velocity));
-		break;
-	case STEPDIR_EXTERNAL:
-	default:
-		tmc_ramp_linear_set_targetVelocity(&StepDir[channel].ramp, velocity);
-		break;
-	}
-}
+	// The master ramp uses the limits of the longest axis
+	tmc_ramp_linear_init(&InterpolationRamp);
+	tmc_ramp_linear_set_precision(&InterpolationRamp, baseFrequency);
+	tmc_ramp_linear_set_maxVelocity(&InterpolationRamp, tmc_ramp_linear_get_maxVelocity(&StepDir[master].ramp));
+	tmc_ramp_linear_set_acceleration(&InterpolationRamp, tmc_ramp_linear_get_acceleration(&StepDir[master].ramp));
+	tmc_ramp_linear_set_mode(&InterpolationRamp, TMC_RAMP_LINEAR_MODE_POSITION);
+	tmc_ramp_linear_set_targetPosition(&InterpolationRamp, interpolationLength);
 
-void StepDir_moveTo(uint8_t channel, int position)
-{
-	if(channel >= STEP_DIR_CHANNELS)
-		return;
+	// Master ramp and axis data have to be complete before the interrupt starts the move
+	BARRIER();
+	interpolationActive = true;
 
-	tmc_ramp_linear_set_mode(&StepDir[channel].ramp, TMC_RAMP_LINEAR_MODE_POSITION);
-	tmc_ramp_linear_set_targetPosition(&StepDir[channel].ramp, position);
+	return true;
 }
 
 void StepDir_periodicJob(uint8_t channel)
@@ -232,9 +1294,22 @@ void StepDir_periodicJob(uint8_t channel)
 
 void StepDir_stop(uint8_t channel, StepDirStop stopType)
 {
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	leaveStepTimed();
+
 	switch(stopType)
 	{
 	case STOP_NORMAL:
+		StepDir_clearSegments(channel);
+
+		if(StepDir[channel].interpolated)
+		{	// Stop the whole coordinated move
+			tmc_ramp_linear_set_targetVelocity(&InterpolationRamp, 0);
+			tmc_ramp_linear_set_mode(&InterpolationRamp, TMC_RAMP_LINEAR_MODE_VELOCITY);
+			break;
+		}
 		tmc_ramp_linear_set_targetVelocity(&StepDir[channel].ramp, 0);
 		tmc_ramp_linear_set_mode(&StepDir[channel].ramp, TMC_RAMP_LINEAR_MODE_VELOCITY);
 		break;
@@ -271,6 +1346,8 @@ void StepDir_setPins(uint8_t channel, IOPinTypeDef *stepPin, IOPinTypeDef *dirPi
 	if(channel >= STEP_DIR_CHANNELS)
 		return;
 
+	leaveStepTimed();
+
 	if(stepPin)
 	{
 		StepDir[channel].stepPin = stepPin;
@@ -291,6 +1368,11 @@ void StepDir_setPins(uint8_t channel, IOPinTypeDef *stepPin, IOPinTypeDef *dirPi
 
 	if(stallPin)
 		StepDir[channel].stallGuardPin = stallPin;
+
+	if(IS_DUMMY_PIN(StepDir[channel].stepPin) || IS_DUMMY_PIN(StepDir[channel].dirPin))
+		activeChannels &= ~(1 << channel);
+	else
+		activeChannels |= 1 << channel;
 }
 
 void StepDir_stallGuard(uint8_t channel, bool sg)
@@ -319,6 +1401,8 @@ void StepDir_setActualPosition(uint8_t channel, int actualPosition)
 	if(channel >= STEP_DIR_CHANNELS)
 		return;
 
+	leaveStepTimed();
+
 	if(tmc_ramp_linear_get_mode(&StepDir[channel].ramp) == TMC_RAMP_LINEAR_MODE_POSITION)
 	{
 		// In position mode: If we're not idle -> abort
@@ -334,8 +1418,8 @@ void StepDir_setActualPosition(uint8_t channel, int actualPosition)
 //		StepDir[channel].velocityMax = 0;
 
 		// Also update target position to prevent movement
-		tmc_ramp_linear_set_targetPosition(&StepDir[channel].ramp, actualPosition);
-		tmc_ramp_linear_set_rampPosition(&StepDir[channel].ramp, actualPosition);
+		tmc_ramp_linear_set_targetPosition(&StepDir[channel].ramp, actualPosition + StepDir[channel].jerkLag);
+		tmc_ramp_linear_set_rampPosition(&StepDir[channel].ramp, actualPosition + StepDir[channel].jerkLag);
 
 		// Restore VMAX
 //		StepDir[channel].velocityMax = tmp;
@@ -343,69 +1427,46 @@ void StepDir_setActualPosition(uint8_t channel, int actualPosition)
 	else
 	{
 		// In velocity mode the position is not relevant so we can just update it without precautions
-		tmc_ramp_linear_set_rampPosition(&StepDir[channel].ramp, actualPosition);
+		tmc_ramp_linear_set_rampPosition(&StepDir[channel].ramp, actualPosition + StepDir[channel].jerkLag);
+	}
+
+	if(StepDir[channel].compareCount)
+	{
+		DisableInterrupts;
+		compareFindNext(&StepDir[channel]);
+		EnableInterrupts;
 	}
+
+	if(StepDir[channel].encoderA)
+		StepDir_setEncoderPosition(channel, actualPosition);
 }
 
+// Applied by the interrupt on its next tick (see "Parameter updates" above)
 void StepDir_setAcceleration(uint8_t channel, uint32_t acceleration)
 {
 	if(channel >= STEP_DIR_CHANNELS)
 		return;
 
-	if(tmc_ramp_linear_get_mode(&StepDir[channel].ramp) == TMC_RAMP_LINEAR_MODE_VELOCITY)
-	{	// Velocity mode does not require any special actions
-		tmc_ramp_linear_set_acceleration(&StepDir[channel].ramp, acceleration);
-		return;
-	}
-
 	// Position mode does not allow acceleration 0
-	if(acceleration == 0)
+	if(acceleration == 0 && tmc_ramp_linear_get_mode(&StepDir[channel].ramp) == TMC_RAMP_LINEAR_MODE_POSITION)
 		return;
 
-	tmc_ramp_linear_set_acceleration(&StepDir[channel].ramp, acceleration);
-
-	// Store the old acceleration
-	uint32_t oldAcceleration = tmc_ramp_linear_get_acceleration(&StepDir[channel].ramp);
-
-	// If the channel is not halted we need to synchronise with the interrupt
-	if(StepDir[channel].haltingCondition == 0)
-	{
-		// Sync mechanism: store the new acceleration value and request
-		// a snapshot from the interrupt
-		StepDir[channel].newAcceleration = acceleration;
-		StepDir[channel].syncFlag = SYNC_SNAPSHOT_REQUESTED;
-		// Wait for the flag update from the interrupt.
-		while(ACCESS_ONCE(StepDir[channel].syncFlag) != SYNC_SNAPSHOT_SAVED); // todo CHECK 2: Timeout to prevent deadlock? (LH) #1
-	}
-	else
-	{	// Channel is halted -> access data directly without sync mechanism
-		//StepDir[channel].acceleration = acceleration;
-		tmc_ramp_linear_set_acceleration(&StepDir[channel].ramp, acceleration);
-		StepDir[channel].oldVelocity = tmc_ramp_linear_get_rampVelocity(&StepDir[channel].ramp);
-	}
-
-	int32_t stepDifference = calculateStepDifference(StepDir[channel].oldVelocity, oldAcceleration, acceleration);
-
-	if(StepDir[channel].haltingCondition == 0)
-	{
-		StepDir[channel].stepDifference = stepDifference;
-		StepDir[channel].syncFlag = SYNC_UPDATE_DATA;
-
-		// Wait for interrupt to set flag to SYNC_IDLE
-		while(ACCESS_ONCE(StepDir[channel].syncFlag) != SYNC_IDLE); // todo CHECK 2: Timeout to prevent deadlock? (LH) #2
-	}
-	else
-	{	// Channel is halted -> access data directly without sync mechanism
-		StepDir[channel].ramp.accelerationSteps += stepDifference;
-	}
+	beginParameterUpdate(&StepDir[channel]);
+	StepDir[channel].parameters.acceleration = acceleration;
+	StepDir[channel].parameters.changed |= STEPDIR_PARAMETER_ACCELERATION;
+	endParameterUpdate(&StepDir[channel]);
 }
 
+// Applied by the interrupt on its next tick (see "Parameter updates" above)
 void StepDir_setVelocityMax(uint8_t channel, int velocityMax)
 {
 	if(channel >= STEP_DIR_CHANNELS)
 		return;
 
-	tmc_ramp_linear_set_maxVelocity(&StepDir[channel].ramp, velocityMax);
+	beginParameterUpdate(&StepDir[channel]);
+	StepDir[channel].parameters.velocityMax = velocityMax;
+	StepDir[channel].parameters.changed |= STEPDIR_PARAMETER_VELOCITY_MAX;
+	endParameterUpdate(&StepDir[channel]);
 }
 
 // Set the velocity threshold for active StallGuard. Also reset the stall flag
@@ -426,7 +1487,7 @@ void StepDir_setMode(uint8_t channel, StepDirMode mode)
 	StepDir[channel].mode = mode;
 
 	if(mode == STEPDIR_INTERNAL)
-		StepDir_setFrequency(channel, STEPDIR_FREQUENCY);
+		StepDir_setFrequency(channel, baseFrequency);
 }
 
 void StepDir_setFrequency(uint8_t channel, uint32_t frequency)
@@ -437,13 +1498,115 @@ void StepDir_setFrequency(uint8_t channel, uint32_t frequency)
 	StepDir[channel].frequency = frequency;
 }
 
+// Set the S-curve smoothing window in interrupt ticks, 0 selects the linear ramp.
+// The window has to be empty for this, so changes are ignored unless the channel is standing still.
+void StepDir_setJerkTime(uint8_t channel, uint32_t jerkTime)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	if(tmc_ramp_linear_get_rampVelocity(&StepDir[channel].ramp) != 0)
+		return;
+
+	if(StepDir[channel].jerkStillTicks < StepDir[channel].jerkTime)
+		return;
+
+	jerkTime = MIN(jerkTime, STEPDIR_MAX_JERK_TIME);
+
+	// The history is all zero now - restart it before the interrupt uses the new length
+	StepDir[channel].jerkIndex       = 0;
+	StepDir[channel].jerkStillTicks  = jerkTime;
+	StepDir[channel].jerkTime        = jerkTime;
+}
+
+void StepDir_setEncoderPosition(uint8_t channel, int32_t position)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	DisableInterrupts;
+	StepDir[channel].encoderOffset += position - encoderSteps(&StepDir[channel]);
+	EnableInterrupts;
+}
+
+// Steps per encoder count, 16.16 fixed point. The encoder position stays the same.
+void StepDir_setEncoderFactor(uint8_t channel, int32_t factor)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	StepDirectionTypedef *ch = &StepDir[channel];
+
+	DisableInterrupts;
+	int32_t position = encoderSteps(ch);
+	ch->encoderFactor = factor;
+	ch->encoderOffset += position - encoderSteps(ch);
+	EnableInterrupts;
+}
+
+// Maximum difference of step output and encoder position in steps, 0 disables the check.
+// Clears a deviation stop.
+void StepDir_setMaxDeviation(uint8_t channel, uint32_t maxDeviation)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	StepDir[channel].maxDeviation = maxDeviation;
+	StepDir[channel].haltingCondition &= ~STATUS_DEVIATION;
+}
+
+void StepDir_setDeviationCorrection(uint8_t channel, bool enable)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return;
+
+	StepDir[channel].deviationCorrection = enable;
+}
+
+// Select the compare output: DIO0 to DIO11 of the connector, -1 for timestamps only
+bool StepDir_setComparePin(uint8_t channel, int32_t dio)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return false;
+
+	if(dio < -1 || dio > 11)
+		return false;
+
+	IOPinTypeDef *pin = NULL;
+	if(dio >= 0)
+	{
+		pin = HAL.IOs->pins->pins[COMPARE_PIN_ID(dio)];
+		HAL.IOs->config->toOutput(pin);
+	}
+
+	StepDir[channel].comparePin = pin;
+	StepDir[channel].compareDIO = dio;
+
+	return true;
+}
+
+// Output action of the positions added afterwards
+bool StepDir_setCompareAction(uint8_t channel, StepDirCompareAction action)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return false;
+
+	if(action > STEPDIR_COMPARE_NONE)
+		return false;
+
+	StepDir[channel].compareAction = action;
+
+	return true;
+}
+
 // ===== Getters =====
 int StepDir_getActualPosition(uint8_t channel)
 {
 	if(channel >= STEP_DIR_CHANNELS)
 		return -1;
 
-	return tmc_ramp_linear_get_rampPosition(&StepDir[channel].ramp);
+	// The S-curve output lags behind the linear ramp
+	return tmc_ramp_linear_get_rampPosition(&StepDir[channel].ramp) - StepDir[channel].jerkLag;
 }
 
 int StepDir_getTargetPosition(uint8_t channel)
@@ -459,6 +1622,14 @@ int StepDir_getActualVelocity(uint8_t channel)
 	if(channel >= STEP_DIR_CHANNELS)
 		return -1;
 
+	// S-curve: Average velocity over the window
+	if(StepDir[channel].jerkTime)
+		return ((int64_t) StepDir[channel].jerkWindow * baseFrequency) / (int32_t) StepDir[channel].jerkTime;
+
+	// Coordinated move: Share of the master velocity
+	if(StepDir[channel].interpolated)
+		return ((int64_t) tmc_ramp_linear_get_rampVelocity(&InterpolationRamp) * StepDir[channel].interpolationDistance * StepDir[channel].interpolationDirection) / (int32_t) interpolationLength;
+
 	return tmc_ramp_linear_get_rampVelocity(&StepDir[channel].ramp);
 }
 
@@ -475,6 +1646,9 @@ uint32_t StepDir_getAcceleration(uint8_t channel)
 	if(channel >= STEP_DIR_CHANNELS)
 		return -1;
 
+	if(StepDir[channel].parameters.changed & STEPDIR_PARAMETER_ACCELERATION)
+		return StepDir[channel].parameters.acceleration;
+
 	return tmc_ramp_linear_get_acceleration(&StepDir[channel].ramp);
 }
 
@@ -483,6 +1657,9 @@ int StepDir_getVelocityMax(uint8_t channel)
 	if(channel >= STEP_DIR_CHANNELS)
 		return -1;
 
+	if(StepDir[channel].parameters.changed & STEPDIR_PARAMETER_VELOCITY_MAX)
+		return StepDir[channel].parameters.velocityMax;
+
 	return tmc_ramp_linear_get_maxVelocity(&StepDir[channel].ramp);
 }
 
@@ -510,6 +1687,215 @@ uint32_t StepDir_getFrequency(uint8_t channel)
 	return StepDir[channel].frequency;
 }
 
+int32_t StepDir_getComparePin(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return -1;
+
+	return StepDir[channel].compareDIO;
+}
+
+StepDirCompareAction StepDir_getCompareAction(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return STEPDIR_COMPARE_NONE;
+
+	return StepDir[channel].compareAction;
+}
+
+uint8_t StepDir_getCompareCount(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return StepDir[channel].compareCount;
+}
+
+uint32_t StepDir_getCompareEvents(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return StepDir[channel].compareEvents;
+}
+
+uint32_t StepDir_getCompareTimestamp(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return StepDir[channel].compareTimestamp;
+}
+
+bool StepDir_getEncoderEnabled(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return false;
+
+	return StepDir[channel].encoderA != NULL;
+}
+
+int32_t StepDir_getEncoderPosition(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return -1;
+
+	return encoderSteps(&StepDir[channel]);
+}
+
+int32_t StepDir_getEncoderFactor(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return -1;
+
+	return StepDir[channel].encoderFactor;
+}
+
+// Step output minus encoder position
+int32_t StepDir_getDeviation(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return StepDir_getActualPosition(channel) - encoderSteps(&StepDir[channel]);
+}
+
+uint32_t StepDir_getMaxDeviation(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return StepDir[channel].maxDeviation;
+}
+
+bool StepDir_getDeviationCorrection(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return false;
+
+	return StepDir[channel].deviationCorrection;
+}
+
+uint32_t StepDir_getDeviationCorrections(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return 0;
+
+	return StepDir[channel].deviationCorrections;
+}
+
+// Select the interrupt frequency (STEPDIR_FREQUENCY, 2 * STEPDIR_FREQUENCY or STEPDIR_MAX_FREQUENCY).
+// Returns false for other values or while any channel is moving.
+bool StepDir_setBaseFrequency(uint32_t frequency)
+{
+	if(frequency != STEPDIR_FREQUENCY && frequency != 2 * STEPDIR_FREQUENCY && frequency != STEPDIR_MAX_FREQUENCY)
+		return false;
+
+	if(interpolationActive)
+		return false;
+
+	for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
+		if(tmc_ramp_linear_get_rampVelocity(&StepDir[ch].ramp) != 0)
+			return false;
+
+	if(frequency == baseFrequency)
+		return true;
+
+	DisableInterrupts;
+	baseFrequency = frequency;
+	for(uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ch++)
+	{
+		tmc_ramp_linear_set_precision(&StepDir[ch].ramp, frequency);
+		if(StepDir[ch].mode == STEPDIR_INTERNAL)
+			StepDir[ch].frequency = frequency;
+	}
+	EnableInterrupts;
+
+	#if defined(Startrampe)
+		TIM_SetAutoreload(TIM2, TIMER_PERIOD(frequency) - 1);
+	#elif defined(Landungsbruecke)
+		FTM1_CNTIN = 65536 - TIMER_PERIOD(frequency);
+	#elif defined(Host)
+		host_irq_stopPeriodic(TIMER_INTERRUPT);
+		host_irq_startPeriodic(TIMER_INTERRUPT, frequency);
+	#endif
+
+	return true;
+}
+
+uint32_t StepDir_getBaseFrequency(void)
+{
+	return baseFrequency;
+}
+
+// Enable the step timed interrupt (see "Step timed interrupt" above)
+void StepDir_setStepTimed(bool enable)
+{
+	stepTimedEnabled = enable;
+
+	if(!enable)
+		leaveStepTimed();
+}
+
+bool StepDir_getStepTimed(void)
+{
+	return stepTimedEnabled;
+}
+
+// Enabling resets the statistics, disabling keeps the values for reading
+void StepDir_setCycleStatistics(bool enable)
+{
+	if(enable)
+	{
+		cycleStatisticsReset = true;
+		BARRIER();
+	}
+	cycleStatisticsEnabled = enable;
+}
+
+bool StepDir_getCycleStatistics(void)
+{
+	return cycleStatisticsEnabled;
+}
+
+// Channel STEP_DIR_CHANNELS selects the whole interrupt
+uint32_t StepDir_getCycles(uint8_t channel, StepDirCycleValue value)
+{
+	CycleStatistics statistics;
+	uint64_t elapsed;
+	uint32_t updates;
+
+	if(channel > STEP_DIR_CHANNELS)
+		return 0;
+
+	// Copy again if the interrupt updated the statistics in between
+	do
+	{
+		updates = cycleStatisticsUpdates;
+		BARRIER();
+		statistics  = cycleStatistics[channel];
+		elapsed     = cycleStatisticsElapsed;
+		BARRIER();
+	} while(updates != cycleStatisticsUpdates);
+
+	// Reset not taken by the interrupt yet
+	if(cycleStatisticsReset || statistics.count == 0)
+		return 0;
+
+	switch(value) {
+	case STEPDIR_CYCLES_MIN:
+		return statistics.min;
+	case STEPDIR_CYCLES_AVERAGE:
+		return statistics.sum / statistics.count;
+	case STEPDIR_CYCLES_MAX:
+		return statistics.max;
+	case STEPDIR_CYCLES_LOAD:
+		return (elapsed) ? statistics.sum * 10000 / elapsed : 0;
+	}
+
+	return 0;
+}
+
 int32_t StepDir_getMaxAcceleration(uint8_t channel)
 {
 	if(channel >= STEP_DIR_CHANNELS)
@@ -526,16 +1912,48 @@ int32_t StepDir_getMaxAcceleration(uint8_t channel)
 	}
 }
 
+uint32_t StepDir_getJerkTime(uint8_t channel)
+{
+	if(channel >= STEP_DIR_CHANNELS)
+		return -1;
+
+	return StepDir[channel].jerkTime;
+}
+
+// ===== Host test hooks (see test/StepDirTest.c) =====
+#if defined(Host)
+// Runs the tick of the interrupt on a channel outside of StepDir[], which the interrupt never sees
+void StepDir_testTick(StepDirectionTypedef *channel)
+{
+	channelTick(channel, 0);
+}
+
+// Sets ramp parameters of such a channel through the pending parameter block, like the setters.
+// Only the test ticks the channel, so the step timed mode of the real channels is left alone.
+void StepDir_testSetParameters(StepDirectionTypedef *channel, uint32_t velocityMax, uint32_t acceleration)
+{
+	channel->parameterSequence++;
+	channel->parameters.velocityMax   = velocityMax;
+	channel->parameters.acceleration  = acceleration;
+	channel->parameters.changed       = STEPDIR_PARAMETER_VELOCITY_MAX | STEPDIR_PARAMETER_ACCELERATION;
+	channel->parameterSequence++;
+}
+#endif
+
 // ===================
 
 void StepDir_init()
 {
+	interpolationActive = false;
+	activeChannels = 0;
+	stepTimedActive = false;
+
 	// StepDir Channel initialisation
 	for(int i = 0; i < STEP_DIR_CHANNELS; i++)
 	{
-		StepDir[i].oldVelAccu = 0;
-		StepDir[i].oldVelocity = 0;
-		StepDir[i].newAcceleration = 0;
+		StepDir[i].parameterSequence       = 0;
+		StepDir[i].parameterApplied        = 0;
+		StepDir[i].parameters.changed      = 0;
 
 		// Set the no-pin halting conditions before changing the pins
 		// to avoid a race condition with the interrupt
@@ -548,9 +1966,46 @@ void StepDir_init()
 		StepDir[i].stallGuardThreshold    = STALLGUARD_THRESHOLD;
 
 		StepDir[i].mode                   = STEPDIR_INTERNAL;
-		StepDir[i].frequency              = STEPDIR_FREQUENCY;
+		StepDir[i].frequency              = baseFrequency;
+
+		StepDir[i].jerkTime               = 0;
+		StepDir[i].jerkIndex              = 0;
+		StepDir[i].jerkWindow             = 0;
+		StepDir[i].jerkRemainder          = 0;
+		StepDir[i].jerkLag                = 0;
+		StepDir[i].jerkStillTicks         = 0;
+		for(uint32_t j = 0; j < ARRAY_SIZE(StepDir[i].jerkHistory); j++)
+			StepDir[i].jerkHistory[j] = 0;
+
+		StepDir[i].interpolated           = false;
+
+		StepDir[i].segmentRead            = 0;
+		StepDir[i].segmentWrote           = 0;
+		StepDir[i].segmentScanned         = 0;
+		StepDir[i].segmentLoaded          = false;
+		StepDir[i].segmentClear           = false;
+		StepDir[i].segmentClearIndex      = 0;
+
+		StepDir[i].compareCount           = 0;
+		StepDir[i].compareNext            = 0;
+		StepDir[i].comparePin             = NULL;
+		StepDir[i].compareDIO             = -1;
+		StepDir[i].compareAction          = STEPDIR_COMPARE_HIGH;
+		StepDir[i].compareEvents          = 0;
+		StepDir[i].compareTimestamp       = 0;
+
+		StepDir[i].encoderA               = NULL;
+		StepDir[i].encoderB               = NULL;
+		StepDir[i].encoderState           = 0;
+		StepDir[i].encoderCount           = 0;
+		StepDir[i].encoderFactor          = 1 << 16;
+		StepDir[i].encoderOffset          = 0;
+		StepDir[i].maxDeviation           = 0;
+		StepDir[i].deviationCorrection    = false;
+		StepDir[i].deviationCorrections   = 0;
 
 		tmc_ramp_linear_init(&StepDir[i].ramp);
+		tmc_ramp_linear_set_precision(&StepDir[i].ramp, baseFrequency);
 		tmc_ramp_linear_set_maxVelocity(&StepDir[i].ramp, STEPDIR_DEFAULT_VELOCITY);
 		tmc_ramp_linear_set_acceleration(&StepDir[i].ramp, STEPDIR_DEFAULT_ACCELERATION);
 	}
@@ -563,11 +2018,12 @@ void StepDir_init()
 		// Timer 2 konfigurieren (zum Erzeugen von Geschwindigkeiten)
 		RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
 		TIM_DeInit(TIM2);
-		TIM_TimeBaseStructure.TIM_Period         = 457; // for 120MHz clock -> 60MHz
+		TIM_TimeBaseStructure.TIM_Period         = TIMER_PERIOD(baseFrequency) - 1; // for 120MHz clock -> 60MHz
 		TIM_TimeBaseStructure.TIM_Prescaler      = 0;
 		TIM_TimeBaseStructure.TIM_ClockDivision  = 0;
 		TIM_TimeBaseStructure.TIM_CounterMode    = TIM_CounterMode_Up;
 		TIM_TimeBaseInit(TIM2, &TIM_TimeBaseStructure);
+		TIM_ARRPreloadConfig(TIM2, ENABLE); // Period changes take effect with the next period (step timed interrupt)
 		TIM_ITConfig(TIM2, TIM_IT_Update, ENABLE);
 		TIM_Cmd(TIM2, ENABLE);
 
@@ -588,7 +2044,7 @@ void StepDir_init()
 		FTM1_MODE |= FTM_MODE_FTMEN_MASK | FTM_MODE_FAULTM_MASK; //enable interrupt and select all faults
 
 		// (MOD - CNTIN + 1) / CLKFrequency = Timer Period
-		FTM1_CNTIN = 65535 - 366;
+		FTM1_CNTIN = 65536 - TIMER_PERIOD(baseFrequency);
 
 		FTM1_CONF |= FTM_CONF_NUMTOF(0); // The TOF bit is set for each counter overflow
 
@@ -600,16 +2056,24 @@ void StepDir_init()
 
 		// set FTM1 interrupt handler
 		enable_irq(INT_FTM1-16);
+	#elif defined(Host)
+		// Simulated timer interrupt
+		timerRestart();
+		host_irq_startPeriodic(TIMER_INTERRUPT, baseFrequency);
 	#endif
 }
 
 void StepDir_deInit()
 {
+	stepTimedActive = false;
+
 	#if defined(Startrampe)
 		TIM_DeInit(TIM2);
 	#elif defined(Landungsbruecke)
 		SIM_SCGC6 |= SIM_SCGC6_FTM1_MASK;
 		SIM_SCGC6 &= ~SIM_SCGC6_FTM1_MASK;
+	#elif defined(Host)
+		host_irq_stopPeriodic(TIMER_INTERRUPT);
 	#endif
 }
 
@@ -8,14 +8,22 @@
 
 	#include "hal/HAL.h"
 
-	#define STEPDIR_FREQUENCY         (1 << 17)
-	#define STEPDIR_MAX_VELOCITY      STEPDIR_FREQUENCY // Limit: 1 Step per interrupt (2^17 Hz) -> 2^17 pps
+	#define STEP_DIR_CHANNELS 2
+
+	#define STEPDIR_FREQUENCY         (1 << 17)         // Default interrupt frequency
+	#define STEPDIR_MAX_FREQUENCY     (1 << 19)         // Highest selectable interrupt frequency (see StepDir_setBaseFrequency())
+	#define STEPDIR_MAX_VELOCITY      STEPDIR_FREQUENCY // Limit: 1 Step per interrupt (2^17 Hz) -> 2^17 pps. Rises with the selected interrupt frequency.
 	#define STEPDIR_MAX_ACCELERATION  2147418111        // Limit: Highest value above accumulator digits (0xFFFE0000).
 	                                                    // Any value above would lead to acceleration overflow whenever the accumulator digits overflow
 
 	#define STEPDIR_DEFAULT_ACCELERATION 100000
 	#define STEPDIR_DEFAULT_VELOCITY STEPDIR_MAX_VELOCITY
 
+	#define STEPDIR_MAX_JERK_TIME     8192 // Longest S-curve smoothing window in interrupt ticks (62.5ms at 2^17 Hz). Has to be a multiple of 16.
+
+	#define STEPDIR_SEGMENT_QUEUE_SIZE  16 // Motion segments per channel. Has to be a power of two.
+	#define STEPDIR_COMPARE_SIZE        16 // Position compare entries per channel
+
 	typedef enum {
 		STEPDIR_INTERNAL = 0,
 		STEPDIR_EXTERNAL = 1
@@ -27,12 +35,46 @@
 		STOP_STALL
 	} StepDirStop;
 
+	// Pending parameter bits (see StepDirParameters)
+	#define STEPDIR_PARAMETER_ACCELERATION  0x01
+	#define STEPDIR_PARAMETER_VELOCITY_MAX  0x02
+
+	// Parameter changes of the main code, applied by the interrupt (see "Parameter updates" in StepDir.c)
+	typedef struct
+	{
+		uint32_t  changed;  // STEPDIR_PARAMETER_* bits of the values to apply
+		uint32_t  acceleration;
+		int32_t   velocityMax;
+	} StepDirParameters;
+
+	// Interrupt runtime statistics (see StepDir_getCycles())
+	typedef enum {
+		STEPDIR_CYCLES_MIN      = 0,
+		STEPDIR_CYCLES_AVERAGE  = 1,
+		STEPDIR_CYCLES_MAX      = 2,
+		STEPDIR_CYCLES_LOAD     = 3  // Share of all CPU cycles [0.01%]
+	} StepDirCycleValue;
+
+	// Output action of a position compare entry (see StepDir_addCompare())
 	typedef enum {
-		SYNC_IDLE,                // Sync mechanism not running
-		SYNC_SNAPSHOT_REQUESTED,  // Main code saved the new acceleration and is waiting for the interrupt to save the velocity and apply the acceleration (atomically, from the StepDir generator perspective).
-		SYNC_SNAPSHOT_SAVED,      // Interrupt saved the velocity
-		SYNC_UPDATE_DATA          // Main code calculated an accelerationSteps difference which the interrupt needs to apply.
-	} StepDirSync;
+		STEPDIR_COMPARE_LOW   = 0,
+		STEPDIR_COMPARE_HIGH  = 1,
+		STEPDIR_COMPARE_NONE  = 2  // Timestamp only
+	} StepDirCompareAction;
+
+	typedef struct
+	{
+		int32_t               position;
+		StepDirCompareAction  action;
+	} StepDirCompare;
+
+	// Motion segment (see StepDir_queueSegment())
+	typedef struct
+	{
+		int32_t   position;
+		uint32_t  velocityMax;
+		uint32_t  acceleration;
+	} StepDirSegment;
 
 	// StepDir status bits
 	#define STATUS_EMERGENCY_STOP     0x01  // Halting condition - Emergency Off
@@ -42,6 +84,7 @@
 	#define STATUS_TARGET_REACHED     0x10  // Position mode status - target reached
 	#define STATUS_STALLGUARD_ACTIVE  0x20  // Stallguard status - Velocity threshold reached, Stallguard enabled
 	#define STATUS_MODE               0x40  // 0: Positioning mode, 1: Velocity mode
+	#define STATUS_DEVIATION          0x80  // Halting condition - Encoder deviation above the limit
 
 	typedef struct
 	{	// Generic parameters
@@ -54,23 +97,71 @@
 		// StepDir Pins
 		IOPinTypeDef  *stepPin;
 		IOPinTypeDef  *dirPin;
-		// Acceleration updating sync mechanism (see acceleration setter for details)
-		StepDirSync   syncFlag; // Synchronisation flag between main code & interrupt
-		// Snapshot data
-		// Interrupt -> main code
-		int32_t         oldVelocity;
-		int32_t         oldVelAccu;
-		// Main code -> interrupt
-		uint32_t        newAcceleration;
-		int32_t         stepDifference;
+		// Parameter updates (sequence counter, see "Parameter updates" in StepDir.c)
+		volatile uint32_t  parameterSequence;  // Odd while the main code writes the pending parameters
+		uint32_t           parameterApplied;   // Sequence number of the last parameters applied by the interrupt
+		StepDirParameters  parameters;         // Pending parameters
 		StepDirMode   mode;
 		uint32_t        frequency;
 
-		TMC_LinearRamp ramp, ramp_old;
+		TMC_LinearRamp ramp;
+
+		// S-curve smoothing of the linear ramp (see S-curve mode in StepDir.c)
+		uint32_t        jerkTime;        // Smoothing window in interrupt ticks, 0: linear ramp only
+		uint32_t        jerkIndex;       // Current entry of the step history
+		int32_t         jerkWindow;      // Steps of the linear ramp within the window
+		int32_t         jerkRemainder;   // Sum of the window positions modulo jerkTime
+		int32_t         jerkLag;         // Steps of the linear ramp not output yet
+		uint32_t        jerkStillTicks;  // Ticks without linear ramp steps, saturating at jerkTime
+		uint32_t        jerkHistory[STEPDIR_MAX_JERK_TIME / 16]; // Linear ramp steps, 2 bits per tick
+
+		// Coordinated move (see StepDir_moveToSynchronized())
+		bool            interpolated;            // Channel follows the master ramp instead of its own ramp
+		int32_t         interpolationDirection;
+		uint32_t        interpolationDistance;
+		uint32_t        interpolationError;      // Bresenham error term
+
+		// Motion segment queue (see StepDir_queueSegment()). Free running indices.
+		StepDirSegment    segments[STEPDIR_SEGMENT_QUEUE_SIZE];
+		volatile uint8_t  segmentRead;        // Moved by the interrupt only
+		volatile uint8_t  segmentWrote;       // Moved by the main code only
+		uint8_t           segmentScanned;     // segmentWrote when the end of the segment chain was determined
+		bool              segmentLoaded;      // Parameters of the oldest segment are applied to the ramp
+		volatile bool     segmentClear;       // Main code requests dropping the segments up to segmentClearIndex
+		volatile uint8_t  segmentClearIndex;
+
+		// Position compare (see StepDir_addCompare()). Changed by the main code with the interrupt locked.
+		StepDirCompare        compares[STEPDIR_COMPARE_SIZE]; // Sorted by position
+		uint8_t               compareCount;
+		uint8_t               compareNext;       // First entry above the output position
+		IOPinTypeDef          *comparePin;       // NULL: Timestamps only
+		int8_t                compareDIO;
+		StepDirCompareAction  compareAction;     // Action of the next added entry
+		volatile uint32_t     compareEvents;
+		volatile uint32_t     compareTimestamp;  // Cycle counter of the last event (see systick_getCycles())
+
+		// Encoder feedback (see StepDir_setEncoderPins()). Changed by the main code with the interrupt locked.
+		IOPinTypeDef      *encoderA;           // NULL: No encoder
+		IOPinTypeDef      *encoderB;
+		uint8_t           encoderState;        // Last input levels (A: bit 1, B: bit 0)
+		volatile int32_t  encoderCount;        // Quadrature counts (4 per encoder line)
+		int32_t           encoderFactor;       // Steps per count, 16.16 fixed point
+		int32_t           encoderOffset;       // Encoder position in steps at count 0
+		uint32_t          maxDeviation;        // Steps, 0: No deviation check
+		bool              deviationCorrection; // Continue from the encoder position instead of stopping
+		volatile uint32_t deviationCorrections;
 	} StepDirectionTypedef;
 
 	void StepDir_rotate(uint8_t channel, int velocity);
 	void StepDir_moveTo(uint8_t channel, int position);
+	bool StepDir_moveToSynchronized(const int32_t position[]);
+	bool StepDir_queueSegment(uint8_t channel, int32_t position, uint32_t velocityMax, uint32_t acceleration);
+	uint8_t StepDir_getFreeSegments(uint8_t channel);
+	void StepDir_clearSegments(uint8_t channel);
+	bool StepDir_addCompare(uint8_t channel, int32_t position);
+	void StepDir_setEncoderPins(uint8_t channel, IOPinTypeDef *encoderA, IOPinTypeDef *encoderB);
+	void StepDir_clearCompares(uint8_t channel);
+	uint32_t StepDir_handleCompareParameter(uint8_t type, uint8_t channel, int32_t *value, uint8_t readWrite);
 	void StepDir_periodicJob(uint8_t channel);
 	void StepDir_stop(uint8_t channel, StepDirStop stopType);
 	uint8_t StepDir_getStatus(uint8_t channel);
@@ -84,6 +175,13 @@
 	void StepDir_setStallGuardThreshold(uint8_t channel, int stallGuardThreshold);
 	void StepDir_setMode(uint8_t channel, StepDirMode mode);
 	void StepDir_setFrequency(uint8_t channel, uint32_t frequency);
+	void StepDir_setJerkTime(uint8_t channel, uint32_t jerkTime);
+	bool StepDir_setComparePin(uint8_t channel, int32_t dio);
+	bool StepDir_setCompareAction(uint8_t channel, StepDirCompareAction action);
+	void StepDir_setEncoderPosition(uint8_t channel, int32_t position);
+	void StepDir_setEncoderFactor(uint8_t channel, int32_t factor);
+	void StepDir_setMaxDeviation(uint8_t channel, uint32_t maxDeviation);
+	void StepDir_setDeviationCorrection(uint8_t channel, bool enable);
 	// ===== Getters =====
 	int StepDir_getActualPosition(uint8_t channel);
 	int StepDir_getTargetPosition(uint8_t channel);
@@ -94,7 +192,32 @@
 	int StepDir_getStallGuardThreshold(uint8_t channel);
 	StepDirMode StepDir_getMode(uint8_t channel);
 	uint32_t StepDir_getFrequency(uint8_t channel);
+	int32_t StepDir_getComparePin(uint8_t channel);
+	StepDirCompareAction StepDir_getCompareAction(uint8_t channel);
+	uint8_t StepDir_getCompareCount(uint8_t channel);
+	uint32_t StepDir_getCompareEvents(uint8_t channel);
+	uint32_t StepDir_getCompareTimestamp(uint8_t channel);
+	bool StepDir_getEncoderEnabled(uint8_t channel);
+	int32_t StepDir_getEncoderPosition(uint8_t channel);
+	int32_t StepDir_getEncoderFactor(uint8_t channel);
+	int32_t StepDir_getDeviation(uint8_t channel);
+	uint32_t StepDir_getMaxDeviation(uint8_t channel);
+	bool StepDir_getDeviationCorrection(uint8_t channel);
+	uint32_t StepDir_getDeviationCorrections(uint8_t channel);
+	bool StepDir_setBaseFrequency(uint32_t frequency);
+	uint32_t StepDir_getBaseFrequency(void);
+	void StepDir_setStepTimed(bool enable);
+	bool StepDir_getStepTimed(void);
+	void StepDir_setCycleStatistics(bool enable);
+	bool StepDir_getCycleStatistics(void);
+	uint32_t StepDir_getCycles(uint8_t channel, StepDirCycleValue value);
 	int32_t StepDir_getMaxAcceleration(uint8_t channel);
+	uint32_t StepDir_getJerkTime(uint8_t channel);
+
+	#if defined(Host) // Test hooks, see test/StepDirTest.c
+	void StepDir_testTick(StepDirectionTypedef *channel);
+	void StepDir_testSetParameters(StepDirectionTypedef *channel, uint32_t velocityMax, uint32_t acceleration);
+	#endif
 
 	void StepDir_init();
 	void StepDir_deInit(void);
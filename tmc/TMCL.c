@@ -6,6 +6,7 @@
 #include "IdDetection.h"
 #include "VitalSignsMonitor.h"
 #include "tmc/StepDir.h"
+#include "tmc/RAMDebug.h"
 #include "EEPROM.h"
 
 // these addresses are fixed
@@ -106,6 +107,12 @@
 #define TMCL_BoardMeasuredSpeed      150
 #define TMCL_BoardError              151
 #define TMCL_BoardReset              152
+#define TMCL_readRegisterBlock_1     153
+#define TMCL_readRegisterBlock_2     154
+#define TMCL_QueueSegment            155
+#define TMCL_QueueInfo               156
+#define TMCL_Telemetry               157
+#define TMCL_ExtendedFrames          158
 
 #define TMCL_WLAN                    160
 #define TMCL_WLAN_CMD                160
@@ -148,11 +155,69 @@
 #define REPLY_CHIP_READ_FAILED       11
 #define REPLY_DELAYED                128
 #define REPLY_ACTIVE_COMM            129
+#define REPLY_TELEMETRY_FRAME        130  // Pushed telemetry frame header, value: timestamp [ms]
+#define REPLY_TELEMETRY_SAMPLE       131  // Pushed telemetry sample, value: sample value
 
 // TMCL communication status
 #define TMCL_RX_ERROR_NONE      0
 #define TMCL_RX_ERROR_NODATA    1
 #define TMCL_RX_ERROR_CHECKSUM  2
+#define TMCL_RX_ERROR_FRAME     3  // Extended frame, already executed and answered
+
+// Maximum number of registers read by one register block command
+#define TMCL_REGISTER_BLOCK_MAX  128
+
+// Default for the number of datagrams processed per interface in one tmcl_process() call.
+// Bounds the main loop jitter when a host streams commands. Changeable with global parameter 7.
+#define TMCL_COMMANDS_PER_PROCESS  8
+
+// Maximum number of telemetry sources and the longest telemetry period [ms]
+#define TMCL_TELEMETRY_SOURCES     16
+#define TMCL_TELEMETRY_PERIOD_MAX  60000
+
+// Extended frames (see "Extended frames" below)
+#define TMCL_FRAME_SYNC            0xA5
+#define TMCL_FRAME_HEADER          4     // Sync, sequence number, payload length (2 bytes)
+#define TMCL_FRAME_CRC             2
+#define TMCL_FRAME_COMMAND         7     // Request payload entry: Opcode, type, motor, value
+#define TMCL_FRAME_REQUEST_MAX     252   // Request payload, 36 commands
+#define TMCL_FRAME_REPLY_MAX       2048  // Reply payload
+#define TMCL_FRAME_REPLY_ENTRY_MAX (3 + 4 * TMCL_REGISTER_BLOCK_MAX)
+#define TMCL_FRAME_TIMEOUT         50    // [ms] Pause dropping an incomplete frame
+#define TMCL_TX_TIMEOUT            100   // [ms] Longest wait for tx buffer space
+
+// SPI datagram benchmark (global parameter 8), blocks the main loop for that long
+#define TMCL_SPI_BENCHMARK_DURATION  20  // [ms]
+
+// Frame status, first byte of the reply payload
+#define TMCL_FRAME_OK              0
+#define TMCL_FRAME_CRC_ERROR       1     // Nothing executed
+#define TMCL_FRAME_INVALID_LENGTH  2     // Nothing executed
+#define TMCL_FRAME_REPLY_FULL      3     // Only the replied commands were executed
+
+typedef struct
+{
+	bool      enabled;
+	bool      discarding;  // Waiting for a pause after an invalid frame length
+	uint32_t  received;
+	uint32_t  lastByte;    // systick timestamp
+	uint8_t   buffer[TMCL_FRAME_HEADER + TMCL_FRAME_REQUEST_MAX + TMCL_FRAME_CRC];
+} TMCLFrameState;
+
+typedef enum {
+	TELEMETRY_AXIS_PARAMETER_CH1,
+	TELEMETRY_AXIS_PARAMETER_CH2,
+	TELEMETRY_REGISTER_CH1,
+	TELEMETRY_REGISTER_CH2,
+	TELEMETRY_INPUT
+} TelemetrySourceType;
+
+typedef struct
+{
+	uint8_t type;    // TelemetrySourceType
+	uint8_t motor;
+	uint8_t index;   // Axis parameter, register address or GIO input type
+} TelemetrySource;
 
 extern const char *VersionString;
 
@@ -187,11 +252,16 @@ typedef struct
 
 	uint8_t Special[9];
 	uint8_t IsSpecial;  // next transfer will not use the serial address and the checksum bytes - instead the whole datagram is filled with data (used to transmit ASCII version string)
+
+	int32_t Block[TMCL_REGISTER_BLOCK_MAX];
+	uint8_t BlockLength;  // if set, the next transfer sends one regular reply per Block value instead of the single reply (used for register block reads)
 } TMCLReplyTypeDef;
 
 void ExecuteActualCommand();
+static bool holdsBus(uint8_t opcode);
 uint8_t setTMCLStatus(uint8_t evalError);
 void rx(RXTXTypeDef *RXTX);
+static void decodeDatagram(uint8_t *cmd);
 void tx(RXTXTypeDef *RXTX);
 
 // Helper functions - used to prevent ExecuteActualCommand() from getting too big.
@@ -210,12 +280,52 @@ static void SoftwareReset(void);
 static void GetVersion(void);
 static void GetInput(void);
 static void HandleWlanCommand(void);
+static void readRegisterBlock(EvalboardFunctionsTypeDef *ch, uint32_t brownOutMask);
+static void queueSegment(void);
+static void queueInfo(void);
+static void telemetry(void);
+static void ramDebug(void);
+static void extendedFrames(void);
+static void rxFramed(uint32_t interface);
+static void executeFrame(uint32_t interface);
+static uint32_t replyEntry(uint8_t *entry);
+static void txBlock(RXTXTypeDef *RXTX, uint8_t *data, uint32_t length);
+static uint16_t crc16(const uint8_t *data, uint32_t length, uint16_t crc);
+static void telemetryProcess(void);
+static bool readInput(uint8_t type, int32_t *value);
+static void txReply(RXTXTypeDef *RXTX, int32_t value);
+static void txDatagram(RXTXTypeDef *RXTX, uint8_t status, uint8_t opcode, int32_t value);
+static bool spiBenchmark(uint8_t mode, uint32_t *rate);
 
 TMCLCommandTypeDef ActualCommand;
 TMCLReplyTypeDef ActualReply;
 RXTXTypeDef interfaces[4];
 uint32_t numberOfInterfaces;
 uint32_t resetRequest = 0;
+uint32_t commandsPerProcess = TMCL_COMMANDS_PER_PROCESS;
+
+// Velocity and acceleration for the next queued segments (0: use the channel parameters)
+static uint32_t segmentVelocity[STEP_DIR_CHANNELS] = { 0 };
+static uint32_t segmentAcceleration[STEP_DIR_CHANNELS] = { 0 };
+
+// Telemetry subscription, pushed on the interface that started it
+static uint32_t currentInterface = 0;
+static TelemetrySource telemetrySources[TMCL_TELEMETRY_SOURCES];
+static uint8_t telemetrySourceCount = 0;
+static uint32_t telemetryPeriod = 0;  // [ms], 0: off
+static uint32_t telemetryInterface = 0;
+static uint32_t telemetryLast = 0;
+static uint32_t telemetryDropped = 0;
+
+static TMCLFrameState frameStates[ARRAY_SIZE(interfaces)];
+static uint8_t frameReply[TMCL_FRAME_HEADER + TMCL_FRAME_REPLY_MAX + TMCL_FRAME_CRC];
+
+// CRC-16/CCITT (polynomial 0x1021), one table entry per nibble
+static const uint16_t crc16Table[16] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
 
 #if defined(Landungsbruecke)
 extern uint32_t BLMagic;
@@ -234,6 +344,39 @@ uint8_t setTMCLStatus(uint8_t evalError)
 	return evalError;
 }
 
+/*
+ * Commands making a single board access, ExecuteActualCommand() holds the SPI bus owner
+ * (see hal/SPI.h) across them. Only around that access, so RAMDebug register channels
+ * keep sampling while the host is polling. Register block reads and the telemetry take it
+ * per register, everything else only per datagram in the SPI HAL.
+ */
+static bool holdsBus(uint8_t opcode)
+{
+	switch(opcode)
+	{
+	case TMCL_ROR:
+	case TMCL_ROL:
+	case TMCL_MST:
+	case TMCL_MVP:
+	case TMCL_SAP:
+	case TMCL_GAP:
+	case TMCL_UF4:
+	case TMCL_UF5:
+	case TMCL_UF6:
+	case TMCL_UF_CH1:
+	case TMCL_UF_CH2:
+	case TMCL_writeRegisterChannel_1:
+	case TMCL_writeRegisterChannel_2:
+	case TMCL_readRegisterChannel_1:
+	case TMCL_readRegisterChannel_2:
+	case TMCL_MIN:
+	case TMCL_MAX:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void ExecuteActualCommand()
 {
 	ActualReply.Opcode = ActualCommand.Opcode;
@@ -247,6 +390,12 @@ void ExecuteActualCommand()
 		return;
 	}
 
+	// A single board access may need several datagrams, e.g. a register read of a chip with
+	// delayed replies. Commands with many accesses hold the bus per access (see holdsBus()).
+	bool busOwner = holdsBus(ActualCommand.Opcode);
+	if(busOwner)
+		spi_acquireBus();
+
 	switch(ActualCommand.Opcode)
 	{
 	case TMCL_ROR:
@@ -351,6 +500,9 @@ void ExecuteActualCommand()
 	case TMCL_GetIds:
 		boardAssignment();
 		break;
+	case TMCL_RamDebug:
+		ramDebug();
+		break;
 	case TMCL_UF_CH1:
 		// user function for motionController board
 		setTMCLStatus(Evalboards.ch1.userFunction(ActualCommand.Type, ActualCommand.Motor, &ActualCommand.Value.Int32));
@@ -379,6 +531,24 @@ void ExecuteActualCommand()
 		else
 			Evalboards.ch2.readRegister(ActualCommand.Motor, ActualCommand.Type, &ActualReply.Value.Int32);
 		break;
+	case TMCL_readRegisterBlock_1:
+		readRegisterBlock(&Evalboards.ch1, VSM_ERRORS_BROWNOUT_CH1);
+		break;
+	case TMCL_readRegisterBlock_2:
+		readRegisterBlock(&Evalboards.ch2, VSM_ERRORS_BROWNOUT_CH2);
+		break;
+	case TMCL_QueueSegment:
+		queueSegment();
+		break;
+	case TMCL_QueueInfo:
+		queueInfo();
+		break;
+	case TMCL_Telemetry:
+		telemetry();
+		break;
+	case TMCL_ExtendedFrames:
+		extendedFrames();
+		break;
 	case TMCL_BoardMeasuredSpeed:
 		// measured speed from motionController board or driver board depending on type
 		boardsMeasuredSpeed();
@@ -422,6 +592,9 @@ void ExecuteActualCommand()
 		ActualReply.Status = REPLY_INVALID_CMD;
 		break;
 	}
+
+	if(busOwner)
+		spi_releaseBus();
 }
 
 void tmcl_init()
@@ -431,64 +604,109 @@ void tmcl_init()
 	interfaces[1]        = *HAL.RS232;
 	interfaces[2]        = *HAL.WLAN;
 	numberOfInterfaces   = 3;
+
+	for(uint32_t i = 0; i < ARRAY_SIZE(frameStates); i++)
+	{
+		frameStates[i].enabled     = false;
+		frameStates[i].discarding  = false;
+		frameStates[i].received    = 0;
+	}
 }
 
+/*
+ * Processes the received datagrams of all interfaces.
+ *
+ * The receive buffer of each interface acts as its command queue: all complete datagrams
+ * are executed and answered right away, up to commandsPerProcess datagrams per interface
+ * and call. Remaining datagrams are handled in the next main loop iteration.
+ * An extended frame counts as one datagram.
+ */
 void tmcl_process()
 {
-	static int currentInterface = 0;
+	for(uint32_t i = 0; i < numberOfInterfaces; i++)
+	{
+		currentInterface = i;
 
-	if(ActualCommand.Error != TMCL_RX_ERROR_NODATA)
-		tx(&interfaces[currentInterface]);
+		for(uint32_t j = 0; j < commandsPerProcess; j++)
+		{
+			if(frameStates[i].enabled)
+				rxFramed(i);
+			else
+				rx(&interfaces[i]);
 
-	if(resetRequest)
-		HAL.reset(true);
+			if(ActualCommand.Error == TMCL_RX_ERROR_NODATA)
+				break;
+			if(ActualCommand.Error == TMCL_RX_ERROR_FRAME)
+				continue;
 
-	ActualReply.IsSpecial = 0;
+			ActualReply.IsSpecial = 0;
+			ActualReply.BlockLength = 0;
 
-	for(uint32_t i = 0; i < numberOfInterfaces; i++)
-	{
-		rx(&interfaces[i]);
-		if(ActualCommand.Error != TMCL_RX_ERROR_NODATA)
-		{
-			currentInterface = i;
 			ExecuteActualCommand();
-			return;
+			tx(&interfaces[i]);
+
+			if(resetRequest)
+				HAL.reset(true);
 		}
 	}
+
+	telemetryProcess();
 }
 
 void tx(RXTXTypeDef *RXTX)
 {
-	uint8_t checkSum = 0;
-
-	uint8_t reply[9];
-
 	if(ActualReply.IsSpecial)
 	{
-		for(int i = 0; i < 9; i++)
-			reply[i] = ActualReply.Special[i];
+		RXTX->txN(ActualReply.Special, 9);
+	}
+	else if(ActualReply.BlockLength)
+	{
+		// A whole block doesn't fit into the tx buffers, wait for space instead of dropping the tail
+		uint32_t progress = systick_getTick();
+		for(uint32_t i = 0; i < ActualReply.BlockLength; )
+		{
+			if(RXTX->bytesFree() < 9)
+			{
+				if(timeSince(progress) > TMCL_TX_TIMEOUT)
+					return; // The host doesn't read, the rest gets lost
+				continue;
+			}
+
+			txReply(RXTX, ActualReply.Block[i++]);
+			progress = systick_getTick();
+		}
 	}
 	else
 	{
-		checkSum += SERIAL_HOST_ADDRESS;
-		checkSum += SERIAL_MODULE_ADDRESS;
-		checkSum += ActualReply.Status;
-		checkSum += ActualReply.Opcode;
-		checkSum += ActualReply.Value.Byte[3];
-		checkSum += ActualReply.Value.Byte[2];
-		checkSum += ActualReply.Value.Byte[1];
-		checkSum += ActualReply.Value.Byte[0];
-
-		reply[0] = SERIAL_HOST_ADDRESS;
-		reply[1] = SERIAL_MODULE_ADDRESS;
-		reply[2] = ActualReply.Status;
-		reply[3] = ActualReply.Opcode;
-		reply[4] = ActualReply.Value.Byte[3];
-		reply[5] = ActualReply.Value.Byte[2];
-		reply[6] = ActualReply.Value.Byte[1];
-		reply[7] = ActualReply.Value.Byte[0];
-		reply[8] = checkSum;
+		txReply(RXTX, ActualReply.Value.Int32);
 	}
+}
+
+// Sends a regular reply datagram with the current status and opcode
+static void txReply(RXTXTypeDef *RXTX, int32_t value)
+{
+	txDatagram(RXTX, ActualReply.Status, ActualReply.Opcode, value);
+}
+
+static void txDatagram(RXTXTypeDef *RXTX, uint8_t status, uint8_t opcode, int32_t value)
+{
+	uint8_t checkSum = 0;
+
+	uint8_t reply[9];
+
+	reply[0] = SERIAL_HOST_ADDRESS;
+	reply[1] = SERIAL_MODULE_ADDRESS;
+	reply[2] = status;
+	reply[3] = opcode;
+	reply[4] = (value >> 24) & 0xFF;
+	reply[5] = (value >> 16) & 0xFF;
+	reply[6] = (value >> 8)  & 0xFF;
+	reply[7] = (value >> 0)  & 0xFF;
+
+	for(int i = 0; i < 8; i++)
+		checkSum += reply[i];
+
+	reply[8] = checkSum;
 
 	RXTX->txN(reply, 9);
 }
@@ -504,7 +722,6 @@ void txTest(uint8 ch)
 
 void rx(RXTXTypeDef *RXTX)
 {
-	uint8_t checkSum = 0;
 	uint8_t cmd[9];
 
 	if(!RXTX->rxN(cmd, 9))
@@ -513,6 +730,13 @@ void rx(RXTXTypeDef *RXTX)
 		return;
 	}
 
+	decodeDatagram(cmd);
+}
+
+static void decodeDatagram(uint8_t *cmd)
+{
+	uint8_t checkSum = 0;
+
 	// todo ADD CHECK 2: check for SERIAL_MODULE_ADDRESS byte ( cmd[0] ) ? (LH)
 
 	for(int i = 0; i < 8; i++)
@@ -534,6 +758,227 @@ void rx(RXTXTypeDef *RXTX)
 	ActualCommand.Error          = TMCL_RX_ERROR_NONE;
 }
 
+/*
+ * Extended frames
+ *
+ * Opt-in per interface with TMCL_ExtendedFrames. A frame carries a batch of commands,
+ * its reply carries all reply values including register blocks and RAM debug uploads,
+ * so bulk transfers don't pay the 9 byte datagram per 4 bytes of data.
+ * The legacy 9 byte datagrams keep working on the interface. A datagram starting with
+ * TMCL_FRAME_SYNC is taken as frame, so this module address can't be used meanwhile.
+ *
+ * Frame (both directions, multi byte values big endian):
+ *   TMCL_FRAME_SYNC, sequence number, payload length (2 bytes), payload,
+ *   CRC-16/CCITT over all previous bytes (initial value 0xFFFF, 2 bytes)
+ * Request payload: Up to 36 commands of opcode, type, motor, value (4 bytes)
+ * Reply payload: Frame status (TMCL_FRAME_*), number of executed commands, then per command
+ *   status, opcode, number of values, values (4 bytes each). Special replies (e.g. the
+ *   ASCII version) are sent as two values holding the 8 data bytes.
+ * The reply has the sequence number of the request. Commands that would not fit into
+ * the reply are not executed (TMCL_FRAME_REPLY_FULL), the host has to send them again.
+ */
+static void rxFramed(uint32_t interface)
+{
+	TMCLFrameState *frame = &frameStates[interface];
+	RXTXTypeDef *RXTX = &interfaces[interface];
+
+	ActualCommand.Error = TMCL_RX_ERROR_NODATA;
+
+	// Resynchronise on a pause, e.g. after a corrupted payload length
+	if((frame->received || frame->discarding) && timeSince(frame->lastByte) > TMCL_FRAME_TIMEOUT)
+	{
+		frame->received    = 0;
+		frame->discarding  = false;
+	}
+
+	for(;;)
+	{
+		uint32_t available = RXTX->bytesAvailable();
+		if(available == 0)
+			return;
+
+		if(frame->discarding)
+		{
+			uint8_t dropped[16];
+			if(RXTX->rxN(dropped, MIN(available, sizeof(dropped))))
+				frame->lastByte = systick_getTick();
+			continue;
+		}
+
+		// Bytes of the current datagram or frame known so far
+		uint32_t expected;
+		if(frame->received == 0)
+			expected = 1;
+		else if(frame->buffer[0] != TMCL_FRAME_SYNC)
+			expected = 9;
+		else if(frame->received < TMCL_FRAME_HEADER)
+			expected = TMCL_FRAME_HEADER;
+		else
+			expected = TMCL_FRAME_HEADER + (frame->buffer[2] << 8 | frame->buffer[3]) + TMCL_FRAME_CRC;
+
+		uint32_t count = MIN(MIN(expected - frame->received, available), 255);
+		if(!RXTX->rxN(&frame->buffer[frame->received], count))
+			return;
+
+		frame->received += count;
+		frame->lastByte = systick_getTick();
+
+		if(frame->buffer[0] != TMCL_FRAME_SYNC)
+		{
+			if(frame->received < 9)
+				continue;
+
+			frame->received = 0;
+			decodeDatagram(frame->buffer);
+			return;
+		}
+
+		if(frame->received == TMCL_FRAME_HEADER && (frame->buffer[2] << 8 | frame->buffer[3]) > TMCL_FRAME_REQUEST_MAX)
+		{
+			frame->received = 0;
+			frame->discarding = true;
+			continue;
+		}
+
+		if(frame->received < TMCL_FRAME_HEADER || frame->received < expected)
+			continue;
+
+		frame->received = 0;
+		executeFrame(interface);
+		ActualCommand.Error = TMCL_RX_ERROR_FRAME;
+		return;
+	}
+}
+
+static void executeFrame(uint32_t interface)
+{
+	uint8_t *request = frameStates[interface].buffer;
+	uint32_t length = request[2] << 8 | request[3];
+	uint16_t crc = request[TMCL_FRAME_HEADER + length] << 8 | request[TMCL_FRAME_HEADER + length + 1];
+	uint8_t *payload = &frameReply[TMCL_FRAME_HEADER];
+	uint32_t replyLength = 2;
+	uint8_t status = TMCL_FRAME_OK;
+	uint8_t commands = 0;
+
+	if(crc16(request, TMCL_FRAME_HEADER + length, 0xFFFF) != crc)
+		status = TMCL_FRAME_CRC_ERROR;
+	else if(length % TMCL_FRAME_COMMAND)
+		status = TMCL_FRAME_INVALID_LENGTH;
+
+	for(uint32_t i = TMCL_FRAME_HEADER; status == TMCL_FRAME_OK && i < TMCL_FRAME_HEADER + length; i += TMCL_FRAME_COMMAND)
+	{
+		if(replyLength + TMCL_FRAME_REPLY_ENTRY_MAX > TMCL_FRAME_REPLY_MAX)
+		{
+			status = TMCL_FRAME_REPLY_FULL;
+			break;
+		}
+
+		ActualCommand.Opcode         = request[i];
+		ActualCommand.Type           = request[i+1];
+		ActualCommand.Motor          = request[i+2];
+		ActualCommand.Value.Byte[3]  = request[i+3];
+		ActualCommand.Value.Byte[2]  = request[i+4];
+		ActualCommand.Value.Byte[1]  = request[i+5];
+		ActualCommand.Value.Byte[0]  = request[i+6];
+		ActualCommand.Error          = TMCL_RX_ERROR_NONE;
+
+		ActualReply.IsSpecial = 0;
+		ActualReply.BlockLength = 0;
+
+		ExecuteActualCommand();
+		replyLength += replyEntry(&payload[replyLength]);
+		commands++;
+
+		if(resetRequest)
+			break;
+	}
+
+	payload[0] = status;
+	payload[1] = commands;
+
+	frameReply[0] = TMCL_FRAME_SYNC;
+	frameReply[1] = request[1];
+	frameReply[2] = replyLength >> 8;
+	frameReply[3] = replyLength & 0xFF;
+
+	crc = crc16(frameReply, TMCL_FRAME_HEADER + replyLength, 0xFFFF);
+	frameReply[TMCL_FRAME_HEADER + replyLength]      = crc >> 8;
+	frameReply[TMCL_FRAME_HEADER + replyLength + 1]  = crc & 0xFF;
+
+	txBlock(&interfaces[interface], frameReply, TMCL_FRAME_HEADER + replyLength + TMCL_FRAME_CRC);
+
+	if(resetRequest)
+		HAL.reset(true);
+}
+
+// Writes the reply of the executed command as frame payload entry, returns its length
+static uint32_t replyEntry(uint8_t *entry)
+{
+	uint32_t count = 1;
+	int32_t *values = &ActualReply.Value.Int32;
+
+	entry[0] = ActualReply.Status;
+	entry[1] = ActualReply.Opcode;
+
+	if(ActualReply.IsSpecial)
+	{
+		entry[2] = 2;
+		for(uint32_t i = 0; i < 8; i++)
+			entry[3+i] = ActualReply.Special[i+1];
+		return 3 + 8;
+	}
+
+	if(ActualReply.BlockLength)
+	{
+		count = ActualReply.BlockLength;
+		values = ActualReply.Block;
+	}
+
+	entry[2] = count;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		entry[3+4*i]  = (values[i] >> 24) & 0xFF;
+		entry[4+4*i]  = (values[i] >> 16) & 0xFF;
+		entry[5+4*i]  = (values[i] >> 8)  & 0xFF;
+		entry[6+4*i]  = (values[i] >> 0)  & 0xFF;
+	}
+
+	return 3 + 4 * count;
+}
+
+// Sends a block longer than a txN() call takes, waiting for tx buffer space
+static void txBlock(RXTXTypeDef *RXTX, uint8_t *data, uint32_t length)
+{
+	uint32_t progress = systick_getTick();
+
+	while(length)
+	{
+		uint32_t count = MIN(MIN(length, 255), RXTX->bytesFree());
+		if(count == 0)
+		{
+			if(timeSince(progress) > TMCL_TX_TIMEOUT)
+				return; // The rest gets lost, the host sees a CRC error
+			continue;
+		}
+
+		RXTX->txN(data, count);
+		data      += count;
+		length    -= count;
+		progress  = systick_getTick();
+	}
+}
+
+static uint16_t crc16(const uint8_t *data, uint32_t length, uint16_t crc)
+{
+	for(uint32_t i = 0; i < length; i++)
+	{
+		crc = (crc << 4) ^ crc16Table[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ crc16Table[(crc >> 12) ^ (data[i] & 0x0F)];
+	}
+
+	return crc;
+}
+
 void tmcl_boot()
 {
 	Evalboards.driverEnable = DRIVER_DISABLE;
@@ -554,6 +999,7 @@ void tmcl_boot()
 
 	// todo: CHECK 2: Muss api_deInit hier dazu? (ED)
 	StepDir_deInit();
+	RAMDebug_deInit();
 
 	IDDetection_deInit();
 
@@ -573,6 +1019,9 @@ void tmcl_boot()
 #elif defined(Landungsbruecke)
 	BLMagic = 0x12345678;
 	HAL.reset(true);
+#elif defined(Host)
+	// No bootloader in the simulation - just end the process
+	HAL.reset(true);
 #endif
 }
 
@@ -670,6 +1119,36 @@ static void SetGlobalParameter()
 	case 6:
 		HAL.IOs->config->setToState(HAL.IOs->pins->pins[ActualCommand.Motor], ActualCommand.Value.UInt32);
 		break;
+	case 7: // Datagrams processed per interface and tmcl_process() call
+		if(ActualCommand.Value.UInt32 >= 1 && ActualCommand.Value.UInt32 <= 255)
+			commandsPerProcess = ActualCommand.Value.UInt32;
+		else
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 9: // SPI SCK frequency [Hz] of channel Motor (0: ch1, 1: ch2), 0 restores the default. Replies the actually set frequency
+		switch(ActualCommand.Motor)
+		{
+		case 0:
+			ActualReply.Value.UInt32 = HAL.SPI->ch1.setFrequency(ActualCommand.Value.UInt32);
+			break;
+		case 1:
+			ActualReply.Value.UInt32 = HAL.SPI->ch2.setFrequency(ActualCommand.Value.UInt32);
+			break;
+		default:
+			ActualReply.Status = REPLY_INVALID_VALUE;
+			break;
+		}
+		break;
+	case 10: // StepDir interrupt frequency [Hz]: 131072, 262144 or 524288. Only while all motors stand still
+		if(!StepDir_setBaseFrequency(ActualCommand.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 11: // StepDir interrupt once per step at constant velocity (0: off, 1: on)
+		StepDir_setStepTimed(ActualCommand.Value.Int32 != 0);
+		break;
+	case 12: // StepDir interrupt cycle statistics (0: off, 1: reset and on)
+		StepDir_setCycleStatistics(ActualCommand.Value.Int32 != 0);
+		break;
 	default:
 		ActualReply.Status = REPLY_INVALID_TYPE;
 		break;
@@ -703,12 +1182,117 @@ static void GetGlobalParameter()
 		case 6:
 			ActualReply.Value.UInt32 = HAL.IOs->config->getState(HAL.IOs->pins->pins[ActualCommand.Motor]);
 			break;
+		case 7:
+			ActualReply.Value.UInt32 = commandsPerProcess;
+			break;
+		case 8: // SPI datagram benchmark, see spiBenchmark()
+			if(!spiBenchmark(ActualCommand.Motor, &ActualReply.Value.UInt32))
+				ActualReply.Status = REPLY_INVALID_VALUE;
+			break;
+		case 9:
+			switch(ActualCommand.Motor)
+			{
+			case 0:
+				ActualReply.Value.UInt32 = HAL.SPI->ch1.getFrequency();
+				break;
+			case 1:
+				ActualReply.Value.UInt32 = HAL.SPI->ch2.getFrequency();
+				break;
+			default:
+				ActualReply.Status = REPLY_INVALID_VALUE;
+				break;
+			}
+			break;
+		case 10:
+			ActualReply.Value.UInt32 = StepDir_getBaseFrequency();
+			break;
+		case 11:
+			ActualReply.Value.Int32 = StepDir_getStepTimed();
+			break;
+		case 12:
+			ActualReply.Value.Int32 = StepDir_getCycleStatistics();
+			break;
+		case 13: // StepDir interrupt cycles of channel Motor (2: whole interrupt) - 13: minimum, 14: average, 15: maximum
+		case 14:
+		case 15:
+		case 16: // StepDir interrupt load of channel Motor (2: whole interrupt) [0.01%]
+			if(ActualCommand.Motor > STEP_DIR_CHANNELS)
+				ActualReply.Status = REPLY_INVALID_VALUE;
+			else
+				ActualReply.Value.UInt32 = StepDir_getCycles(ActualCommand.Motor, ActualCommand.Type - 13);
+			break;
 		default:
 			ActualReply.Status = REPLY_INVALID_TYPE;
 			break;
 	}
 }
 
+// Boards with 40 bit SPI datagrams, the write bit is part of the address byte
+static const uint8_t datagram40BoardsCh1[] =
+{
+	ID_TMC5031, ID_TMC4361, ID_TMC5130, ID_TMC5041, ID_TMC5072, ID_TMC4670, ID_TMC4331,
+	ID_TMC4361A, ID_TMC4671, ID_TMC4330, ID_TMC5160, ID_TMC5161, ID_TMC5062, ID_TMC2130_TQFP48
+};
+static const uint8_t datagram40BoardsCh2[] = { ID_TMC2130, ID_TMC2041, ID_TMC6200, ID_TMC2160 };
+
+static bool isDatagram40Board(uint8_t id, const uint8_t *ids, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i++)
+		if(ids[i] == id)
+			return true;
+
+	return false;
+}
+
+/*
+ * Measures the 40 bit datagram rate of a SPI channel for TMCL_SPI_BENCHMARK_DURATION.
+ * The datagrams read register 0. Only boards with 40 bit datagrams are supported, on them
+ * that is a true read. The 20 bit datagrams of e.g. the TMC2660 and TMC2590 always write
+ * a register.
+ *
+ * Mode bit 0: Channel (0: ch1, 1: ch2)
+ * Mode bit 1: Transfer (0: byte wise with readWrite(), 1: spi_datagram40())
+ *
+ * @return false if the board of the channel has no 40 bit datagrams, rate: Datagrams per second
+ */
+static bool spiBenchmark(uint8_t mode, uint32_t *rate)
+{
+	SPIChannelTypeDef *spi = (mode & 0x01)? &HAL.SPI->ch2 : &HAL.SPI->ch1;
+	uint32_t datagrams = 0;
+
+	if(mode & 0x01)
+	{
+		if(!isDatagram40Board(Evalboards.ch2.id, datagram40BoardsCh2, ARRAY_SIZE(datagram40BoardsCh2)))
+			return false;
+	}
+	else
+	{
+		if(!isDatagram40Board(Evalboards.ch1.id, datagram40BoardsCh1, ARRAY_SIZE(datagram40BoardsCh1)))
+			return false;
+	}
+
+	uint32_t start = systick_getTick();
+	while(timeSince(start) < TMCL_SPI_BENCHMARK_DURATION)
+	{
+		if(mode & 0x02)
+		{
+			spi_datagram40(spi, 0x00, 0);
+		}
+		else
+		{
+			spi->readWrite(0x00, false);
+			spi->readWrite(0, false);
+			spi->readWrite(0, false);
+			spi->readWrite(0, false);
+			spi->readWrite(0, true);
+		}
+		datagrams++;
+	}
+
+	*rate = datagrams * (1000 / TMCL_SPI_BENCHMARK_DURATION);
+	return true;
+}
+
 static void boardAssignment(void)
 {
 	uint8_t testOnly = 0;
@@ -763,6 +1347,380 @@ static void boardAssignment(void)
 		ActualReply.Value.Int32 = Board_supported(&ids_buff);
 }
 
+/*
+ * Reads a block of consecutive registers in one request.
+ *
+ * Type:  Address of the first register
+ * Motor: Motor
+ * Value: Number of registers (1 ... TMCL_REGISTER_BLOCK_MAX)
+ *
+ * The reply is a sequence of Value regular replies, one per register in ascending address order.
+ * On errors only a single reply with the error status is sent.
+ */
+static void readRegisterBlock(EvalboardFunctionsTypeDef *ch, uint32_t brownOutMask)
+{
+	uint32_t count = ActualCommand.Value.UInt32;
+
+	if(count == 0 || count > TMCL_REGISTER_BLOCK_MAX || ActualCommand.Type + count > 0x100)
+	{
+		ActualReply.Status = REPLY_INVALID_VALUE;
+		return;
+	}
+
+	if(VitalSignsMonitor.brownOut & brownOutMask)
+	{
+		ActualReply.Status = REPLY_CHIP_READ_FAILED;
+		return;
+	}
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		ActualReply.Block[i] = 0;
+		spi_acquireBus();
+		ch->readRegister(ActualCommand.Motor, ActualCommand.Type + i, &ActualReply.Block[i]);
+		spi_releaseBus();
+	}
+
+	ActualReply.BlockLength = count;
+}
+
+// Motion segment queue of the StepDir channels
+// Type 0: Queue a move to the absolute position <value>
+// Type 1: Set the maximum velocity of the following segments
+// Type 2: Set the acceleration of the following segments
+// A full queue is answered with REPLY_DELAYED, the host has to send the segment again.
+static void queueSegment(void)
+{
+	uint8_t motor = ActualCommand.Motor;
+
+	if(motor >= STEP_DIR_CHANNELS)
+	{
+		setTMCLStatus(TMC_ERROR_MOTOR);
+		return;
+	}
+
+	switch(ActualCommand.Type)
+	{
+	case 0:
+	{
+		uint32_t velocity = (segmentVelocity[motor])? segmentVelocity[motor] : (uint32_t) StepDir_getVelocityMax(motor);
+		uint32_t acceleration = (segmentAcceleration[motor])? segmentAcceleration[motor] : StepDir_getAcceleration(motor);
+
+		if(acceleration == 0)
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		else if(!StepDir_queueSegment(motor, ActualCommand.Value.Int32, velocity, acceleration))
+			setTMCLStatus(TMC_ERROR_NOT_DONE);
+		break;
+	}
+	case 1:
+		if(ActualCommand.Value.Int32 < 0 || ActualCommand.Value.UInt32 > StepDir_getBaseFrequency())
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		else
+			segmentVelocity[motor] = ActualCommand.Value.UInt32;
+		break;
+	case 2:
+		if(ActualCommand.Value.Int32 < 0)
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		else
+			segmentAcceleration[motor] = ActualCommand.Value.UInt32;
+		break;
+	default:
+		ActualReply.Status = REPLY_INVALID_TYPE;
+		break;
+	}
+}
+
+// Type 0: Free entries, Type 1: Queued entries, Type 2: Clear the queue
+static void queueInfo(void)
+{
+	uint8_t motor = ActualCommand.Motor;
+
+	if(motor >= STEP_DIR_CHANNELS)
+	{
+		setTMCLStatus(TMC_ERROR_MOTOR);
+		return;
+	}
+
+	switch(ActualCommand.Type)
+	{
+	case 0:
+		ActualReply.Value.Int32 = StepDir_getFreeSegments(motor);
+		break;
+	case 1:
+		ActualReply.Value.Int32 = STEPDIR_SEGMENT_QUEUE_SIZE - StepDir_getFreeSegments(motor);
+		break;
+	case 2:
+		StepDir_clearSegments(motor);
+		break;
+	default:
+		ActualReply.Status = REPLY_INVALID_TYPE;
+		break;
+	}
+}
+
+/*
+ * Telemetry subscription: instead of polling, the host registers up to TMCL_TELEMETRY_SOURCES
+ * sources and a period. The module then pushes one frame per period on the interface that
+ * started the telemetry. A frame is one REPLY_TELEMETRY_FRAME datagram with the timestamp [ms]
+ * followed by one REPLY_TELEMETRY_SAMPLE datagram per source in the order they were added.
+ * Samples that could not be read are sent with REPLY_CHIP_READ_FAILED and value 0.
+ * Frames not fitting into the tx buffer are dropped as a whole and counted.
+ *
+ * Type 0: Stop and clear all sources
+ * Type 1: Add axis parameter <value> of <motor> on ch1
+ * Type 2: Add axis parameter <value> of <motor> on ch2
+ * Type 3: Add register <value> of <motor> on ch1
+ * Type 4: Add register <value> of <motor> on ch2
+ * Type 5: Add input <value> (types of TMCL_GIO, e.g. 5: VM)
+ * Type 6: Start with period <value> [ms] on this interface, 0 stops. Resets the drop counter
+ * Type 7: Dropped frames
+ * Adding replies the number of sources.
+ */
+static void telemetry(void)
+{
+	int32_t value;
+
+	switch(ActualCommand.Type)
+	{
+	case 0:
+		telemetryPeriod = 0;
+		telemetrySourceCount = 0;
+		break;
+	case 1:
+	case 2:
+	case 3:
+	case 4:
+	case 5: // Type - 1 is the TelemetrySourceType
+		if(ActualCommand.Value.UInt32 > 0xFF)
+		{
+			ActualReply.Status = REPLY_INVALID_VALUE;
+			break;
+		}
+		if(ActualCommand.Type - 1 == TELEMETRY_INPUT && !readInput(ActualCommand.Value.UInt32, &value))
+		{
+			ActualReply.Status = REPLY_INVALID_VALUE;
+			break;
+		}
+		if(telemetrySourceCount >= TMCL_TELEMETRY_SOURCES)
+		{
+			ActualReply.Status = REPLY_MAX_EXCEEDED;
+			break;
+		}
+
+		telemetrySources[telemetrySourceCount].type   = ActualCommand.Type - 1;
+		telemetrySources[telemetrySourceCount].motor  = ActualCommand.Motor;
+		telemetrySources[telemetrySourceCount].index  = ActualCommand.Value.UInt32;
+		telemetrySourceCount++;
+		ActualReply.Value.Int32 = telemetrySourceCount;
+		break;
+	case 6:
+		if(ActualCommand.Value.UInt32 > TMCL_TELEMETRY_PERIOD_MAX)
+		{
+			ActualReply.Status = REPLY_INVALID_VALUE;
+			break;
+		}
+		telemetryPeriod     = ActualCommand.Value.UInt32;
+		telemetryInterface  = currentInterface;
+		telemetryLast       = systick_getTick();
+		telemetryDropped    = 0;
+		break;
+	case 7:
+		ActualReply.Value.UInt32 = telemetryDropped;
+		break;
+	default:
+		ActualReply.Status = REPLY_INVALID_TYPE;
+		break;
+	}
+}
+
+// Pushes the telemetry frame when the period is over - called from the main loop via tmcl_process()
+static void telemetryProcess(void)
+{
+	if(telemetryPeriod == 0 || telemetrySourceCount == 0)
+		return;
+
+	uint32_t now = systick_getTick();
+	if(now - telemetryLast < telemetryPeriod)
+		return;
+
+	// Keep the frames on the period grid, but do not catch up after a blocked main loop
+	telemetryLast += telemetryPeriod;
+	if(now - telemetryLast >= telemetryPeriod)
+		telemetryLast = now;
+
+	RXTXTypeDef *RXTX = &interfaces[telemetryInterface];
+	if(RXTX->bytesFree() < 9u * (1 + telemetrySourceCount))
+	{
+		telemetryDropped++;
+		return;
+	}
+
+	txDatagram(RXTX, REPLY_TELEMETRY_FRAME, TMCL_Telemetry, now);
+
+	for(uint8_t i = 0; i < telemetrySourceCount; i++)
+	{
+		TelemetrySource *source = &telemetrySources[i];
+		uint8_t status = REPLY_TELEMETRY_SAMPLE;
+		int32_t value = 0;
+
+		spi_acquireBus();
+		switch(source->type)
+		{
+		case TELEMETRY_AXIS_PARAMETER_CH1:
+			if(Evalboards.ch1.GAP(source->index, source->motor, &value) != TMC_ERROR_NONE)
+				status = REPLY_CHIP_READ_FAILED;
+			break;
+		case TELEMETRY_AXIS_PARAMETER_CH2:
+			if(Evalboards.ch2.GAP(source->index, source->motor, &value) != TMC_ERROR_NONE)
+				status = REPLY_CHIP_READ_FAILED;
+			break;
+		case TELEMETRY_REGISTER_CH1:
+			if(VitalSignsMonitor.brownOut & VSM_ERRORS_BROWNOUT_CH1)
+				status = REPLY_CHIP_READ_FAILED;
+			else
+				Evalboards.ch1.readRegister(source->motor, source->index, &value);
+			break;
+		case TELEMETRY_REGISTER_CH2:
+			if(VitalSignsMonitor.brownOut & VSM_ERRORS_BROWNOUT_CH2)
+				status = REPLY_CHIP_READ_FAILED;
+			else
+				Evalboards.ch2.readRegister(source->motor, source->index, &value);
+			break;
+		case TELEMETRY_INPUT:
+			readInput(source->index, &value);
+			break;
+		}
+		spi_releaseBus();
+
+		if(status != REPLY_TELEMETRY_SAMPLE)
+			value = 0;
+
+		txDatagram(RXTX, status, TMCL_Telemetry, value);
+	}
+}
+
+/*
+ * RAM debug capture, see RAMDebug.c
+ *
+ * Type 0:  Stop and reset the configuration
+ * Type 1:  Set the sample count <value> (values of all channels together)
+ * Type 2:  Set the sample frequency <value> [Hz], limited by the register channels (info 6)
+ * Type 3:  Add a channel of type <motor> with channel value <value> (see RAMDebugChannelType)
+ * Type 4:  Set the trigger channel to type <motor> with channel value <value>
+ * Type 5:  Set the trigger mask <value> and shift <motor>
+ * Type 6:  Start the capture with trigger type <motor> (see RAMDebugTrigger) and threshold <value>
+ * Type 7:  State (see RAMDebugState)
+ * Type 8:  Captured values from index <value> on. <motor> 0: One value, 1 ... TMCL_REGISTER_BLOCK_MAX:
+ *          One regular reply per value
+ * Type 9:  Info <value> (see RAMDebugInfo)
+ * Type 10: Type of channel <value>
+ * Type 11: Channel value of channel <value>
+ * Type 12: Set the pretrigger count <value> (values of all channels together)
+ */
+static void ramDebug(void)
+{
+	uint32_t count, value;
+	RAMDebugChannelType type;
+
+	switch(ActualCommand.Type)
+	{
+	case 0:
+		RAMDebug_init();
+		break;
+	case 1:
+		if(!RAMDebug_setSampleCount(ActualCommand.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 2:
+		if(!RAMDebug_setFrequency(ActualCommand.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 3:
+		if(!RAMDebug_addChannel(ActualCommand.Motor, ActualCommand.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 4:
+		if(!RAMDebug_setTriggerChannel(ActualCommand.Motor, ActualCommand.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 5:
+		RAMDebug_setTriggerMaskShift(ActualCommand.Value.UInt32, ActualCommand.Motor);
+		break;
+	case 6:
+		if(!RAMDebug_enableTrigger(ActualCommand.Motor, ActualCommand.Value.Int32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 7:
+		ActualReply.Value.Int32 = RAMDebug_getState();
+		break;
+	case 8:
+		if(RAMDebug_getState() != RAMDEBUG_COMPLETE)
+		{
+			setTMCLStatus(TMC_ERROR_NOT_DONE);
+			break;
+		}
+
+		count = MAX(ActualCommand.Motor, 1);
+		RAMDebug_getInfo(RAMDEBUG_INFO_SAMPLE_COUNT, &value);
+		if(count > TMCL_REGISTER_BLOCK_MAX || ActualCommand.Value.UInt32 >= value || count > value - ActualCommand.Value.UInt32)
+		{
+			ActualReply.Status = REPLY_MAX_EXCEEDED;
+			break;
+		}
+
+		if(ActualCommand.Motor == 0)
+		{
+			RAMDebug_getSample(ActualCommand.Value.UInt32, &ActualReply.Value.Int32);
+			break;
+		}
+
+		for(uint32_t i = 0; i < count; i++)
+			RAMDebug_getSample(ActualCommand.Value.UInt32 + i, &ActualReply.Block[i]);
+		ActualReply.BlockLength = count;
+		break;
+	case 9:
+		if(!RAMDebug_getInfo(ActualCommand.Value.UInt32, &ActualReply.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	case 10:
+	case 11:
+		if(ActualCommand.Value.UInt32 > 0xFF || !RAMDebug_getChannel(ActualCommand.Value.UInt32, &type, &value))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		else
+			ActualReply.Value.UInt32 = (ActualCommand.Type == 10) ? (uint32_t) type : value;
+		break;
+	case 12:
+		if(!RAMDebug_setPretriggerCount(ActualCommand.Value.UInt32))
+			ActualReply.Status = REPLY_INVALID_VALUE;
+		break;
+	default:
+		ActualReply.Status = REPLY_INVALID_TYPE;
+		break;
+	}
+}
+
+// Type 0: Disable extended frames on this interface, Type 1: Enable them.
+// Both reply the maximum request payload length.
+// Type 2: Maximum reply payload length
+static void extendedFrames(void)
+{
+	switch(ActualCommand.Type)
+	{
+	case 0:
+	case 1:
+		frameStates[currentInterface].enabled   = ActualCommand.Type;
+		frameStates[currentInterface].received  = 0;
+		ActualReply.Value.Int32 = TMCL_FRAME_REQUEST_MAX;
+		break;
+	case 2:
+		ActualReply.Value.Int32 = TMCL_FRAME_REPLY_MAX;
+		break;
+	default:
+		ActualReply.Status = REPLY_INVALID_TYPE;
+		break;
+	}
+}
+
 static void boardsErrors(void)
 {
 	switch(ActualCommand.Type)
@@ -904,33 +1862,40 @@ static void GetVersion(void)
 
 static void GetInput(void)
 {
-	switch(ActualCommand.Type)
+	if(!readInput(ActualCommand.Type, &ActualReply.Value.Int32))
+		ActualReply.Status = REPLY_INVALID_TYPE;
+}
+
+// Returns false for unknown input types
+static bool readInput(uint8_t type, int32_t *value)
+{
+	switch(type)
 	{
 	case 0:
-		ActualReply.Value.Int32 = *HAL.ADCs->AIN0;
+		*value = *HAL.ADCs->AIN0;
 		break;
 	case 1:
-		ActualReply.Value.Int32 = *HAL.ADCs->AIN1;
+		*value = *HAL.ADCs->AIN1;
 		break;
 	case 2:
-		ActualReply.Value.Int32 = *HAL.ADCs->AIN2;
+		*value = *HAL.ADCs->AIN2;
 		break;
 	case 3:
-		ActualReply.Value.Int32 = *HAL.ADCs->DIO4;
+		*value = *HAL.ADCs->DIO4;
 		break;
 	case 4:
-		ActualReply.Value.Int32 = *HAL.ADCs->DIO5;
+		*value = *HAL.ADCs->DIO5;
 		break;
 	case 5:
-		ActualReply.Value.Int32 = VitalSignsMonitor.VM;
+		*value = VitalSignsMonitor.VM;
 		break;
 	case 6:	// Raw VM ADC value, no scaling calculation done // todo QOL 2: Switch this case with case 5? That way we have the raw Values from 0-5, then 6 for scaled VM value. Requires IDE changes (LH)
-		ActualReply.Value.Int32 = *HAL.ADCs->VM;
+		*value = *HAL.ADCs->VM;
 		break;
 	default:
-		ActualReply.Status = REPLY_INVALID_TYPE;
-		break;
+		return false;
 	}
+	return true;
 }
 
 static void HandleWlanCommand(void)